@@ -1,7 +1,9 @@
 
 #include "AllLoci.h"
+#include "Profiler.h"
 
 #include "cassert"
+#include <algorithm>
 
 /*
     AllLoci constructor
@@ -16,7 +18,7 @@ AllLoci::AllLoci() : lociVector_(),
 
     //construct N locus embedded genealogy
     for (int locusID = 0; locusID < dataSetup.numLoci; ++locusID) {
-        lociVector_.emplace_back(locusID, MAX_EVENTS, &dataSetup, &dataState,
+        lociVector_.emplace_back(locusID, getMaxLocusEvents(), &dataSetup, &dataState,
                                  genetree_migs);
     }
 
@@ -138,3 +140,75 @@ LocusEmbeddedGenealogy& AllLoci::getLocus(int locusID) {
 vector<LocusEmbeddedGenealogy> & AllLoci::getLociVector()  {
     return lociVector_;
 }
+
+
+/*
+    reportLocusCosts
+    Aggregates per-locus cost counters (locus profiles and likelihood
+    cost counters of locus data) and writes them to a file, one line per
+    locus, sorted by decreasing time spent on locus. Prints the most
+    expensive loci and their share of total locus time to stdout.
+    Requires locus profiling to be on (see initLocusProfiles).
+    @param: name of report file, number of loci to print to stdout
+    @return: 0 if all OK, -1 if report file could not be opened
+*/
+int AllLoci::reportLocusCosts(const char *fileName, int numPrinted) {
+
+    int numLoci = lociVector_.size();
+    std::vector<int> order(numLoci);
+    long long totalTime = 0;
+    long long numNodeRecomputations, numPatternsProcessed, likelihoodTime;
+
+    //sort loci by decreasing time
+    for (int locusID = 0; locusID < numLoci; ++locusID) {
+        order[locusID] = locusID;
+        totalTime += locusProfiles[locusID].time;
+    }
+    std::stable_sort(order.begin(), order.end(), [](int a, int b) {
+        return locusProfiles[a].time > locusProfiles[b].time;
+    });
+
+    FILE *reportFile = fopen(fileName, "w");
+    if (reportFile == nullptr) {
+        fprintf(stderr, "Error: Could not open locus cost file %s.\n", fileName);
+        return -1;
+    }
+
+    fprintf(reportFile, "rank\tlocus\ttime_ns\ttime_share\tlikelihood_ns\t"
+                        "trace_lineage_ns\tnode_recomputations\t"
+                        "patterns_processed\tproposals\taccepted\tlive_patterns\t"
+                        "arena_bytes\n");
+    printf("===== MOST EXPENSIVE LOCI ======\n");
+    printf("%5s %8s %12s %7s %14s %14s %12s %8s\n", "rank", "locus",
+           "time (sec)", "share", "lnld (sec)", "trace (sec)",
+           "node recomp", "patterns");
+
+    for (int rank = 0; rank < numLoci; ++rank) {
+        int locusID = order[rank];
+        const LOCUS_PROFILE &profile = locusProfiles[locusID];
+        double share = (totalTime > 0) ? (double) profile.time / totalTime : 0.0;
+
+        getLocusDataCosts(dataState.lociData[locusID], &numNodeRecomputations,
+                          &numPatternsProcessed, &likelihoodTime);
+
+        fprintf(reportFile, "%d\t%d\t%lld\t%.6f\t%lld\t%lld\t%lld\t%lld\t%ld\t%ld\t%d\t%zu\n",
+                rank + 1, locusID + 1, profile.time, share, likelihoodTime,
+                profile.traceLineageTime, numNodeRecomputations,
+                numPatternsProcessed, profile.proposals, profile.accepted,
+                getLocusNumLivePatterns(dataState.lociData[locusID]),
+                getLocusArenaSize(locusID));
+
+        if (rank < numPrinted) {
+            printf("%5d %8d %12.3f %6.2f%% %14.3f %14.3f %12lld %8d\n",
+                   rank + 1, locusID + 1, profile.time * 1e-9, 100.0 * share,
+                   likelihoodTime * 1e-9, profile.traceLineageTime * 1e-9,
+                   numNodeRecomputations,
+                   getLocusNumLivePatterns(dataState.lociData[locusID]));
+        }
+    }
+
+    fclose(reportFile);
+    printf("Locus cost report for all %d loci written to %s.\n", numLoci, fileName);
+
+    return 0;
+}
@@ -17,6 +17,8 @@
  * Contains:
  * 1. Vector of LocusEmbeddedGenealogy objects.
  * 2. Object of total statistics.
+ *
+ * Also aggregates per-locus cost counters (see Profiler.h) into a report.
  *===========================================================================*/
 class AllLoci {
 
@@ -43,7 +45,8 @@ public:
     //test if all loci data are consistent with old version
     void testLoci();
 
-    //
+    //write per-locus cost report sorted by locus time, print top loci
+    int reportLocusCosts(const char *fileName, int numPrinted);
 
 
 };
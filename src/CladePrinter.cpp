@@ -17,17 +17,20 @@ void printSpecificCladeHeader(int clade, FILE *file) {
           cladeName, "num_coals_total");
 }
 
-void printCladeStats(int iteration, FILE *file) {
-  fprintf(file, "%d\t", iteration);
+void printCladeStats(int iteration, int stream) {
+  TRACE_RECORD *record = beginTraceRecord(stream, iteration);
   for (int clade = 0; clade < dataSetup.popTree->numPops; clade++) {
-    printSpecificCladeStats(clade, file);
+    printSpecificCladeStats(clade, record);
   }
-  fprintf(file, "\n");
-  fflush(file);
+  commitTraceRecord(stream);
+}
+
+int getMaxCladeStats() {
+  return dataSetup.popTree->numPops;
 }
 
-void printSpecificCladeStats(int clade, FILE *file) {
-  fprintf(file, "%0.35f\t%d\t",
-          clade_stats[clade].coal_stats_total,
-          clade_stats[clade].num_coals_total);
+void printSpecificCladeStats(int clade, TRACE_RECORD *record) {
+  addTraceStatPair(record,
+                   clade_stats[clade].coal_stats_total,
+                   clade_stats[clade].num_coals_total);
 }
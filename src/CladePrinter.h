@@ -2,6 +2,7 @@
 #define SRC_CLADEPRINTER_H_
 
 #include <stdio.h>
+#include "TraceWriter.h"
 
 void printCladeStatsHeader(FILE *file);
 
@@ -11,9 +12,11 @@ void printSpecificPopHeader(int pop, FILE *file);
 
 void printSpecificMigHeader(int mig_band, FILE *file);
 
-void printCladeStats(int iteration, FILE *file);
+void printCladeStats(int iteration, int stream);
 
-void printSpecificCladeStats(int clade, FILE *file);
+int getMaxCladeStats();
+
+void printSpecificCladeStats(int clade, TRACE_RECORD *record);
 
 void printSpecificPopStats(int pop, FILE *file);
 
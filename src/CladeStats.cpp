@@ -180,7 +180,7 @@ void addCurrentPopIntoCladeStats(int clade, int gen) {
 
 
 void allocateCladeMem() {
-  int max_events = 2 * dataSetup.numSamples + 4 * MAX_MIGS + 3 * dataSetup.popTree->numMigBands + dataSetup.popTree->numPops + 10;
+  int max_events = 2 * dataSetup.numSamples + 4 * dataSetup.maxMigs + 3 * dataSetup.popTree->numMigBands + dataSetup.popTree->numPops + 10;
   clade_stats = (CLADE_STATS *) malloc(dataSetup.popTree->numPops * sizeof(CLADE_STATS));
 
   for (int clade = 0; clade < dataSetup.popTree->numPops; clade++) {
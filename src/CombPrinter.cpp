@@ -49,42 +49,46 @@ void printCombMigHeaders(int comb, char *combName, FILE *file) {
 }
 
 
-void printCombStats(int iteration, FILE *file) {
+void printCombStats(int iteration, int stream) {
 
-  fprintf(file, "%d\t", iteration);
+  TRACE_RECORD *record = beginTraceRecord(stream, iteration);
   for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
     if (isFeasibleComb(comb)) {
-      printOneCombStats(comb, file);
+      printOneCombStats(comb, record);
     }
   }
-  fprintf(file, "\n");
-  fflush(file);
+  commitTraceRecord(stream);
+}
+
+int getMaxCombStats() {
+  return dataSetup.popTree->numPops *
+         (1 + dataSetup.popTree->numPops + dataSetup.popTree->numMigBands);
 }
 
-void printOneCombStats(int comb, FILE *file) {
-  fprintf(file, "%0.35f\t%d\t",  //TODO - turn float precision to a MACRO/CONST
-          comb_stats[comb].total.coal_stats,
-          comb_stats[comb].total.num_coals);
-  printCombCoalStats(comb, file);
-  printCombMigStats(comb, file);
+void printOneCombStats(int comb, TRACE_RECORD *record) {
+  addTraceStatPair(record,
+                   comb_stats[comb].total.coal_stats,
+                   comb_stats[comb].total.num_coals);
+  printCombCoalStats(comb, record);
+  printCombMigStats(comb, record);
 }
 
-void printCombCoalStats(int comb, FILE *file) {
+void printCombCoalStats(int comb, TRACE_RECORD *record) {
   for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
     if (isLeaf(pop) && isAncestralTo(comb, pop)) {
-      fprintf(file, "%0.35f\t%d\t",
-              comb_stats[comb].leaves[pop].below_comb.coal_stats,
-              comb_stats[comb].leaves[pop].below_comb.num_coals);
+      addTraceStatPair(record,
+                       comb_stats[comb].leaves[pop].below_comb.coal_stats,
+                       comb_stats[comb].leaves[pop].below_comb.num_coals);
     }
   }
 }
 
-void printCombMigStats(int comb, FILE *file) {
+void printCombMigStats(int comb, TRACE_RECORD *record) {
   for (int mig = 0; mig < dataSetup.popTree->numMigBands; mig++) {
     if (isCombLeafMigBand(mig, comb)) {
-      fprintf(file, "%0.35f\t%d\t",
-              comb_stats[comb].leafMigs[mig].mig_stats,
-              comb_stats[comb].leafMigs[mig].num_migs);
+      addTraceStatPair(record,
+                       comb_stats[comb].leafMigs[mig].mig_stats,
+                       comb_stats[comb].leafMigs[mig].num_migs);
     }
   }
 }
@@ -1,11 +1,14 @@
 #include <stdio.h>
+#include "TraceWriter.h"
 
 
 #ifndef SRC_COMBSTATSHEADER_H_
 #define SRC_COMBSTATSHEADER_H_
 
 
-void printCombStats(int iteration, FILE *file);
+void printCombStats(int iteration, int stream);
+
+int getMaxCombStats();
 
 void printCombStatsHeader(FILE *file);
 
@@ -16,11 +19,11 @@ void printCombPopHeaders(int comb, char *combName, FILE *file);
 void printCombMigHeaders(int comb, char *combName, FILE *file);
 
 
-void printOneCombStats(int clade, FILE *file);
+void printOneCombStats(int comb, TRACE_RECORD *record);
 
-void printCombCoalStats(int comb, FILE *file);
+void printCombCoalStats(int comb, TRACE_RECORD *record);
 
-void printCombMigStats(int comb, FILE *file);
+void printCombMigStats(int comb, TRACE_RECORD *record);
 
 #endif
 
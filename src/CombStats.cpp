@@ -9,56 +9,92 @@
 #include "CombStats.h"
 #include "McRefCommon.h"
 #include "CombAssertions.h"
+#include "MultiCoreUtils.h"
 
 COMB_STATS *comb_stats;
 
+/* loci are split into COMB_LOCUS_BLOCKS contiguous blocks (at most one block per
+ * locus). stats of each block are computed by a single thread in locus order
+ * and blocks are summed in block order, so stats do not depend on the number
+ * of threads.
+ */
+#define COMB_LOCUS_BLOCKS 64
+
+static COMB_STATS **comb_thread_stats;  // per-thread comb stats of current locus (with event arrays)
+static double *comb_block_sums;         // stats summed over each block of loci (numBlocks x comb_sum_stride)
+static int comb_sum_stride;             // number of summed stats per block
+static int comb_num_blocks;
+static int comb_num_threads;
+
 void calculateCombStats() {
-  initCombStats();
-  for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
-    if (isFeasibleComb(comb)) {
-      for (int gene = 0; gene < dataSetup.numLoci; gene++) {
-        calculateSufficientStats(comb, gene);
+  int numThreads;
+
+  setStartTimeMethod(T_CombStats);
+  initCombStats(comb_stats);
+  numThreads = min2(beginParallelMove(MOVE_COMB_STATS, dataSetup.numLoci), comb_num_threads);
+
+#pragma omp parallel for schedule(dynamic, 1) num_threads(numThreads) if(numThreads > 1)
+  for (int block = 0; block < comb_num_blocks; block++) {
+    COMB_STATS *combStats = comb_thread_stats[omp_get_thread_num()];
+    double *blockSums = comb_block_sums + block * comb_sum_stride;
+    int startLocus = (int) ((long) block * dataSetup.numLoci / comb_num_blocks);
+    int endLocus = (int) ((long) (block + 1) * dataSetup.numLoci / comb_num_blocks);
+
+    for (int i = 0; i < comb_sum_stride; i++) {
+      blockSums[i] = 0.0;
+    }
+    for (int gene = startLocus; gene < endLocus; gene++) {
+      initCombLocusStats(combStats, comb_stats);
+      for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
+        if (isFeasibleComb(comb)) {
+          calculateSufficientStats(combStats, comb, gene);
+        }
       }
+      addCombStatsToSums(combStats, blockSums);
     }
   }
+
+  for (int block = 0; block < comb_num_blocks; block++) {
+    addSumsToCombStats(comb_block_sums + block * comb_sum_stride, comb_stats);
+  }
+  setEndTimeMethod(T_CombStats);
   if (DEBUG_COMB_STATS) runAssertions();
 }
 
-void calculateSufficientStats(int comb, int gene) {
-  coalescence(comb, gene);
-  migrations(comb, gene);
-  finalizeCombCoalStats(comb);
+void calculateSufficientStats(COMB_STATS *combStats, int comb, int gene) {
+  coalescence(combStats, comb, gene);
+  migrations(combStats, comb, gene);
+  finalizeCombCoalStats(combStats, comb);
 }
 
-void coalescence(int comb, int gene) {
-  coalescence_rec(comb, comb, gene);
+void coalescence(COMB_STATS *combStats, int comb, int gene) {
+  coalescence_rec(combStats, comb, comb, gene);
 }
 
-void coalescence_rec(int comb, int currentPop, int gene) {
+void coalescence_rec(COMB_STATS *combStats, int comb, int currentPop, int gene) {
   if (isLeaf(currentPop)) {
-    handleLeafCoals(comb, currentPop, gene);
+    handleLeafCoals(combStats, comb, currentPop, gene);
   } else {
-    coalescence_rec(comb, getSon(currentPop, LEFT), gene);
-    coalescence_rec(comb, getSon(currentPop, RIGHT), gene);
+    coalescence_rec(combStats, comb, getSon(currentPop, LEFT), gene);
+    coalescence_rec(combStats, comb, getSon(currentPop, RIGHT), gene);
 
-    handleNonLeafCoals(comb, currentPop, gene);
+    handleNonLeafCoals(combStats, comb, currentPop, gene);
   }
 }
 
-void handleLeafCoals(int comb, int leaf, int gene) {
+void handleLeafCoals(COMB_STATS *combStats, int comb, int leaf, int gene) {
   double previousAge, eventAge = 0.0;
   int eventId;
-  double combAge = comb_stats[comb].age;
+  double combAge = combStats[comb].age;
 
-  EventChain chain = event_chains[gene];
-  Event event;
-  Stats *belowCombLeafStats = &comb_stats[comb].leaves[leaf].below_comb;
-  Stats *aboveCombLeafStats = &comb_stats[comb].leaves[leaf].above_comb;
-  Stats *combTotalStats = &comb_stats[comb].total;
+  const EventChain &chain = event_chains[gene];
+  Stats *belowCombLeafStats = &combStats[comb].leaves[leaf].below_comb;
+  Stats *aboveCombLeafStats = &combStats[comb].leaves[leaf].above_comb;
+  Stats *combTotalStats = &combStats[comb].total;
 
   eventId = chain.first_event[leaf];
   while (eventId >= 0) {
-    event = chain.events[eventId];
+    const Event &event = chain.events[eventId];
     previousAge = eventAge;
     eventAge += event.getElapsedTime();
 
@@ -77,7 +113,7 @@ void handleLeafCoals(int comb, int leaf, int gene) {
   combTotalStats->num_events += aboveCombLeafStats->num_events;
 }
 
-void countCoalEventTowardsBelowComb(Event event, Stats *belowCombLeafStats) {
+void countCoalEventTowardsBelowComb(const Event &event, Stats *belowCombLeafStats) {
   if (event.getType() == COAL) belowCombLeafStats->num_coals++;
   double elapsedTime = event.getElapsedTime();
   int numLins = event.getNumLineages();
@@ -85,7 +121,7 @@ void countCoalEventTowardsBelowComb(Event event, Stats *belowCombLeafStats) {
 }
 
 void
-countCoalEventTowardsHalfAndHalf(Event event, double eventAge, double previousAge, double combAge, Stats *belowCombLeafStats, Stats *aboveCombLeafStats, Stats *combTotalStats) {
+countCoalEventTowardsHalfAndHalf(const Event &event, double eventAge, double previousAge, double combAge, Stats *belowCombLeafStats, Stats *aboveCombLeafStats, Stats *combTotalStats) {
   double pseudoEventAge, pseudoElapsedTimeBelow, pseudoElapsedTimeAbove;
   EventType pseudoEventType;
   int eventId = event.getId();
@@ -120,7 +156,7 @@ countCoalEventTowardsHalfAndHalf(Event event, double eventAge, double previousAg
   aboveCombLeafStats->num_events = 1;
 }
 
-void countCoalEventTowardsAboveComb(Event event, double eventAge, Stats *aboveCombLeafStats, Stats *combTotalStats) {
+void countCoalEventTowardsAboveComb(const Event &event, double eventAge, Stats *aboveCombLeafStats, Stats *combTotalStats) {
   EventType eventType = event.getType();
   int numEventsAboveComb = aboveCombLeafStats->num_events;
 
@@ -138,28 +174,28 @@ void countCoalEventTowardsAboveComb(Event event, double eventAge, Stats *aboveCo
   aboveCombLeafStats->num_events += 1;
 }
 
-void handleNonLeafCoals(int comb, int currentPop, int gene) {
-  handleNonLeafNumCoals(comb, currentPop, gene);
-  handleNonLeafCoalStats(comb, currentPop, gene);
+void handleNonLeafCoals(COMB_STATS *combStats, int comb, int currentPop, int gene) {
+  handleNonLeafNumCoals(combStats, comb, currentPop, gene);
+  handleNonLeafCoalStats(combStats, comb, currentPop, gene);
 }
 
-void handleNonLeafNumCoals(int comb, int currentPop, int gene) {
-  comb_stats[comb].total.num_coals += genetree_stats[gene].num_coals[currentPop];
+void handleNonLeafNumCoals(COMB_STATS *combStats, int comb, int currentPop, int gene) {
+  combStats[comb].total.num_coals += genetree_stats[gene].num_coals[currentPop];
 }
 
-void handleNonLeafCoalStats(int comb, int currentPop, int gene) {
-  mergeChildrenIntoCurrent(comb, currentPop);
-  appendCurrent(comb, currentPop, gene); // start filling the comb_stats arrays from the last known event
+void handleNonLeafCoalStats(COMB_STATS *combStats, int comb, int currentPop, int gene) {
+  mergeChildrenIntoCurrent(combStats, comb, currentPop);
+  appendCurrent(combStats, comb, currentPop, gene); // start filling the comb_stats arrays from the last known event
 }
 
-void mergeChildrenIntoCurrent(int comb, int currentPop) {
+void mergeChildrenIntoCurrent(COMB_STATS *combStats, int comb, int currentPop) {
   int i, j = 0, k = 0;
   double leftAge, rightAge;
   Stats *leftStats, *rightStats, *currentStats;
 
-  currentStats = getCombPopStats(comb, currentPop);
-  leftStats = getCombPopStats(comb, getSon(currentPop, LEFT));
-  rightStats = getCombPopStats(comb, getSon(currentPop, RIGHT));
+  currentStats = getCombPopStats(combStats, comb, currentPop);
+  leftStats = getCombPopStats(combStats, comb, getSon(currentPop, LEFT));
+  rightStats = getCombPopStats(combStats, comb, getSon(currentPop, RIGHT));
 
 
   int m = leftStats->num_events;
@@ -208,9 +244,9 @@ void copyStaticEventStats(Stats *sourceStats, int n, Stats *targetStats, int m)
   targetStats->sorted_ages[m] = sourceStats->sorted_ages[n];
 }
 
-void appendCurrent(int comb, int currentPop, int gene) {
-  Stats *currentStats = getCombPopStats(comb, currentPop);
-  EventChain chain = event_chains[gene];
+void appendCurrent(COMB_STATS *combStats, int comb, int currentPop, int gene) {
+  Stats *currentStats = getCombPopStats(combStats, comb, currentPop);
+  const EventChain &chain = event_chains[gene];
 
   int startingPoint = currentStats->num_events;
   int i = startingPoint;
@@ -229,18 +265,18 @@ void appendCurrent(int comb, int currentPop, int gene) {
   currentStats->num_events = i;
 }
 
-void finalizeCombCoalStats(int comb) {
-  double *elapsedTimes = comb_stats[comb].combs[comb].elapsed_times;
-  int *numLineages = comb_stats[comb].combs[comb].num_lineages;
-  int size = comb_stats[comb].combs[comb].num_events;
-  comb_stats[comb].total.coal_stats += calculateCoalStats(elapsedTimes, numLineages, size);
+void finalizeCombCoalStats(COMB_STATS *combStats, int comb) {
+  double *elapsedTimes = combStats[comb].combs[comb].elapsed_times;
+  int *numLineages = combStats[comb].combs[comb].num_lineages;
+  int size = combStats[comb].combs[comb].num_events;
+  combStats[comb].total.coal_stats += calculateCoalStats(elapsedTimes, numLineages, size);
 }
 
-void migrations(int comb, int gene) {
+void migrations(COMB_STATS *combStats, int comb, int gene) {
   for (int migband = 0; migband < dataSetup.popTree->numMigBands; migband++) {
     if (isMigOfComb(migband, comb)) {
       if (isCombLeafMigBand(migband, comb)) {
-        handleCombLeavesMigBand(comb, migband, gene);
+        handleCombLeavesMigBand(combStats, comb, migband, gene);
       }
       if (isMigBandInternal(migband, comb)) {
         // ignore internal migbands. their stats aren't used
@@ -252,18 +288,17 @@ void migrations(int comb, int gene) {
 }
 
 
-void handleCombLeavesMigBand(int comb, int mig, int gene) {
+void handleCombLeavesMigBand(COMB_STATS *combStats, int comb, int mig, int gene) {
   double previousAge, eventAge = 0.0;
-  double combAge = comb_stats[comb].age;
+  double combAge = combStats[comb].age;
 
-  EventChain chain = event_chains[gene];
-  Event event;
+  const EventChain &chain = event_chains[gene];
 
-  MigStats *leafMigStats = comb_stats[comb].leafMigs;
+  MigStats *leafMigStats = combStats[comb].leafMigs;
 
   int target = getTargetPop(mig);
   for (int eventId = chain.first_event[target]; eventId > 0; eventId = chain.events[eventId].getNextIdx()) {
-    event = chain.events[eventId];
+    const Event &event = chain.events[eventId];
     previousAge = eventAge;
     eventAge += event.getElapsedTime();
 
@@ -280,14 +315,14 @@ void handleCombLeavesMigBand(int comb, int mig, int gene) {
   }
 }
 
-void countMigEventTowardsBelowComb(Event event, MigStats *leafMigStats) {
+void countMigEventTowardsBelowComb(const Event &event, MigStats *leafMigStats) {
   if (event.getType() == IN_MIG) leafMigStats->num_migs++;
   double elapsedTime = event.getElapsedTime();
   int numLins = event.getNumLineages();
   leafMigStats->mig_stats += (numLins) * elapsedTime;
 }
 
-void countMigEventTowardsHalfAndHalf(Event event, double eventAge, double previousAge, double combAge, MigStats *leafMigStats) {
+void countMigEventTowardsHalfAndHalf(const Event &event, double eventAge, double previousAge, double combAge, MigStats *leafMigStats) {
   double pseudoEventAge, pseudoElapsedTimeBelow, pseudoElapsedTimeAbove;
   int numLins = event.getNumLineages();
   EventType eventType = event.getType();
@@ -306,7 +341,7 @@ void countMigEventTowardsHalfAndHalf(Event event, double eventAge, double previo
   }
 }
 
-void countMigEventTowardsAboveComb(Event event, MigStats *leafMigStats) {
+void countMigEventTowardsAboveComb(const Event &event, MigStats *leafMigStats) {
 
   if (event.getType() == IN_MIG) leafMigStats->num_migs_above++;
   double elapsedTime = event.getElapsedTime();
@@ -314,30 +349,44 @@ void countMigEventTowardsAboveComb(Event event, MigStats *leafMigStats) {
   leafMigStats->mig_stats_above += numLins * elapsedTime;
 }
 
-Stats *getCombPopStats(int comb, int pop) {
+Stats *getCombPopStats(COMB_STATS *combStats, int comb, int pop) {
   if (isLeaf(pop)) {
-    return &comb_stats[comb].leaves[pop].above_comb;
+    return &combStats[comb].leaves[pop].above_comb;
   } else {
-    return &comb_stats[comb].combs[pop];
+    return &combStats[comb].combs[pop];
   }
 }
 
-void initCombStats() {
-  initPopStats();
-  initMigStats();
+void initCombStats(COMB_STATS *combStats) {
+  initPopStats(combStats);
+  initMigStats(combStats);
+  for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
+    if (isFeasibleComb(comb)) {
+      combStats[comb].age = getCombAge(comb);
+    }
+  }
 }
 
-void initPopStats() {
+void initCombLocusStats(COMB_STATS *combStats, COMB_STATS *ageStats) {
+  initPopStats(combStats);
+  initMigStats(combStats);
+  for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
+    if (isFeasibleComb(comb)) {
+      combStats[comb].age = ageStats[comb].age;
+    }
+  }
+}
+
+void initPopStats(COMB_STATS *combStats) {
   for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
     if (!isLeaf(comb)) {
-      initStats(&comb_stats[comb].total);
-      comb_stats[comb].age = getCombAge(comb);
+      initStats(&combStats[comb].total);
       for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
         if (isLeaf(pop)) {
-          initStats(&comb_stats[comb].leaves[pop].above_comb);
-          initStats(&comb_stats[comb].leaves[pop].below_comb);
+          initStats(&combStats[comb].leaves[pop].above_comb);
+          initStats(&combStats[comb].leaves[pop].below_comb);
         } else {
-          initStats(&comb_stats[comb].combs[pop]);
+          initStats(&combStats[comb].combs[pop]);
         }
       }
     }
@@ -350,51 +399,154 @@ void initStats(Stats *stats) {
   stats->num_events = 0;
 }
 
-void initMigStats() {
+void initMigStats(COMB_STATS *combStats) {
+  for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
+    if (isFeasibleComb(comb)) {
+      for (int mig = 0; mig < dataSetup.popTree->numMigBands; mig++) {
+        if (isMigOfComb(mig, comb)) {
+          combStats[comb].leafMigs[mig].mig_stats = 0.0;
+          combStats[comb].leafMigs[mig].num_migs = 0;
+          combStats[comb].leafMigs[mig].mig_stats_above = 0.0;
+          combStats[comb].leafMigs[mig].num_migs_above = 0;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Adds the summed stats of combStats (the stats of a single locus) to sums, in the
+ * order given by countCombSums. Event arrays are not summed.
+ */
+void addCombStatsToSums(COMB_STATS *combStats, double *sums) {
+  int i = 0;
+  for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
+    if (isFeasibleComb(comb)) {
+      sums[i++] += combStats[comb].total.num_coals;
+      sums[i++] += combStats[comb].total.coal_stats;
+      sums[i++] += combStats[comb].total.num_events;
+      for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
+        if (isLeaf(pop)) {
+          sums[i++] += combStats[comb].leaves[pop].above_comb.num_coals;
+          sums[i++] += combStats[comb].leaves[pop].above_comb.coal_stats;
+          sums[i++] += combStats[comb].leaves[pop].below_comb.num_coals;
+          sums[i++] += combStats[comb].leaves[pop].below_comb.coal_stats;
+        }
+      }
+      for (int mig = 0; mig < dataSetup.popTree->numMigBands; mig++) {
+        if (isMigOfComb(mig, comb)) {
+          sums[i++] += combStats[comb].leafMigs[mig].num_migs;
+          sums[i++] += combStats[comb].leafMigs[mig].mig_stats;
+          sums[i++] += combStats[comb].leafMigs[mig].num_migs_above;
+          sums[i++] += combStats[comb].leafMigs[mig].mig_stats_above;
+        }
+      }
+    }
+  }
+}
+
+/**
+ * Adds sums (filled by addCombStatsToSums) to the summed stats of combStats.
+ */
+void addSumsToCombStats(double *sums, COMB_STATS *combStats) {
+  int i = 0;
   for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
     if (isFeasibleComb(comb)) {
+      combStats[comb].total.num_coals += (int) sums[i++];
+      combStats[comb].total.coal_stats += sums[i++];
+      combStats[comb].total.num_events += (int) sums[i++];
+      for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
+        if (isLeaf(pop)) {
+          combStats[comb].leaves[pop].above_comb.num_coals += (int) sums[i++];
+          combStats[comb].leaves[pop].above_comb.coal_stats += sums[i++];
+          combStats[comb].leaves[pop].below_comb.num_coals += (int) sums[i++];
+          combStats[comb].leaves[pop].below_comb.coal_stats += sums[i++];
+        }
+      }
       for (int mig = 0; mig < dataSetup.popTree->numMigBands; mig++) {
         if (isMigOfComb(mig, comb)) {
-          comb_stats[comb].leafMigs[mig].mig_stats = 0.0;
-          comb_stats[comb].leafMigs[mig].num_migs = 0;
-          comb_stats[comb].leafMigs[mig].mig_stats_above = 0.0;
-          comb_stats[comb].leafMigs[mig].num_migs_above = 0;
+          combStats[comb].leafMigs[mig].num_migs += (int) sums[i++];
+          combStats[comb].leafMigs[mig].mig_stats += sums[i++];
+          combStats[comb].leafMigs[mig].num_migs_above += (int) sums[i++];
+          combStats[comb].leafMigs[mig].mig_stats_above += sums[i++];
         }
       }
     }
   }
 }
 
+/**
+ * Returns the number of summed stats of all feasible combs (see addCombStatsToSums).
+ */
+int countCombSums() {
+  int count = 0;
+  for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
+    if (isFeasibleComb(comb)) {
+      count += 3;
+      for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
+        if (isLeaf(pop)) count += 4;
+      }
+      for (int mig = 0; mig < dataSetup.popTree->numMigBands; mig++) {
+        if (isMigOfComb(mig, comb)) count += 4;
+      }
+    }
+  }
+  return count;
+}
+
 void allocateCombMem() {
-  comb_stats = (COMB_STATS *) malloc(dataSetup.popTree->numPops * sizeof(COMB_STATS));
+  comb_stats = allocateCombStats();
 
-  allocatePopsMem();
-  allocateMigBandsMem();
+  // a workspace for each thread, and sums for each block of loci
+  comb_num_threads = omp_get_max_threads();
+  comb_thread_stats = (COMB_STATS **) malloc(comb_num_threads * sizeof(COMB_STATS *));
+  if (comb_thread_stats == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory comb_stats\n");
+    exit(-1);
+  }
+  for (int thread = 0; thread < comb_num_threads; thread++) {
+    comb_thread_stats[thread] = allocateCombStats();
+  }
+  comb_num_blocks = min2(dataSetup.numLoci, COMB_LOCUS_BLOCKS);
+  comb_sum_stride = countCombSums();
+  comb_block_sums = (double *) malloc(comb_num_blocks * comb_sum_stride * sizeof(double));
+  if (comb_block_sums == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory comb_stats\n");
+    exit(-1);
+  }
+}
+
+COMB_STATS *allocateCombStats() {
+  COMB_STATS *combStats = (COMB_STATS *) malloc(dataSetup.popTree->numPops * sizeof(COMB_STATS));
+  if (combStats == nullptr) {
+    // TODO - add memory allocation test for all of comb_stats
+    fprintf(stderr, "\nError: Out Of Memory comb_stats\n");
+    exit(-1);
+  }
+
+  allocatePopsMem(combStats);
+  allocateMigBandsMem(combStats);
+  return combStats;
 }
 
-void allocatePopsMem() {
+void allocatePopsMem(COMB_STATS *combStats) {
   for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
-    allocateStats(&comb_stats[comb].total);
-    comb_stats[comb].leaves = (LeafStats *) malloc(dataSetup.popTree->numPops * sizeof(LeafStats));
-    comb_stats[comb].combs = (Stats *) malloc(dataSetup.popTree->numPops * sizeof(Stats));
+    allocateStats(&combStats[comb].total);
+    combStats[comb].leaves = (LeafStats *) malloc(dataSetup.popTree->numPops * sizeof(LeafStats));
+    combStats[comb].combs = (Stats *) malloc(dataSetup.popTree->numPops * sizeof(Stats));
     for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
       if (isLeaf(pop)) {
-        allocateStats(&comb_stats[comb].leaves[pop].below_comb);
-        allocateStats(&comb_stats[comb].leaves[pop].above_comb);
+        allocateStats(&combStats[comb].leaves[pop].below_comb);
+        allocateStats(&combStats[comb].leaves[pop].above_comb);
       } else {
-        allocateStats(&comb_stats[comb].combs[pop]);
+        allocateStats(&combStats[comb].combs[pop]);
       }
     }
-    if (comb_stats == nullptr) {
-      // TODO - add memory allocation test for all of comb_stats
-      fprintf(stderr, "\nError: Out Of Memory comb_stats\n");
-      exit(-1);
-    }
   }
 }
 
 void allocateStats(Stats *stats) {
-  int max_events = 2 * dataSetup.numSamples + 4 * MAX_MIGS + 3 * dataSetup.popTree->numMigBands + dataSetup.popTree->numPops + 10;
+  int max_events = 2 * dataSetup.numSamples + 4 * dataSetup.maxMigs + 3 * dataSetup.popTree->numMigBands + dataSetup.popTree->numPops + 10;
   stats->sorted_ages = (double *) malloc(max_events * sizeof(double));
   stats->elapsed_times = (double *) malloc(max_events * sizeof(double));
   stats->num_lineages = (int *) malloc(max_events * sizeof(int));
@@ -402,11 +554,11 @@ void allocateStats(Stats *stats) {
   stats->event_ids = (int *) malloc(max_events * sizeof(int));
 }
 
-void allocateMigBandsMem() {
+void allocateMigBandsMem(COMB_STATS *combStats) {
   int maxMigBands = dataSetup.popTree->numMigBands;
   for (int comb = 0; comb < dataSetup.popTree->numPops; comb++) {
     if (isFeasibleComb(comb)) {
-      comb_stats[comb].leafMigs = (MigStats *) malloc(maxMigBands * sizeof(MigStats));
+      combStats[comb].leafMigs = (MigStats *) malloc(maxMigBands * sizeof(MigStats));
     }
   }
 }
@@ -38,21 +38,21 @@ typedef struct _COMB_STATS {
     MigStats *leafMigs;
 } COMB_STATS;
 
-extern COMB_STATS *comb_stats;
+extern COMB_STATS *comb_stats;  // comb stats summed over all loci
 
 
 // clade_stats calculation functions
 void calculateCombStats();
 
-void finalizeCombCoalStats(int comb);
+void finalizeCombCoalStats(COMB_STATS *combStats, int comb);
 
-void calculateSufficientStats(int comb, int gene);
+void calculateSufficientStats(COMB_STATS *combStats, int comb, int gene);
 
-void coalescence(int comb, int gene);
+void coalescence(COMB_STATS *combStats, int comb, int gene);
 
-void coalescence_rec(int comb, int currentPop, int gene);
+void coalescence_rec(COMB_STATS *combStats, int comb, int currentPop, int gene);
 
-void handleLeafCoals(int comb, int leaf, int gene);
+void handleLeafCoals(COMB_STATS *combStats, int comb, int leaf, int gene);
 
 bool isEventCompletelyBelowComb(double eventAge, double combAge);
 
@@ -60,51 +60,61 @@ bool isBorderEvent(double eventAge, double previousAge, double combAge);
 
 bool isEventCompletelyInsideComb(double eventAge, double combAge);
 
-void countCoalEventTowardsBelowComb(Event event, Stats *belowCombLeafStats);
+void countCoalEventTowardsBelowComb(const Event &event, Stats *belowCombLeafStats);
 
-void countCoalEventTowardsHalfAndHalf(Event event, double eventAge, double previousAge, double combAge, Stats *belowCombLeafStats, Stats *aboveCombLeafStats, Stats *combTotalStats);
+void countCoalEventTowardsHalfAndHalf(const Event &event, double eventAge, double previousAge, double combAge, Stats *belowCombLeafStats, Stats *aboveCombLeafStats, Stats *combTotalStats);
 
-void countCoalEventTowardsAboveComb(Event event, double eventAge, Stats *aboveCombLeafStats, Stats *combTotalStats);
+void countCoalEventTowardsAboveComb(const Event &event, double eventAge, Stats *aboveCombLeafStats, Stats *combTotalStats);
 
 
-void handleNonLeafCoals(int comb, int currentPop, int gene);
+void handleNonLeafCoals(COMB_STATS *combStats, int comb, int currentPop, int gene);
 
-void handleNonLeafNumCoals(int comb, int currentPop, int gene);
+void handleNonLeafNumCoals(COMB_STATS *combStats, int comb, int currentPop, int gene);
 
-void handleNonLeafCoalStats(int comb, int currentPop, int gene);
+void handleNonLeafCoalStats(COMB_STATS *combStats, int comb, int currentPop, int gene);
 
-void mergeChildrenIntoCurrent(int comb, int currentPop);
+void mergeChildrenIntoCurrent(COMB_STATS *combStats, int comb, int currentPop);
 
 void copyStaticEventStats(Stats *sourceStats, int n, Stats *targetStats, int m);
 
-void appendCurrent(int comb, int currentPop, int gene);
+void appendCurrent(COMB_STATS *combStats, int comb, int currentPop, int gene);
 
-void migrations(int comb, int gene);
+void migrations(COMB_STATS *combStats, int comb, int gene);
 
-void handleCombLeavesMigBand(int comb, int mig, int gene);
+void handleCombLeavesMigBand(COMB_STATS *combStats, int comb, int mig, int gene);
 
-void countMigEventTowardsBelowComb(Event event, MigStats *leafMigStats);
+void countMigEventTowardsBelowComb(const Event &event, MigStats *leafMigStats);
 
-void countMigEventTowardsHalfAndHalf(Event event, double eventAge, double previousAge, double combAge, MigStats *leafMigStats);
+void countMigEventTowardsHalfAndHalf(const Event &event, double eventAge, double previousAge, double combAge, MigStats *leafMigStats);
 
-void countMigEventTowardsAboveComb(Event event, MigStats *leafMigStats);
+void countMigEventTowardsAboveComb(const Event &event, MigStats *leafMigStats);
 
 
-Stats *getCombPopStats(int comb, int pop);
+Stats *getCombPopStats(COMB_STATS *combStats, int comb, int pop);
 
-void initCombStats();
+void initCombStats(COMB_STATS *combStats);
 
-void initPopStats();
+void initCombLocusStats(COMB_STATS *combStats, COMB_STATS *ageStats);
 
-void initMigStats();
+void initPopStats(COMB_STATS *combStats);
+
+void initMigStats(COMB_STATS *combStats);
 
 void initStats(Stats *stats);
 
+void addCombStatsToSums(COMB_STATS *combStats, double *sums);
+
+void addSumsToCombStats(double *sums, COMB_STATS *combStats);
+
+int countCombSums();
+
 void allocateCombMem();
 
-void allocatePopsMem();
+COMB_STATS *allocateCombStats();
+
+void allocatePopsMem(COMB_STATS *combStats);
 
-void allocateMigBandsMem();
+void allocateMigBandsMem(COMB_STATS *combStats);
 
 void allocateStats(Stats *stats);
 
@@ -78,10 +78,10 @@ public:
   int total_events;               // total number of events pre-allocated
                                   // to this chain
 
-  int first_event[2*NSPECIES-1];  // pointers to first event
+  int* first_event;               // pointers to first event
                                   // for every population
 
-  int last_event[2*NSPECIES-1];   // pointers to last event
+  int* last_event;                // pointers to last event
                                   // for every population
 
   int free_events;                // pointer to a chain of free events for use.
@@ -209,16 +209,16 @@ public:
   std::vector<Event*> changed_events;
   // number of population affected by change
   int num_pops_changed;
-  // an array of populations affected by change
-  int pops_changed[2 * NSPECIES - 1];
+  // an array of populations affected by change (numPops)
+  int* pops_changed;
   // number of migration bands affected by change
   int num_mig_bands_changed;
-  // an array of migration bands affected by change
-  int mig_bands_changed[MAX_MIG_BANDS];
-  // difference in coalescence statistics per population affected
-  double coal_stats_delta[2 * NSPECIES - 1];
-  // difference in migration statistics per migration band affected
-  double mig_stats_delta[MAX_MIG_BANDS];
+  // an array of migration bands affected by change (numMigBands)
+  int* mig_bands_changed;
+  // difference in coalescence statistics per population affected (numPops)
+  double* coal_stats_delta;
+  // difference in migration statistics per migration band affected (numMigBands)
+  double* mig_stats_delta;
 };
 
 //-----------------------------------------------------------------------------
@@ -230,7 +230,6 @@ GENETREE_STATS_DELTA::init()
   this->num_lin_delta         =  0;
   this->original_event        = -1;
   this->updated_event         = -1;
-  changed_events.reserve(MAX_EVENTS);
 }
 /*-----------------------------------------------------------------------------
  * GENETREE_STATS
@@ -241,16 +240,18 @@ GENETREE_STATS_DELTA::init()
  * genealogy 'gen'. Array allocated in GetMem().
  * genetree_stats_total holds sum of statistics for all loci. coal_stats here
  * considers also all gen-specific heredity factors (but not thetas).
+ * Arrays are of length numPops (coal) and numMigBands (mig), and are
+ * allocated in GetMem() (in per-locus blocks for genetree_stats[gen]).
  *
  @@TODO: NEED TO ADD DOCUMENTATION FOR THIS --  !!!
  *---------------------------------------------------------------------------*/
 class GENETREE_STATS
 {
 public:
-  double coal_stats[2 * NSPECIES - 1];
-  double mig_stats[MAX_MIG_BANDS];
-  int    num_coals[2 * NSPECIES - 1];
-  int    num_migs[MAX_MIG_BANDS];
+  double* coal_stats;
+  double* mig_stats;
+  int*    num_coals;
+  int*    num_migs;
 };
 
 
@@ -265,6 +266,7 @@ public:
  * new_events       - new copies of events.
  * pops             - population in which each event resides.
  * new_ages         - age of each new event.
+ * arrays are of length maxMigs + numMigBands.
  *
  * rubberband_migs is an array of size numLoci allocated in getMem().
  *---------------------------------------------------------------------------*/
@@ -272,16 +274,17 @@ class RUBBERBAND_MIGS
 {
 public:
   int num_moved_events;
-  int orig_events[MAX_MIGS + MAX_MIG_BANDS];
-  int new_events[MAX_MIGS + MAX_MIG_BANDS];
-  int pops[MAX_MIGS + MAX_MIG_BANDS];
-  double new_ages[MAX_MIGS + MAX_MIG_BANDS];
+  int* orig_events;
+  int* new_events;
+  int* pops;
+  double* new_ages;
 };
 
 /*-----------------------------------------------------------------------------
  * MIG_SPR_STATS
  * Holds statistics for the SPR sampling operation with migration.
  * In use in UpdateGB_MigSPR and in traceLineage.
+ * migration arrays are of length maxMigs.
  *---------------------------------------------------------------------------*/
 class MIG_SPR_STATS
 {
@@ -292,16 +295,32 @@ public:
   int    target;
   int    num_old_migs;
   int    num_new_migs;
-  int    old_migs[MAX_MIGS];
-  int    new_migs_in[MAX_MIGS];
-  int    new_migs_out[MAX_MIGS];
-  int    new_migs_bands[MAX_MIGS];
-  double new_migs_ages[MAX_MIGS];
+  int*    old_migs;
+  int*    new_migs_in;
+  int*    new_migs_out;
+  int*    new_migs_bands;
+  double* new_migs_ages;
   double genetree_delta_lnLd[2];
 };
 
+/*-----------------------------------------------------------------------------
+ * LOCUS_SCRATCH
+ * Per-locus work arrays of functions called within parallel locus loops
+ * (each function has its own arrays, since some of them call each other).
+ *---------------------------------------------------------------------------*/
+class LOCUS_SCRATCH
+{
+public:
+  int* rubberband_mig_bands;   // living mig bands in rubberBand (numMigBands)
+  int* ripple_pops;            // affected pops in rubberBandRipple (numPops)
+  int* recalc_mig_bands;       // living mig bands in recalcStats (numMigBands)
+  int* trace_mig_bands;        // living mig bands in traceLineage (numMigBands)
+  int* trace_targets;          // target nodes in traceLineage (2*numSamples-1)
+};
+
 /*-----------------------------------------------------------------------------
  * Locus_SuperStruct
+ * Arrays of all members are allocated in GetMem(), in per-locus blocks.
  *---------------------------------------------------------------------------*/
 class Locus_SuperStruct
 {
@@ -313,6 +332,7 @@ public:
   double                 genLogLikelihood;
   RUBBERBAND_MIGS        rubberband_migs;
   int                    mig_conflict_log;
+  LOCUS_SCRATCH          scratch;
 };
 
 //============================ END OF FILE ====================================
@@ -2,12 +2,8 @@
 
 
 #define EPSILON         1e-10       // epsilon for double comparision
-#define MAX_MIG_BANDS	40			// max migration bands in the population tree
-#define MAX_MIGS		10			// max migration events per genealogy
-#define NSPECIES		20			// max # of species
-#define NS				200			// max # of sequences
+#define DEFAULT_MAX_MIGS	10			// default max migration events per genealogy (max-migs in control file)
 #define OLDAGE			999			// upper bound on age (can be extended...)
-#define MAX_EVENTS   (NS + 2*NSPECIES + 3*MAX_MIGS)
 #define NUM_DELTA_STATS_INSTANCES 2
 
 #define DEBUG_NODE_CHANGE_NOT
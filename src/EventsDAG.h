@@ -45,7 +45,7 @@ public:
   void setContent( T* pContent);
 
   //@@TODO: rework the next method. Integer is bad here.
-  int getType() const {pContent_->getType();}
+  int getType() const {return pContent_->getType();}
 
   EventsDAGNode<T>* getPrevGenEvent() const;
   void setPrevGenEvent(EventsDAGNode<T>* pPrevGenEvent);
@@ -19,6 +19,8 @@
 #include "LocusDataLikelihood.h"    // NEXTGEN: switch to LocusGenealogy.h !!!
 
 #include "MultiCoreUtils.h"
+#include "Profiler.h"
+#include "TraceWriter.h"
 
 #include <unistd.h>
 #include <stdlib.h>
@@ -44,7 +46,8 @@
 
 static struct option long_options[] = {{"help",     no_argument, 0, 'h'},
                                        {"verbose",  no_argument, 0, 'v'},
-                                       {"nthreads", no_argument, 0, 'n'},
+                                       {"nthreads", required_argument, 0, 'n'},
+                                       {"scheduling", required_argument, 0, 's'},
                                        {0, 0,                    0, 0}};
 
 extern RandGeneratorContext RndCtx;
@@ -62,6 +65,9 @@ void printUsage(char *programName)
              "[secondary-control-file-name] [options].\n", programName);
   printf("-v, --verbose     Print more information "
              "at the beginning of the program\n");
+  printf("-n, --nthreads    Number of threads to use\n");
+  printf("-s, --scheduling  Locus scheduling strategy for threads: "
+             "STATIC, DYNAMIC, GUIDED or COST\n");
   printf("-h, --help\n");
   printf("See manual for more help.\n");
 }
@@ -70,39 +76,15 @@ void printUsage(char *programName)
 //-----------------------------------------------------------------------------
 // main
 //-----------------------------------------------------------------------------
+#ifndef GPHOCS_NO_MAIN
 int main(int argc, char *argv[])
 {
 
   int res, c, option_index;
   int num_threads_in_cmd = -1;
+  char *scheduling_in_cmd = nullptr;
   int max_num_threads = omp_get_max_threads();
 
-  /*
-   #ifdef THREAD_UpdateGB_InternalNode
-   printf("THREAD UpdateGB_InternalNode: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_UpdateGB_MigrationNode
-   printf("THREAD UpdateGB_MigrationNode: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_UpdateGB_MigSPR
-   printf("THREAD UpdateGB_MigSPR: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_UpdateTau
-   printf("THREAD UpdateTau: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_UpdateMigRates
-   printf("THREAD UpdateMigRates: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_mixing
-   printf("THREAD mixing: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_UpdateTheta
-   printf("THREAD UpdateTheta: %d\n", THREAD_COUNT_GPHOCS);
-   #endif
-   #ifdef THREAD_UpdateSampleAge
-   printf("THREAD UpdateSampleAge: %d\n", THREAD_COUNT_GPHOCS);
-   #endif*/
-
   starttime();
   if (argc <= 1)
   {
@@ -116,7 +98,7 @@ int main(int argc, char *argv[])
   {
     // getopt_long stores the option index here.
     option_index = 0;
-    c = getopt_long(argc, argv, "hvn:", long_options, &option_index);
+    c = getopt_long(argc, argv, "hvn:s:", long_options, &option_index);
 
     // Detect the end of the options.
     if (c == -1)
@@ -141,6 +123,10 @@ int main(int argc, char *argv[])
         num_threads_in_cmd = atoi(optarg);
         break;
 
+      case 's':
+        scheduling_in_cmd = optarg;
+        break;
+
       default:
         abort();
     }
@@ -199,26 +185,14 @@ int main(int argc, char *argv[])
       exit(-1);
     }
   }
-  if (dataSetup.popTree->numCurPops > NSPECIES)
-  {
-    printf("Error: defined too many populations (%d), maximum allowed is %d.\n",
-           dataSetup.popTree->numCurPops, NSPECIES);
-    printf( "Please set NSPECIES constant at top of patch.c source file to at "
-            "least %d, recomplie, and re-run.\n",
-            dataSetup.popTree->numCurPops);
-    exit(-1);
-  }
-  if (dataSetup.popTree->numMigBands > MAX_MIG_BANDS)
+  printf("Done.\n");
+
+  // scheduling set in command line overrides control file
+  if (scheduling_in_cmd != nullptr &&
+      0 != parseLocusScheduling(scheduling_in_cmd, nullptr))
   {
-    printf( "Error: defined too many migration bands (%d), maximum "
-            "allowed is %d.\n",
-            dataSetup.popTree->numMigBands, MAX_MIG_BANDS );
-    printf( "Please set MAX_MIG_BANDS constant at top of patch.c source "
-            "file to at least %d, recomplie, and re-run.\n",
-            dataSetup.popTree->numMigBands );
     exit(-1);
   }
-  printf("Done.\n");
 
   res = checkSettings();
   finalizeNumParameters();
@@ -256,16 +230,8 @@ int main(int argc, char *argv[])
     }
   }
 
-  if (dataSetup.numSamples > NS)
-  {
-    printf("Error: defined too many samples (%d), maximum allowed is %d.\n",
-           dataSetup.numSamples, NS);
-    printf( "Please set NS constant at top of patch.c source file to "
-            "at least %d, recomplie, and re-run.\n",
-            dataSetup.numSamples);
-    exit(-1);
-  }
-
+  // threads are pinned before loci memory is allocated (and first touched)
+  initThreadPlacement();
   allocateAllMemory();
   printf("\n");
   initRandomGenerator( dataSetup.numLoci,
@@ -284,6 +250,7 @@ int main(int argc, char *argv[])
   exit(0);
 }
 /** end of main **/
+#endif // GPHOCS_NO_MAIN
 
 
 
@@ -301,7 +268,7 @@ int processAlignments()
   int *numPhasesArray;
   char **patternArray;
   char **phasedPatternArray;
-  int totalNumPatterns, totalPhasedPattern;
+  int totalNumPatterns, totalPhasedPattern, numLeafPatterns;
 
   res = readSeqFile(ioSetup.seqFileName, dataSetup.numSamples,
                     dataSetup.sampleNames, dataSetup.numLoci);
@@ -402,6 +369,16 @@ int processAlignments()
       free(numPhasesArray);
       return -1;
     }
+    if (0 != setLocusConditionalPrecision(dataState.lociData[gen],
+                                          mcmcSetup.floatConditionals))
+    {
+      freeAlignmentData();
+      free(patternArray);
+      free(phasedPatternArray[0]);
+      free(phasedPatternArray);
+      free(numPhasesArray);
+      return -1;
+    }
 
     for (patt = 0;
          patt < AlignmentData.locusProfiles[gen].numPatterns; patt++)
@@ -463,13 +440,18 @@ int processAlignments()
   free(phasedPatternArray[0]);
   free(phasedPatternArray);
   free(numPhasesArray);
+  numLeafPatterns = closeLeafPatternIndex();
   if (verbose)
+  {
     printf( "Done. Total of %d patterns (%lf average per locus) transformed "
             "to %d phased patterns (%lf average per locus).\n",
             totalNumPatterns,
             ((double) totalNumPatterns) / dataSetup.numLoci,
             totalPhasedPattern,
             ((double) totalPhasedPattern) / dataSetup.numLoci);
+    printf("Leaf conditionals are shared by %d distinct phased patterns.\n",
+           numLeafPatterns);
+  }
 
   return 0;
 
@@ -686,11 +668,11 @@ int freeAllMemory()
   freeAlignmentData();
 
   // NEXTGEN - NEED TO REMOVE THIS PART !!!
-  //Freeing event chains
-  free(event_chains[0].events);
+  //Freeing event chains, node arrays and locus data (in locus arenas)
+  freeLocusArenas();
+  freeLeafPatterns();
   free(genetree_stats);
   //free(rubberband_migs);
-  free(nodePops[0]);
   free(nodePops);
 
   free(locus_data);
@@ -786,6 +768,35 @@ int recordTypes()
 /** end of recordTypes **/
 
 
+/******************************************************************************
+ *	openStatsStream
+ *	- opens a trace writer stream of stat pairs (with at most maxStats pairs)
+ *		to given stats file, with header printed by given function
+ *	- returns stream id (-1 on error)
+ *****************************************************************************/
+int
+openStatsStream(FILE *file, void (*printHeader)(FILE *), int maxStats)
+{
+  char *header = nullptr;
+  size_t headerLength = 0;
+  FILE *headerFile = open_memstream(&header, &headerLength);
+  int stream;
+
+  if (headerFile == nullptr)
+  {
+    fprintf(stderr, "\nError: Out Of Memory while allocating stats header.\n");
+    exit(-1);
+  }
+  printHeader(headerFile);
+  fclose(headerFile);
+  stream = openTraceStream(file, TRACE_FORMAT_STAT_PAIRS, maxStats, header);
+  free(header);
+  return stream;
+}
+/** end of openStatsStream **/
+
+
+
 /******************************************************************************
  *	printParamVals
  *	- prints parameter values to out file (without newline)
@@ -1116,6 +1127,8 @@ int initializeMCMC()
   totalCoals = 0;
   dataState.logLikelihood = 0.0;
   dataState.dataLogLikelihood = 0.0;
+  initLocusPartialSums(dataSetup.numLoci, dataSetup.popTree->numPops,
+                       dataSetup.popTree->numMigBands);
   tree = createGenericTree(dataSetup.numSamples);
   if (tree == nullptr)
   {
@@ -1183,6 +1196,15 @@ int performMCMC()
   int i, j, logCount, totalNumMigNodes, migBand;
   int numSamplesPerLog, logsPerLine;
 
+  // consistency checks at each log: next locus to check
+  int nextCheckedLocus = 0;
+
+  // trace writer streams of trace and stats files
+  int traceStream, combStatsStream = -1, cladeStatsStream = -1, hypStatsStream = -1;
+  FILE *headerFile;
+  char *header = nullptr;
+  size_t headerLength = 0;
+
   // set to 1 while dynamically searching for finetunes
   unsigned short findingFinetunes = 0;
   // set to 1 for recording coal stats
@@ -1210,7 +1232,6 @@ int performMCMC()
               ioSetup.combStatsFileName);
       return (-1);
     }
-    printCombStatsHeader(ioSetup.combStatsFile);
   }
   if (isCladeStatsActivated()) {
     ioSetup.cladeStatsFile = fopen(ioSetup.cladeStatsFileName, "w");
@@ -1220,7 +1241,6 @@ int performMCMC()
               ioSetup.cladeStatsFileName);
       return (-1);
     }
-    printCladeStatsHeader(ioSetup.cladeStatsFile);
   }
   if (isCladeStatsActivated() || isCombStatsActivated()) {
     ioSetup.hypStatsFile = fopen(ioSetup.hypStatsFileName, "w");
@@ -1230,28 +1250,29 @@ int performMCMC()
               ioSetup.cladeStatsFileName);
       return (-1);
     }
-    printHypStatsHeader(ioSetup.hypStatsFile);
   }
 #ifdef LOG_STEPS
   ioSetup.debugFile = fopen("G-PhoCS-debug.txt","w");
 #endif
 
-  fprintf(ioSetup.traceFile, "Sample");
+  // trace header is built in memory, and written by trace writer
+  headerFile = open_memstream(&header, &headerLength);
+  fprintf(headerFile, "Sample");
   for (pop = 0; pop < dataSetup.popTree->numPops; pop++)
   {
-    fprintf(ioSetup.traceFile, "\ttheta_%s",
+    fprintf(headerFile, "\ttheta_%s",
             dataSetup.popTree->pops[pop]->name);
   }
 
   for (pop = dataSetup.popTree->numCurPops;
        pop < dataSetup.popTree->numPops; pop++)
   {
-    fprintf(ioSetup.traceFile, "\ttau_%s", dataSetup.popTree->pops[pop]->name);
+    fprintf(headerFile, "\ttau_%s", dataSetup.popTree->pops[pop]->name);
   }
 
   for (migBand = 0; migBand < dataSetup.popTree->numMigBands; migBand++)
   {
-    fprintf(ioSetup.traceFile, "\tm_%s->%s",
+    fprintf(headerFile, "\tm_%s->%s",
             dataSetup.popTree->pops[\
               dataSetup.popTree->migBands[migBand].sourcePop]->name,
             dataSetup.popTree->pops[\
@@ -1262,14 +1283,46 @@ int performMCMC()
     if (dataSetup.popTree->pops[pop]->updateSampleAge ||
         dataSetup.popTree->pops[pop]->sampleAge > 0.0)
     {
-      fprintf(ioSetup.traceFile, "\ttau_%s",
+      fprintf(headerFile, "\ttau_%s",
               dataSetup.popTree->pops[pop]->name);
     }
   }
 
   if (mcmcSetup.mutRateMode == 1)
-    fprintf(ioSetup.traceFile, "\tVariance-Mut");
-  fprintf(ioSetup.traceFile, "\tComplete-ld-ln-avg\tData-ld-ln\tGene-ld-ln\n");
+    fprintf(headerFile, "\tVariance-Mut");
+  fprintf(headerFile, "\tComplete-ld-ln-avg\tData-ld-ln\tGene-ld-ln\n");
+  fclose(headerFile);
+
+  // from here on, trace and stats files are written by trace writer
+  initTraceWriter(ioSetup.asyncTraceWriter, ioSetup.traceFlushSeconds,
+                  ioSetup.binaryTraceFormat);
+  traceStream = openTraceStream(ioSetup.traceFile, TRACE_FORMAT_PARAMS,
+                                mcmcSetup.numParameters + TRACE_NUM_LIKELIHOODS,
+                                header);
+  free(header);
+  if (traceStream < 0)
+    return (-1);
+  if (isCombStatsActivated())
+  {
+    combStatsStream = openStatsStream(ioSetup.combStatsFile,
+                                      printCombStatsHeader, getMaxCombStats());
+    if (combStatsStream < 0)
+      return (-1);
+  }
+  if (isCladeStatsActivated())
+  {
+    cladeStatsStream = openStatsStream(ioSetup.cladeStatsFile,
+                                       printCladeStatsHeader, getMaxCladeStats());
+    if (cladeStatsStream < 0)
+      return (-1);
+  }
+  if (isCladeStatsActivated() || isCombStatsActivated())
+  {
+    hypStatsStream = openStatsStream(ioSetup.hypStatsFile,
+                                     printHypStatsHeader, getMaxHypStats());
+    if (hypStatsStream < 0)
+      return (-1);
+  }
 
   printf( "Starting MCMC: %d burnin, %d running, sampled "
           "every %d iteration(s).\n",
@@ -1284,6 +1337,62 @@ int performMCMC()
     printf("Error while initializing MCMC.\n");
     return -1;
   }
+  // order loci for threads according to their estimated likelihood cost
+  doubleArray = (double *) malloc(dataSetup.numLoci * sizeof(double));
+  if (doubleArray == nullptr)
+  {
+    fprintf(stderr,
+            "\nError: Out Of Memory while allocating locus cost "
+            "array in performMCMC.\n");
+    exit(-1);
+  }
+  for (gen = 0; gen < dataSetup.numLoci; gen++)
+  {
+    doubleArray[gen] = (getLocusNumLivePatterns(dataState.lociData[gen]) + 1.0)
+                       * dataSetup.numSamples;
+  }
+  initLocusScheduler(dataSetup.numLoci, doubleArray);
+  free(doubleArray);
+  printf("Scheduling loci to threads using %s strategy.\n",
+         getLocusSchedulingName());
+  if (verbose)
+  {
+    printMoveThreading(dataSetup.numLoci);
+  }
+  // with fewer loci than threads, locus loops leave threads idle, so
+  // patterns of full likelihood recomputations of a locus are split instead
+  if (dataSetup.numLoci < omp_get_max_threads())
+  {
+    setPatternThreads(omp_get_max_threads());
+    printf("Splitting patterns of full likelihood recomputations of each locus "
+           "among %d threads (%d loci).\n",
+           omp_get_max_threads(), dataSetup.numLoci);
+  }
+
+  // per-move run-time profile (written next to trace file if requested)
+  if (0 == strcmp(ioSetup.profileFileName, "AUTO"))
+  {
+    snprintf(ioSetup.profileFileName, NAME_LENGTH, "%s.profile.jsonl",
+             ioSetup.traceFileName);
+  }
+  if (0 != initProfiler((0 == strcmp(ioSetup.profileFileName, "NONE")) ?
+                        nullptr : ioSetup.profileFileName,
+                        omp_get_max_threads()))
+  {
+    return -1;
+  }
+
+  // per-locus cost accounting (reported at end of run)
+  if (0 == strcmp(ioSetup.locusCostFileName, "AUTO"))
+  {
+    snprintf(ioSetup.locusCostFileName, NAME_LENGTH, "%s.locus-costs.tsv",
+             ioSetup.traceFileName);
+  }
+  if (0 != strcmp(ioSetup.locusCostFileName, "NONE"))
+  {
+    initLocusProfiles(dataSetup.numLoci);
+  }
+
   // allocate and initialize parameter value arrays
   printf("There are %d parameters in the model.\n", mcmcSetup.numParameters);
   doubleArray = (double *) malloc(
@@ -1421,9 +1530,7 @@ int performMCMC()
 	}
 #endif
 
-#ifdef RECORD_METHOD_TIMES
   setStartTimeMethod(T_MCMCIterations);
-#endif
 
   AllLoci lociEmbedded;
   auto & lociVector = lociEmbedded.getLociVector();
@@ -1431,35 +1538,26 @@ int performMCMC()
   for (iteration = -mcmcSetup.burnin; iteration < mcmcSetup.numSamples;
        iteration++)
   {
-#ifdef RECORD_METHOD_TIMES
-    if(iteration > 0 && iteration % 5000 == 0)
-		{
-      setEndTimeMethod(T_MCMCIterations);
-      setStartTimeMethod(T_MCMCIterations);
-      printMethodTimes();
-		}
-#endif
-
     for (j = 0; j < mcmcSetup.genetreeSamples; j++)
     {
 
       // update COALESCENCE NODE ages
-#ifdef RECORD_METHOD_TIMES
       setStartTimeMethod(T_UpdateGB_InternalNode);
-#endif
 
       //NEW code section July 2019 /////////////////////////////////////////////
-#ifdef THREAD_UpdateGB_InternalNode
-#pragma omp parallel for private(locus) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+        //construct mig bands times
+        constructMigBandsTimes(dataSetup.popTree);
 
-        int acceptCounter;
+        int numThreads = beginParallelMove(MOVE_COAL_TIME, dataSetup.numLoci);
 
         //for each locus
-        for (auto &locus : lociVector) {
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+        for (i = 0; i < dataSetup.numLoci; i++) {
 
-            //construct mig bands times
-            constructMigBandsTimes(dataSetup.popTree);
+            gen = SCHEDULED_LOCUS(i);
+            LocusEmbeddedGenealogy &locus = lociVector[gen];
+            long long locusStartTime = startLocusTimer();
+            int acceptCounter;
 
             //construct genealogy and intervals
             locus.constructEmbeddedGenealogy();
@@ -1480,22 +1578,26 @@ int performMCMC()
 
             //update internal nodes+test
             acceptCounter = locus.updateGB_InternalNode(mcmcSetup.finetunes.coalTime);
-
-#pragma omp atomic
-            acceptanceCounts.coalTime += acceptCounter;
+            LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_ACCEPTED) += acceptCounter;
+            addLocusProposals(gen, dataSetup.numSamples - 1, acceptCounter);
 
             #ifdef TEST_NEW_DATA_STRUCTURE
             //test genealogy, intervals, statistics, likelihood
             locus.testLocusEmbeddedGenealogy();
             #endif
 
+            stopLocusTimer(gen, locusStartTime);
         }
+        acceptCount = (int) reduceLocusPartialSums(LOCUS_SUM_ACCEPTED, nullptr);
+        acceptanceCounts.coalTime += acceptCount;
+        addMethodProposals(T_UpdateGB_InternalNode, totalCoals, acceptCount);
+        reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataState.dataLogLikelihood);
+        reduceLocusPartialSums(LOCUS_SUM_LNLD, &dataState.logLikelihood);
+        reduceGenetreeStatsTotal();
 
       //END of NEW code section/////////////////////////////////////////////////
 
-#ifdef RECORD_METHOD_TIMES
       setEndTimeMethod(T_UpdateGB_InternalNode);
-#endif
 
 
 #ifdef CHECKALL
@@ -1508,19 +1610,18 @@ int performMCMC()
 #endif
 
   // update MIGRATION NODE ages
-#ifdef RECORD_METHOD_TIMES
       setStartTimeMethod(T_UpdateGB_MigrationNode);
-#endif
       acceptCount = UpdateGB_MigrationNode(mcmcSetup.finetunes.migTime);
-#ifdef RECORD_METHOD_TIMES
       setEndTimeMethod(T_UpdateGB_MigrationNode);
-#endif
       acceptanceCounts.migTime += acceptCount;
       // count number of events for acceptance ratio
+      int numMigNodes = 0;
       for (i = 0; i < dataSetup.popTree->numMigBands; i++)
       {
-        totalNumMigNodes += genetree_stats_total.num_migs[i];
+        numMigNodes += genetree_stats_total.num_migs[i];
       }
+      totalNumMigNodes += numMigNodes;
+      addMethodProposals(T_UpdateGB_MigrationNode, numMigNodes, acceptCount);
 
 #ifdef CHECKALL
       if (!checkAll())
@@ -1532,14 +1633,11 @@ int performMCMC()
 #endif
 
       // update GENEALOGY TOPOLOGY (including migration events)
-#ifdef RECORD_METHOD_TIMES
       setStartTimeMethod(T_UpdateGB_MigSPR);
-#endif
       acceptCount = UpdateGB_MigSPR();
-#ifdef RECORD_METHOD_TIMES
       setEndTimeMethod(T_UpdateGB_MigSPR);
-#endif
       acceptanceCounts.SPR += acceptCount;
+      addMethodProposals(T_UpdateGB_MigSPR, 2 * totalCoals, acceptCount);
 
 #ifdef CHECKALL
       if (!checkAll())
@@ -1553,14 +1651,12 @@ int performMCMC()
       // update individual LOCUS MUTATION rates
       if (mcmcSetup.mutRateMode == 1)
       {
-#ifdef RECORD_METHOD_TIMES
         setStartTimeMethod(T_UpdateLocusRate);
-#endif
         acceptCount = UpdateLocusRate(mcmcSetup.finetunes.locusRate);
-#ifdef RECORD_METHOD_TIMES
         setEndTimeMethod(T_UpdateLocusRate);
-#endif
         acceptanceCounts.locusRate += acceptCount;
+        addMethodProposals(T_UpdateLocusRate, dataSetup.numLoci / 2,
+                           acceptCount);
 
 #ifdef CHECKALL
         if (!checkAll())
@@ -1574,14 +1670,11 @@ int performMCMC()
     } // end of for(j)
 
     // update THETAs
-#ifdef RECORD_METHOD_TIMES
     setStartTimeMethod(T_UpdateTheta);
-#endif
     acceptCount = UpdateTheta(mcmcSetup.finetunes.theta);
-#ifdef RECORD_METHOD_TIMES
     setEndTimeMethod(T_UpdateTheta);
-#endif
     acceptanceCounts.theta += acceptCount;
+    addMethodProposals(T_UpdateTheta, dataSetup.popTree->numPops, acceptCount);
 
 #ifdef CHECKALL
     if (!checkAll())
@@ -1595,14 +1688,12 @@ int performMCMC()
     // update MIGRATION RATEs
     if (iteration > mcmcSetup.startMig)
     {
-#ifdef RECORD_METHOD_TIMES
       setStartTimeMethod(T_UpdateMigRates);
-#endif
       acceptCount = UpdateMigRates(mcmcSetup.finetunes.migRate);
-#ifdef RECORD_METHOD_TIMES
       setEndTimeMethod(T_UpdateMigRates);
-#endif
       acceptanceCounts.migRate += acceptCount;
+      addMethodProposals(T_UpdateMigRates, dataSetup.popTree->numMigBands,
+                         acceptCount);
 
 #ifdef CHECKALL
       if (!checkAll())
@@ -1615,17 +1706,17 @@ int performMCMC()
     }
 
     // update TAUs
-#ifdef RECORD_METHOD_TIMES
     setStartTimeMethod(T_UpdateTau);
-#endif
     UpdateTau(mcmcSetup.finetunes.taus, acceptCountArray);
-#ifdef RECORD_METHOD_TIMES
     setEndTimeMethod(T_UpdateTau);
-#endif
+    acceptCount = 0;
     for (pop = 0; pop < dataSetup.popTree->numPops; pop++)
     {
       acceptanceCounts.taus[pop] += acceptCountArray[pop];
+      acceptCount += acceptCountArray[pop];
     }
+    addMethodProposals(T_UpdateTau, dataSetup.popTree->numPops -
+                       dataSetup.popTree->numCurPops, acceptCount);
 
 #ifdef CHECKALL
     if (!checkAll())
@@ -1636,18 +1727,23 @@ int performMCMC()
 		}
 #endif
 
-#ifdef RECORD_METHOD_TIMES
     setStartTimeMethod(T_UpdateSampleAge);
-#endif
     UpdateSampleAge(mcmcSetup.finetunes.taus, acceptCountArray);
-#ifdef RECORD_METHOD_TIMES
     setEndTimeMethod(T_UpdateSampleAge);
-#endif
 
+    acceptCount = 0;
+    int numSampleAgeProposals = 0;
     for (pop = 0; pop < dataSetup.popTree->numPops; pop++)
     {
       acceptanceCounts.taus[pop] += acceptCountArray[pop];
+      if (pop < dataSetup.popTree->numCurPops &&
+          dataSetup.popTree->pops[pop]->updateSampleAge)
+      {
+        acceptCount += acceptCountArray[pop];
+        numSampleAgeProposals++;
+      }
     }
+    addMethodProposals(T_UpdateSampleAge, numSampleAgeProposals, acceptCount);
 
 #ifdef CHECKALL
     if (!checkAll())
@@ -1662,15 +1758,12 @@ int performMCMC()
     // NO MIXING
     if (mcmcSetup.doMixing)
     {
-#ifdef RECORD_METHOD_TIMES
       setStartTimeMethod(T_mixing);
-#endif
       acceptCount = mixing(mcmcSetup.finetunes.mixing);
-#ifdef RECORD_METHOD_TIMES
       setEndTimeMethod(T_mixing);
-#endif
 
       acceptanceCounts.mixing += acceptCount;
+      addMethodProposals(T_mixing, 1, acceptCount);
     }
 
 #ifdef CHECKALL
@@ -1683,16 +1776,35 @@ int performMCMC()
 
     // synchronize events due to possible inconsistencies caused by
     // rescaling of ages (mixing and rubber band).
+    // loci are synchronized in parallel. failing loci are only recorded
+    // inside the loop, and the first one is reported after it.
+    setStartTimeMethod(T_SyncEvents);
+    int syncFailedLocus = dataSetup.numLoci;
+    int numSyncThreads = beginParallelMove(MOVE_SYNC_EVENTS, dataSetup.numLoci);
+#pragma omp parallel for private(gen) schedule(static) num_threads(numSyncThreads) if(numSyncThreads > 1)
     for (gen = 0; gen < dataSetup.numLoci; gen++)
     {
       if (!synchronizeEvents(gen))
       {
-        printf( "\n  --  Aborting due to problems found when synchronizing "
-                "data structures for locus #%d after MCMC iteration %d.\n\n",
-                iteration, gen + 1);
-        printGenealogyAndExit(gen, -1);
+#pragma omp critical(syncFailedLocus)
+        syncFailedLocus = min2(syncFailedLocus, gen);
       }
     }
+    setEndTimeMethod(T_SyncEvents);
+    if (syncFailedLocus < dataSetup.numLoci)
+    {
+      printf( "\n  --  Aborting due to problems found when synchronizing "
+              "data structures for locus #%d after MCMC iteration %d.\n\n",
+              syncFailedLocus + 1, iteration);
+      printGenealogyAndExit(syncFailedLocus, -1);
+    }
+
+    // check single-precision conditionals in first iterations
+    if (mcmcSetup.floatConditionals &&
+        iteration < mcmcSetup.precisionCheckIterations - mcmcSetup.burnin)
+    {
+      checkConditionalPrecision(iteration);
+    }
 
 #ifdef CHECKALL
     if (!checkAll())
@@ -1718,13 +1830,9 @@ int performMCMC()
     // start sampling migrations
     if (iteration == mcmcSetup.startMig)
     {
-#ifdef RECORD_METHOD_TIMES
       setStartTimeMethod(T_UpdateMigRates);
-#endif
       sampleMigRates(dataSetup.popTree);
-#ifdef RECORD_METHOD_TIMES
       setEndTimeMethod(T_UpdateMigRates);
-#endif
 
       // adjust likelihoods to newly sampled migration rates
       for (gen = 0; gen < dataSetup.numLoci; gen++)
@@ -1744,10 +1852,15 @@ int performMCMC()
 
     if (iteration >= 0 && iteration % (mcmcSetup.sampleSkip + 1) == 0)
     {
-      fprintf(ioSetup.traceFile, "%d\t", iteration);
-      printParamVals(paramVals, 0, mcmcSetup.numParameters, ioSetup.traceFile);
-      fprintf(ioSetup.traceFile, "%.6f\t%.6f\t%.6f\n", dataState.logLikelihood, dataState.dataLogLikelihood, dataState.genealogyLogLikelihood);
-      fflush(ioSetup.traceFile);
+      TRACE_RECORD *traceRecord = beginTraceRecord(traceStream, iteration);
+      for (i = 0; i < mcmcSetup.numParameters; i++)
+      {
+        addTraceValue(traceRecord, paramVals[i] * mcmcSetup.printFactors[i]);
+      }
+      addTraceValue(traceRecord, dataState.logLikelihood);
+      addTraceValue(traceRecord, dataState.dataLogLikelihood);
+      addTraceValue(traceRecord, dataState.genealogyLogLikelihood);
+      commitTraceRecord(traceStream);
 
       if (recordCoalStats && 0)
       {
@@ -1760,14 +1873,14 @@ int performMCMC()
 //					@@ronv: please enter here :)
       if (isCombStatsActivated()) {
         calculateCombStats();
-        printCombStats(iteration, ioSetup.combStatsFile);
+        printCombStats(iteration, combStatsStream);
       }
       if (isCladeStatsActivated()) {
         calculateCladeStats();
-        printCladeStats(iteration, ioSetup.cladeStatsFile);
+        printCladeStats(iteration, cladeStatsStream);
       }
       if (isCladeStatsActivated() || isCombStatsActivated()) {
-        printHypStats(iteration, ioSetup.hypStatsFile);
+        printHypStats(iteration, hypStatsStream);
       }
     }
 
@@ -1776,16 +1889,34 @@ int performMCMC()
     // print log
     if ((iteration + 1) % numSamplesPerLog == 0)
     {
-      // print the 8 acceptance ratios
-      if (!checkAll())
+      // refine locus order for threads using measured locus times
+      updateLocusSchedule();
+
+      // check data structures (all loci, or next subset of loci)
+      if (mcmcSetup.checkLevel != CHECK_OFF)
       {
-        fprintf(stderr,
-                "\nError:  --  Aborting when logging after MCMC iteration %d, "
-                    "due to data structure inconsistency.\n\n",
-                iteration);
-        exit(-1);
+        int numChecked = (mcmcSetup.checkLevel == CHECK_FULL) ?
+                         dataSetup.numLoci : mcmcSetup.checkLociPerLog;
+        setStartTimeMethod(T_Checks);
+        if (!checkLoci(nextCheckedLocus, numChecked))
+        {
+          fprintf(stderr,
+                  "\nError:  --  Aborting when logging after MCMC iteration %d, "
+                      "due to data structure inconsistency.\n\n",
+                  iteration);
+          exit(-1);
+        }
+        setEndTimeMethod(T_Checks);
+        nextCheckedLocus = (nextCheckedLocus + numChecked) % dataSetup.numLoci;
       }
 
+      // write run-time profile of last log interval
+      setEndTimeMethod(T_MCMCIterations);
+      writeProfile(iteration + 1);
+      setStartTimeMethod(T_MCMCIterations);
+
+      // print the 8 acceptance ratios
+
       acceptancePercents.coalTime = acceptanceCounts.coalTime * 100.0 /
                                     (((double) logCount) * totalCoals *
                                      mcmcSetup.genetreeSamples);
@@ -2169,20 +2300,77 @@ int performMCMC()
 
 
 
-#ifdef RECORD_METHOD_TIMES
   setEndTimeMethod(T_MCMCIterations);
-#endif
 
   free(doubleArray);
   free(acceptCountArray);
+  freeLocusScheduler();
+  freeLocusPartialSums();
   printf("\nMCMC finished. Time used: %s\n", printtime(timeString));
+  if (mcmcSetup.checkLevel != CHECK_OFF)
+  {
+    printf("Time used for consistency checks: %.2f seconds.\n",
+           getMethodSeconds(T_Checks));
+  }
 
   printMethodTimes();
+  if (locusProfiles != nullptr)
+  {
+    lociEmbedded.reportLocusCosts(ioSetup.locusCostFileName, 10);
+    freeLocusProfiles();
+  }
+  closeProfiler();
+  closeTraceWriter();
   return 0;
 }
 
 /** end of performMCMC **/
 
+/******************************************************************************
+ *	checkConditionalPrecision
+ *	- checks log-likelihoods of all loci with single-precision conditionals
+ *	  against double precision, and switches loci whose deviation exceeds
+ *	  tolerance to double precision (adjusting total log-likelihoods)
+ *	- called at end of each of the first precision-check iterations
+ *	  (no changes to loci are pending)
+ *****************************************************************************/
+void checkConditionalPrecision(int iteration)
+{
+  int gen, numFloatLoci = 0;
+  double deviation, deltaLnLd;
+  int numThreads = beginParallelMove(MOVE_CHECKS, dataSetup.numLoci);
+
+#pragma omp parallel for private(gen, deviation, deltaLnLd) schedule(static) num_threads(numThreads) if(numThreads > 1)
+  for (gen = 0; gen < dataSetup.numLoci; gen++)
+  {
+    deviation = checkLocusConditionalPrecision(dataState.lociData[gen]);
+    if (deviation > mcmcSetup.precisionTolerance)
+    {
+      deltaLnLd = useDoubleConditionals(dataState.lociData[gen]);
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) += deltaLnLd;
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_LNLD) += deltaLnLd / dataSetup.numLoci;
+#pragma omp critical(precisionFallback)
+      printf("\nSingle-precision conditionals of locus %d deviate by %g in "
+             "log-likelihood (iteration %d), switching to double precision.\n",
+             gen + 1, deviation, iteration);
+    }
+  }
+  reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataState.dataLogLikelihood);
+  reduceLocusPartialSums(LOCUS_SUM_LNLD, &dataState.logLikelihood);
+
+  if (iteration == mcmcSetup.precisionCheckIterations - mcmcSetup.burnin - 1)
+  {
+    for (gen = 0; gen < dataSetup.numLoci; gen++)
+    {
+      numFloatLoci += getLocusConditionalPrecision(dataState.lociData[gen]);
+    }
+    printf("\nSingle-precision conditionals kept for %d of %d loci after "
+           "%d check iterations.\n",
+           numFloatLoci, dataSetup.numLoci, mcmcSetup.precisionCheckIterations);
+  }
+}
+/** end of checkConditionalPrecision **/
+
 
 
 
@@ -2203,18 +2391,19 @@ int performMCMC()
  *****************************************************************************/
 int UpdateGB_InternalNode(double finetune)
 {
-  int accepted = 0, gen;
+  int accepted = 0, gen, locusIdx;
+  int numThreads = beginParallelMove(MOVE_COAL_TIME, dataSetup.numLoci);
 
   if (finetune <= 0.0)
   {
     return 0;
   }
 
-#ifdef THREAD_UpdateGB_InternalNode
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-  for (gen = 0; gen < dataSetup.numLoci; gen++)
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+  for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
   {
+gen = SCHEDULED_LOCUS(locusIdx);
+long long locusStartTime = startLocusTimer();
 
     int pop, inode, i, son;
     double t, tnew, lnacceptance, lnLd;
@@ -2327,20 +2516,17 @@ int UpdateGB_InternalNode(double finetune)
          }
          **/
     } // end of for(inode)
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    dataState.dataLogLikelihood += dataLogLikelihood_mt;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    dataState.logLikelihood += logLikelihood_mt;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    accepted += accepted_mt;
+    stopLocusTimer(gen, locusStartTime);
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) += dataLogLikelihood_mt;
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_LNLD) += logLikelihood_mt;
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_ACCEPTED) += accepted_mt;
   } // end of for(gen)
 
+  reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataState.dataLogLikelihood);
+  reduceLocusPartialSums(LOCUS_SUM_LNLD, &dataState.logLikelihood);
+  accepted = (int) reduceLocusPartialSums(LOCUS_SUM_ACCEPTED, nullptr);
+  reduceGenetreeStatsTotal();
+
   return (accepted);
 }
 /** end of UpdateGB_InternalNode **/
@@ -2356,19 +2542,21 @@ int UpdateGB_InternalNode(double finetune)
 int UpdateGB_MigrationNode(double finetune)
 {
 
-  int gen;
+  int gen, locusIdx;
   int accepted = 0;
+  int numThreads;
 
   if (finetune <= 0.0)
   {
     return 0;
   }
 
-#ifdef THREAD_UpdateGB_MigrationNode
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-  for (gen = 0; gen < dataSetup.numLoci; gen++)
+  numThreads = beginParallelMove(MOVE_MIG_TIME, dataSetup.numLoci);
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+  for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
   {
+    gen = SCHEDULED_LOCUS(locusIdx);
+    long long locusStartTime = startLocusTimer();
     int mig_below, mig_above, node_below, m = 0;
     double lnacceptance = 0, t;
     double genetree_lnLd_delta;
@@ -2493,16 +2681,16 @@ int UpdateGB_MigrationNode(double finetune)
         rejectEventChainChanges(gen, 1);
       }
     }      // end of for(mignode)
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    dataState.logLikelihood += genetree_lnLd_delta_mt;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    accepted += accepted_mt;
+    stopLocusTimer(gen, locusStartTime);
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_LNLD) += genetree_lnLd_delta_mt;
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_ACCEPTED) += accepted_mt;
+    addLocusProposals(gen, genetree_migs[gen].num_migs, accepted_mt);
   }      // end of for(gen)
 
+  reduceLocusPartialSums(LOCUS_SUM_LNLD, &dataState.logLikelihood);
+  accepted = (int) reduceLocusPartialSums(LOCUS_SUM_ACCEPTED, nullptr);
+  reduceGenetreeStatsTotal();
+
   return (accepted);
 }
 /** end of UpdateGB_MigrationNode **/
@@ -2516,16 +2704,17 @@ int UpdateGB_MigSPR()
 {
 
   int accepted = 0;
-  int gen;
+  int gen, locusIdx;
+  int numThreads = beginParallelMove(MOVE_SPR, dataSetup.numLoci);
   // double UNUSED, t_old;
 
   //	double	genetree_lnLd, genetree_lnLd_new;
 
-#ifdef THREAD_UpdateGB_MigSPR
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-  for (gen = 0; gen < dataSetup.numLoci; gen++)
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+  for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
   {
+    gen = SCHEDULED_LOCUS(locusIdx);
+    long long locusStartTime = startLocusTimer();
     double heredity_factor = 1.0, t_new;
     double lnLd;
     //double lnacceptance;
@@ -2567,6 +2756,7 @@ int UpdateGB_MigSPR()
                                  "father %d, pop %d, ",
                                  gen, node, father, father_pop_old);
 #endif
+      long long traceStartTime = startLocusCostTimer();
       traceLineage(gen, node, 0);
 
       // trace new lineage from node until reconnected
@@ -2576,6 +2766,11 @@ int UpdateGB_MigSPR()
       // if res < 0, then could not reconnect (due to too many migrations)
 
       res = traceLineage(gen, node, 1);
+      if (locusProfiles != nullptr)
+      {
+        stopLocusCostTimer(&locusProfiles[gen].traceLineageTime,
+                           traceStartTime);
+      }
 
       lnLd = -getLocusDataLikelihood(dataState.lociData[gen]);
       lnLd += computeLocusDataLikelihood(
@@ -2597,14 +2792,8 @@ int UpdateGB_MigSPR()
             (locus_data[gen].mig_spr_stats.genetree_delta_lnLd[1]
              - locus_data[gen].mig_spr_stats.genetree_delta_lnLd[0]);
 
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-        dataState.dataLogLikelihood += lnLd;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-        dataState.logLikelihood +=
+        LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) += lnLd;
+        LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_LNLD) +=
             (lnLd
               -
               locus_data[gen].mig_spr_stats.genetree_delta_lnLd[0]
@@ -2688,10 +2877,7 @@ int UpdateGB_MigSPR()
             locus_data[gen].genetree_stats_delta[1].mig_stats_delta[mig_band]
             -
             locus_data[gen].genetree_stats_delta[0].mig_stats_delta[mig_band]);
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          genetree_stats_total.mig_stats[mig_band] +=
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_MIG_STATS(mig_band)) +=
             (locus_data[gen].genetree_stats_delta[1].mig_stats_delta[mig_band]
              -
              locus_data[gen].genetree_stats_delta[0].mig_stats_delta[mig_band]);
@@ -2702,10 +2888,7 @@ int UpdateGB_MigSPR()
           genetree_stats[gen].coal_stats[pop] +=
               locus_data[gen].genetree_stats_delta[1].coal_stats_delta[pop]
               - locus_data[gen].genetree_stats_delta[0].coal_stats_delta[pop];
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          genetree_stats_total.coal_stats[pop] +=
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_COAL_STATS(pop)) +=
               (locus_data[gen].genetree_stats_delta[1].coal_stats_delta[pop]
                - locus_data[gen].genetree_stats_delta[0].coal_stats_delta[pop])
               / heredity_factor;
@@ -2718,41 +2901,60 @@ int UpdateGB_MigSPR()
 #ifdef LOG_STEPS
         fprintf(ioSetup.debugFile, "rejecting.\n");
 #endif
-        // remove all added migration events
-        if (res >= 0)
-        {
-          removeEvent(gen, locus_data[gen].mig_spr_stats.father_event_new);
-        }
-        for (i = 0; i < locus_data[gen].mig_spr_stats.num_new_migs; i++)
-        {
-          removeEvent(gen, locus_data[gen].mig_spr_stats.new_migs_in[i]);
-          removeEvent(gen, locus_data[gen].mig_spr_stats.new_migs_out[i]);
-        }
-        // return reduced lineage to all events of original edge
-        for( i = 0;
-             i < locus_data[gen].genetree_stats_delta[0].num_changed_events();
-             ++i )
-        {
-          Event* pChangedEvent =
-              locus_data[gen].genetree_stats_delta[0].changed_events[i];
-          pChangedEvent->incrementLineages();
-          //event = locus_data[gen].genetree_stats_delta[0].changed_events[i];
-          //event_chains[gen].events[event].incrementLineages();
-        }
-        revertToSaved(dataState.lociData[gen]);
+        rejectMigSPR(gen, res);
       }
     } // end for(node)
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    accepted += local_accepted;
+    stopLocusTimer(gen, locusStartTime);
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_ACCEPTED) += local_accepted;
+    addLocusProposals(gen, 2 * dataSetup.numSamples - 2, local_accepted);
   } // end for(gen)
 
+  reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataState.dataLogLikelihood);
+  reduceLocusPartialSums(LOCUS_SUM_LNLD, &dataState.logLikelihood);
+  accepted = (int) reduceLocusPartialSums(LOCUS_SUM_ACCEPTED, nullptr);
+  reduceGenetreeStatsTotal();
+
   return (accepted);
 }
 /** end of UpdateGB_MigSPR **/
 
 
+/******************************************************************************
+ *	rejectMigSPR
+ *	- reverts all changes made to a given locus by tracing a lineage (calls to
+ *	  traceLineage with reconnect = 0 and then 1), when SPR is rejected
+ *	- res is the value returned by traceLineage with reconnect = 1
+ *****************************************************************************/
+void rejectMigSPR(int gen, int res)
+{
+  int i;
+
+  // remove all added migration events
+  if (res >= 0)
+  {
+    removeEvent(gen, locus_data[gen].mig_spr_stats.father_event_new);
+  }
+  for (i = 0; i < locus_data[gen].mig_spr_stats.num_new_migs; i++)
+  {
+    removeEvent(gen, locus_data[gen].mig_spr_stats.new_migs_in[i]);
+    removeEvent(gen, locus_data[gen].mig_spr_stats.new_migs_out[i]);
+  }
+  // return reduced lineage to all events of original edge
+  for( i = 0;
+       i < locus_data[gen].genetree_stats_delta[0].num_changed_events();
+       ++i )
+  {
+    Event* pChangedEvent =
+        locus_data[gen].genetree_stats_delta[0].changed_events[i];
+    pChangedEvent->incrementLineages();
+    //event = locus_data[gen].genetree_stats_delta[0].changed_events[i];
+    //event_chains[gen].events[event].incrementLineages();
+  }
+  revertToSaved(dataState.lociData[gen]);
+}
+/** end of rejectMigSPR **/
+
+
 /******************************************************************************
  *	UpdateTheta
  *	- perturbs all population thetas
@@ -2762,6 +2964,7 @@ int UpdateGB_MigSPR()
 int UpdateTheta(double finetune)
 {
   int pop, gen, accepted = 0;
+  int numThreads = beginParallelMove(MOVE_THETA, dataSetup.numLoci);
   double thetaold, thetanew, c, lnc, lnacceptance;
 
   double deltaLogLikelihood;
@@ -2806,9 +3009,7 @@ int UpdateTheta(double finetune)
       fprintf(ioSetup.debugFile, "accepting.\n");
 #endif
       accepted++;
-#ifdef THREAD_UpdateTheta
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
       for (gen = 0; gen < dataSetup.numLoci; gen++)
       {
         locus_data[gen].genLogLikelihood -= (
@@ -2842,6 +3043,7 @@ int UpdateMigRates(double finetune)
 {
 
   int mig_band, gen, accepted = 0;
+  int numThreads = beginParallelMove(MOVE_MIG_RATE, dataSetup.numLoci);
   double old_rate, new_rate, c, lnc, lnacceptance, deltaLogLikelihood;
 
   if (finetune <= 0.0)
@@ -2915,9 +3117,7 @@ int UpdateMigRates(double finetune)
 #endif
       accepted++;
 
-#ifdef THREAD_UpdateMigRates
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
       for (gen = 0; gen < dataSetup.numLoci; gen++)
       {
         locus_data[gen].genLogLikelihood += (
@@ -2938,6 +3138,32 @@ int UpdateMigRates(double finetune)
 }
 /** end of UpdateMigRates **/
 
+/******************************************************************************
+ *	allocAffectedMigBands
+ *	- allocates (zeroed) arrays of migration bands affected by a change in
+ *	  a population age, with their start/end indicators and new ages (each
+ *	  band may have both its start and end time changed)
+ *	- all arrays are freed by freeing *new_band_ages
+ *****************************************************************************/
+static void allocAffectedMigBands(int **affected_mig_bands, int **start_or_end,
+                                  double **new_band_ages)
+{
+  int size = 2 * dataSetup.popTree->numMigBands;
+  char *arrays = (char*)calloc(1, size * (2 * sizeof(int) + sizeof(double)) + 1);
+
+  if (arrays == nullptr)
+  {
+    fprintf(stderr, "\nError: Out Of Memory affected migration bands.\n");
+    exit(-1);
+  }
+  *new_band_ages = (double*)arrays;
+  *affected_mig_bands = (int*)(arrays + size * sizeof(double));
+  *start_or_end = *affected_mig_bands + size;
+}
+/** end of allocAffectedMigBands **/
+
+
+
 /******************************************************************************
  *	UpdateTau
  *	- perturbs ancestral population ages
@@ -2952,15 +3178,15 @@ void UpdateTau(double *finetunes, int *accepted)
   extern int checkEventChainsLight();
   extern int checkAffectedMigBandsInGen(int, const int*, const int*, int);
 
-  int k, ancestralPop, gen;
+  int k, ancestralPop, gen, locusIdx;
+  int numThreads = beginParallelMove(MOVE_TAU, dataSetup.numLoci);
   int ntj[2];
   double tauold, taunew, taub[2], taufactor[2];
   double lnacceptance = 0; //, lnLd;
 
   int num_affected_mig_bands;
-  int affected_mig_bands[MAX_MIG_BANDS];
-  int start_or_end[MAX_MIG_BANDS];
-  double new_band_ages[MAX_MIG_BANDS];
+  int *affected_mig_bands, *start_or_end;
+  double *new_band_ages;
   int mig_band;
   double dataDeltaLnLd, genDeltaLnLd;
 
@@ -2970,8 +3196,7 @@ void UpdateTau(double *finetunes, int *accepted)
   int mig_conflict = 0;
   //UNUSED unsigned short didAccept = 0;
 
-  bzero(start_or_end, MAX_MIG_BANDS*sizeof(int));
-  bzero(affected_mig_bands, MAX_MIG_BANDS*sizeof(int));
+  allocAffectedMigBands(&affected_mig_bands, &start_or_end, &new_band_ages);
 
   for( ancestralPop = dataSetup.popTree->numCurPops;
        ancestralPop < dataSetup.popTree->numPops;
@@ -3228,13 +3453,13 @@ void UpdateTau(double *finetunes, int *accepted)
      *
      */
 
-#ifdef THREAD_UpdateTau
 #pragma omp parallel for private(gen) shared(mig_conflict, \
                                              start_or_end)\
-         schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-    for (gen = 0; gen < dataSetup.numLoci; gen++)
+         schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+    for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
     {
+      gen = SCHEDULED_LOCUS(locusIdx);
+      long long locusStartTime = startLocusTimer();
       double age_mt, new_age_mt;
       double genDeltaLnLd_mt = 0, dataDeltaLnLd_mt = 0;
       int sourcePop_mt, targetPop_mt, fatherNode_mt, inode_mt;
@@ -3553,14 +3778,8 @@ void UpdateTau(double *finetunes, int *accepted)
 					ntj_gen1[1] = ntj_gen[1];
 #endif
 
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          ntj[0] += ntj_gen1[0];
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          ntj[1] += ntj_gen1[1];
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_NTJ_BELOW) += ntj_gen1[0];
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_NTJ_ABOVE) += ntj_gen1[1];
 
           if (ntj_gen1[0] + ntj_gen1[1])
           {
@@ -3569,18 +3788,18 @@ void UpdateTau(double *finetunes, int *accepted)
                 dataState.lociData[gen], /*reuse old conditionals*/ 1);
           }
 
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          genDeltaLnLd += genDeltaLnLd_mt;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          dataDeltaLnLd += dataDeltaLnLd_mt;
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_GEN_LNLD) += genDeltaLnLd_mt;
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) += dataDeltaLnLd_mt;
         }
       }
+      stopLocusTimer(gen, locusStartTime);
     }            // end for(gen) - genealogy updates by rubberband
 
+    ntj[0] += (int) reduceLocusPartialSums(LOCUS_SUM_NTJ_BELOW, nullptr);
+    ntj[1] += (int) reduceLocusPartialSums(LOCUS_SUM_NTJ_ABOVE, nullptr);
+    reduceLocusPartialSums(LOCUS_SUM_GEN_LNLD, &genDeltaLnLd);
+    reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataDeltaLnLd);
+
     lnacceptance += dataDeltaLnLd + genDeltaLnLd + ntj[0] * log(taufactor[0]) +
                     ntj[1] * log(taufactor[1]);
 
@@ -3607,17 +3826,8 @@ void UpdateTau(double *finetunes, int *accepted)
       fprintf(ioSetup.debugFile, "accepting.\n");
 #endif
       // UNUSED      didAccept = 1;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       accepted[ancestralPop]++;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       dataState.dataLogLikelihood += dataDeltaLnLd;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       dataState.logLikelihood +=
           (dataDeltaLnLd + genDeltaLnLd) / dataSetup.numLoci;
 
@@ -3629,11 +3839,10 @@ void UpdateTau(double *finetunes, int *accepted)
        *
        */
       gen = 0;
-#ifdef THREAD_UpdateTau
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-      for (gen = 0; gen < dataSetup.numLoci; gen++)
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+      for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
       {
+        gen = SCHEDULED_LOCUS(locusIdx);
         int dummy = 0;
         locus_data[gen].genLogLikelihood +=
                                          locus_data[gen].genDeltaLogLikelihood;
@@ -3712,9 +3921,7 @@ void UpdateTau(double *finetunes, int *accepted)
       {
         //							printf("(migration conflict at gen %d)\n",gen);
         misc_stats.rubberband_mig_conflicts++;
-#ifdef THREAD_UpdateTau
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
         for (gen = 0; gen < dataSetup.numLoci; gen++)
         {
           if (locus_data[gen].mig_conflict_log == 1)
@@ -3727,9 +3934,7 @@ void UpdateTau(double *finetunes, int *accepted)
       }
       else
       {
-#ifdef THREAD_UpdateTau
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
         // start from gen before last and redo changes
         for (gen = dataSetup.numLoci - 1; gen >= 0; --gen)
         {
@@ -3740,6 +3945,9 @@ void UpdateTau(double *finetunes, int *accepted)
       }
     }
   }          // end of for(ancestralPop)
+
+  reduceGenetreeStatsTotal();
+  free(new_band_ages);
 }
 /** end of UpdateTau **/
 
@@ -3756,22 +3964,23 @@ void UpdateTau(double *finetunes, int *accepted)
 void UpdateSampleAge(double *finetunes, int *accepted)
 {
 
-  int k = 0, pop, gen;
+  int k = 0, pop, gen, locusIdx;
+  int numThreads = beginParallelMove(MOVE_SAMPLE_AGE, dataSetup.numLoci);
   int ntj[2];
   double tauold, taunew, taub[2], taufactor[2];
   double lnacceptance = 0;
 
   int mig_conflict = 0;
   int num_affected_mig_bands = 0;
-  int affected_mig_bands[MAX_MIG_BANDS];
-  int start_or_end[MAX_MIG_BANDS];
-  double new_band_ages[MAX_MIG_BANDS];
+  int *affected_mig_bands, *start_or_end;
+  double *new_band_ages;
   int mig_band;
   double age = 0.0;
   double dataDeltaLnLd, genDeltaLnLd;
 
   int targetPop;
 
+  allocAffectedMigBands(&affected_mig_bands, &start_or_end, &new_band_ages);
 
   for (pop = 0; pop < dataSetup.popTree->numCurPops; pop++)
   {
@@ -3889,13 +4098,13 @@ void UpdateSampleAge(double *finetunes, int *accepted)
     ntj[0] = ntj[1] = 0;
     //-------------------------------------------------------------------------
     // implement rubberband on all gen genealogies
-#ifdef THREAD_UpdateSampleAge
 #pragma omp parallel for private(gen) \
                          shared(mig_conflict, ntj, new_band_ages) \
-                         schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-    for( gen = 0; gen < dataSetup.numLoci; ++gen )
+                         schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+    for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
     {
+      gen = SCHEDULED_LOCUS(locusIdx);
+      long long locusStartTime = startLocusTimer();
       double dataDeltaLnLd_mt = 0.0;
       double genDeltaLnLd_mt = 0.0;
 
@@ -4170,30 +4379,24 @@ void UpdateSampleAge(double *finetunes, int *accepted)
           ntj_gen1[1] = ntj_gen[1];
 #endif
 
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          ntj[0] += ntj_gen1[0];
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          ntj[1] += ntj_gen1[1];
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_NTJ_BELOW) += ntj_gen1[0];
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_NTJ_ABOVE) += ntj_gen1[1];
 
           dataDeltaLnLd_mt -= getLocusDataLikelihood(dataState.lociData[gen]);
           dataDeltaLnLd_mt += computeLocusDataLikelihood(
               dataState.lociData[gen], /*reuse old conditionals*/ 1);
 
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          dataDeltaLnLd += dataDeltaLnLd_mt;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          genDeltaLnLd += genDeltaLnLd_mt;
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) += dataDeltaLnLd_mt;
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_GEN_LNLD) += genDeltaLnLd_mt;
         }
       }
+      stopLocusTimer(gen, locusStartTime);
     } // end for(gen) - genealogy updates by rubberband
+
+    ntj[0] += (int) reduceLocusPartialSums(LOCUS_SUM_NTJ_BELOW, nullptr);
+    ntj[1] += (int) reduceLocusPartialSums(LOCUS_SUM_NTJ_ABOVE, nullptr);
+    reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataDeltaLnLd);
+    reduceLocusPartialSums(LOCUS_SUM_GEN_LNLD, &genDeltaLnLd);
     //-------------------------------------------------------------------------
 
     lnacceptance += dataDeltaLnLd + genDeltaLnLd + ntj[0] * log(taufactor[0]) +
@@ -4221,24 +4424,17 @@ void UpdateSampleAge(double *finetunes, int *accepted)
       fprintf(ioSetup.debugFile, "accepting.\n");
 #endif
       ++accepted[pop];
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       dataState.dataLogLikelihood += dataDeltaLnLd;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       dataState.logLikelihood +=
           (dataDeltaLnLd + genDeltaLnLd) / dataSetup.numLoci;
 
 
 
       //-----------------------------------------------------------------------
-#ifdef THREAD_UpdateSampleAge
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-      for (gen = 0; gen < dataSetup.numLoci; gen++)
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+      for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
       {
+        gen = SCHEDULED_LOCUS(locusIdx);
         int i = 0;
         int dummy = 0;
         int mig = -1;
@@ -4302,9 +4498,7 @@ void UpdateSampleAge(double *finetunes, int *accepted)
       {
         //printf("(migration conflict at gen %d)\n",gen);
         ++misc_stats.rubberband_mig_conflicts;
-#ifdef THREAD_UpdateSampleAge
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
         for( gen = 0; gen < dataSetup.numLoci; ++gen )
         {
           if( locus_data[gen].mig_conflict_log == 1 )
@@ -4317,9 +4511,7 @@ void UpdateSampleAge(double *finetunes, int *accepted)
       else
       {
         // start from gen before last and redo changes
-#ifdef THREAD_UpdateSampleAge
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
         for( gen = dataSetup.numLoci - 1; gen >= 0; --gen )
         {
           // redo changes in events for migrations and mig bands.
@@ -4330,6 +4522,8 @@ void UpdateSampleAge(double *finetunes, int *accepted)
     }
   }// end of for(pop)
 
+  reduceGenetreeStatsTotal();
+  free(new_band_ages);
 }
 /** end of UpdateSampleAge **/
 
@@ -4339,29 +4533,56 @@ void UpdateSampleAge(double *finetunes, int *accepted)
  *	UpdateLocusRate
  *	- perturbs locus-specific mutation rates
  *	- for now does not estimate heredity multipliers !!!
- *	- reference genealogy is the first one (arbitrarily)
- *	- for each locus other than referencw, changes rate and changes rate
- *	  of reference accordingly (to maintain an average rate of 1)
+ *	- loci are split into disjoint random pairs (one locus is left out when
+ *	  the number of loci is odd). for each pair, changes rate of first locus
+ *	  and changes rate of second locus accordingly (to maintain an average
+ *	  rate of 1)
+ *	- pairs are updated in parallel, and each locus is recomputed at most once
  *	- this step affects data likelihood
  *	- this step does not affect any of the recorded statistics
+ *	- returns number of accepted proposals (out of numLoci/2)
  *****************************************************************************/
 int UpdateLocusRate(double finetune)
 {
-  int accepted = 0, gen, genRateRef = mcmcSetup.genRateRef;
-  double lnacceptance, lnLd;
-  double rold, rnew, rrefold, rrefnew;
-  //	double hold, hnew;
-  //	double delta_lnLd, factor;
-  //	int pop;
+  int accepted = 0, gen, i, pair, numPairs = dataSetup.numLoci / 2;
+  int numThreads;
+  int* pairedLoci;
 
-  if (finetune <= 0.0)
+  if (finetune <= 0.0 || numPairs == 0)
   {
     return 0;
   }
 
-  for (gen = 0; gen < dataSetup.numLoci; gen++)
+  // draw random pairing of loci (random permutation, paired consecutively)
+  pairedLoci = (int*)malloc(dataSetup.numLoci * sizeof(int));
+  if (pairedLoci == nullptr)
+  {
+    fprintf(stderr, "\nError: Out Of Memory pairedLoci in UpdateLocusRate.\n");
+    exit(-1);
+  }
+  for (i = 0; i < dataSetup.numLoci; i++)
+  {
+    pairedLoci[i] = i;
+  }
+  for (i = dataSetup.numLoci - 1; i > 0; i--)
+  {
+    int j = (int)(rndu(RAND_GENERAL_SLOT) * (i + 1));
+    int tmp = pairedLoci[i];
+    if (j > i) j = i;
+    pairedLoci[i] = pairedLoci[j];
+    pairedLoci[j] = tmp;
+  }
+
+  numThreads = beginParallelMove(MOVE_LOCUS_RATE, dataSetup.numLoci);
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+  for (pair = 0; pair < numPairs; pair++)
   {
-    if (gen == genRateRef) continue;
+    int genRateRef = pairedLoci[2 * pair + 1];
+    double lnacceptance, lnLd;
+    double rold, rnew, rrefold, rrefnew;
+    long long locusStartTime;
+
+    gen = pairedLoci[2 * pair];
     rrefold = getLocusMutationRate(dataState.lociData[genRateRef]);
     rold = getLocusMutationRate(dataState.lociData[gen]);
     rnew = rold + finetune * rnd2normal8(gen);
@@ -4385,10 +4606,14 @@ int UpdateLocusRate(double finetune)
     // compute delta in log likelihood of gen and reference gen
     lnLd = -(getLocusDataLikelihood(dataState.lociData[gen]) +
              getLocusDataLikelihood(dataState.lociData[genRateRef]));
+    locusStartTime = startLocusTimer();
     lnLd += computeLocusDataLikelihood(
         dataState.lociData[gen], /*recompute from scratch*/ 0);
+    stopLocusTimer(gen, locusStartTime);
+    locusStartTime = startLocusTimer();
     lnLd += computeLocusDataLikelihood(
         dataState.lociData[genRateRef], /*recompute from scratch*/ 0);
+    stopLocusTimer(genRateRef, locusStartTime);
 
     lnacceptance += lnLd;
 
@@ -4400,14 +4625,15 @@ int UpdateLocusRate(double finetune)
 #ifdef LOG_STEPS
       fprintf(ioSetup.debugFile, "accepting.\n");
 #endif
-      accepted++;
-      dataState.dataLogLikelihood += lnLd;
-      dataState.logLikelihood += lnLd / dataSetup.numLoci;
-      resetSaved(dataState.lociData[gen]);
-      resetSaved(dataState.lociData[genRateRef]);
-      dataState.rateVar +=
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_ACCEPTED) += 1;
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) += lnLd;
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_LNLD) += lnLd / dataSetup.numLoci;
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_RATE_VAR) +=
           (rnew * rnew + rrefnew * rrefnew - rold * rold - rrefold * rrefold) /
           dataSetup.numLoci;
+      resetSaved(dataState.lociData[gen]);
+      resetSaved(dataState.lociData[genRateRef]);
+      addLocusProposals(gen, 1, 1);
     }
     else
     {
@@ -4418,8 +4644,15 @@ int UpdateLocusRate(double finetune)
       setLocusMutationRate(dataState.lociData[genRateRef], rrefold);
       revertToSaved(dataState.lociData[gen]);
       revertToSaved(dataState.lociData[genRateRef]);
+      addLocusProposals(gen, 1, 0);
     }
-  }    // end of for(gen)
+  }    // end of for(pair)
+  free(pairedLoci);
+
+  accepted = (int) reduceLocusPartialSums(LOCUS_SUM_ACCEPTED, nullptr);
+  reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataState.dataLogLikelihood);
+  reduceLocusPartialSums(LOCUS_SUM_LNLD, &dataState.logLikelihood);
+  reduceLocusPartialSums(LOCUS_SUM_RATE_VAR, &dataState.rateVar);
   return (accepted);
 }
 /** end of UpdateLocusRate **/
@@ -4439,7 +4672,8 @@ int mixing(double finetune)
 {
   double xold, xnew, c, lnc, lnacceptance, dataDeltaLnLd, genDeltaLnLd;
 
-  int gen, mig_band = 0, pop = 0, num_events;
+  int gen, locusIdx, mig_band = 0, pop = 0, num_events;
+  int numThreads = beginParallelMove(MOVE_MIXING, dataSetup.numLoci);
   // a flag which indicates if found any issue that results
   // in a-priori rejection
   unsigned short rejectIssue = 0;
@@ -4537,18 +4771,17 @@ int mixing(double finetune)
   if (!rejectIssue)
   {
     // adjust all gen genealogies
-#ifdef THREAD_mixing
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-    for (gen = 0; gen < dataSetup.numLoci; gen++)
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+    for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
     {
+      gen = SCHEDULED_LOCUS(locusIdx);
+      long long locusStartTime = startLocusTimer();
       // scale age of nodes and compute delta likelihood
-      double dataDeltaLnLd_mt = scaleAllNodeAges(dataState.lociData[gen], c);
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-      dataDeltaLnLd += dataDeltaLnLd_mt;
+      LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_DATA_LNLD) +=
+          scaleAllNodeAges(dataState.lociData[gen], c);
+      stopLocusTimer(gen, locusStartTime);
     }
+    reduceLocusPartialSums(LOCUS_SUM_DATA_LNLD, &dataDeltaLnLd);
 
     lnacceptance += (dataDeltaLnLd + genDeltaLnLd);
 
@@ -4562,11 +4795,10 @@ int mixing(double finetune)
       fprintf(ioSetup.debugFile, "accepting.\n");
 #endif
 
-#ifdef THREAD_mixing
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
-      for (gen = 0; gen < dataSetup.numLoci; gen++)
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+      for (locusIdx = 0; locusIdx < dataSetup.numLoci; locusIdx++)
       {
+        gen = SCHEDULED_LOCUS(locusIdx);
         resetSaved(dataState.lociData[gen]);
         int mig = -1, mig_band_mt = 0, pop_mt = 0, i = 0;
         for (i = 0; i < genetree_migs[gen].num_migs; i++)
@@ -4607,13 +4839,7 @@ int mixing(double finetune)
       {
         genetree_stats_total.mig_stats[mig_band] *= c;
       }
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       dataState.dataLogLikelihood += dataDeltaLnLd;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
       dataState.logLikelihood +=
           (dataDeltaLnLd + genDeltaLnLd) / dataSetup.numLoci;
       adjustRootEvents();
@@ -4628,9 +4854,7 @@ int mixing(double finetune)
 #endif
   if (!rejectIssue)
   {
-#ifdef THREAD_mixing
-#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY)
-#endif
+#pragma omp parallel for private(gen) schedule(static) num_threads(numThreads) if(numThreads > 1)
     for (gen = 0; gen < dataSetup.numLoci; gen++)
     {
       revertToSaved(dataState.lociData[gen]);
@@ -92,10 +92,13 @@ void printUsage(char *programName);
 int processAlignments();
 int readRateFile(const char* fileName);
 int initLociWithoutData();
+int initializeMCMC();
+int openStatsStream(FILE *file, void (*printHeader)(FILE *), int maxStats);
 void printParamVals(double paramVals[], int startParam, int endParam, FILE* o);
 int recordTypes();
 int recordParamVals(double paramVals[]);
 int performMCMC();
+void checkConditionalPrecision(int iteration);
 void printGenealogyAndExit(int gen, int errStatus);
 int freeAllMemory();
 
@@ -103,6 +106,7 @@ int freeAllMemory();
 int UpdateGB_InternalNode(double finetune);  // step 1: update coalescent times
 int UpdateGB_MigrationNode(double finetune); // step 2: update migration times
 int UpdateGB_MigSPR();                       // step 3: update genealogy struct
+void rejectMigSPR(int gen, int res);         //         revert rejected SPR
 int UpdateTheta(double finetune);            // step 4: No to MT
 int UpdateMigRates(double finetune);         // step 5: No to MT,
                                              //         update migration bands
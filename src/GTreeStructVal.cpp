@@ -12,6 +12,7 @@ extern DATA_SETUP  dataSetup;
 extern Locus_SuperStruct*   locus_data;
 
 #include "GPhoCS.h"
+#include "MultiCoreUtils.h"
 extern DATA_STATE dataState;
 //-----------------------------------------------------------------------------
 int checkGtreeStructure_dispatch_check_event_chain(
@@ -396,6 +397,10 @@ int checkGtreeStructure(int gen)
   // essentially follow the same path as procedure computeGenetreeStats,
   // but validates with genetree nodes
 
+  stack_vars.living_mig_bands.resize(dataSetup.popTree->numMigBands);
+  stack_vars.pop_queue.resize(dataSetup.popTree->numPops);
+  stack_vars.pop_lins_in.resize(dataSetup.popTree->numPops);
+
   // initialize number of in-lineages for leaf pops and order pops
   for(pop=0; pop<dataSetup.popTree->numPops; pop++)
   {
@@ -408,7 +413,7 @@ int checkGtreeStructure(int gen)
   //     pop_lins_in[ nodePops[gen][node] ]++;
   // }
   popPostOrder(dataSetup.popTree, dataSetup.popTree->rootPop,
-               stack_vars.pop_queue);
+               stack_vars.pop_queue.data());
 
   // --- Check event chain per population
   for( i = 0; i < dataSetup.popTree->numPops; ++i )
@@ -759,15 +764,50 @@ int checkGtreeStructure(int gen)
   return res;
 }
 //-----------------------------------------------------------------------------
-/* checkAll()
-   invokes checkGtreeStructure on all loci and checks genetree_stats_total
-   also checks data log likelihood
+/* checkLoci()
+   invokes checkGtreeStructure and checks data log likelihood (by recomputing
+   it) on numChecked loci, starting at firstLocus and wrapping around.
+   these expensive checks run in parallel over loci; the first failing locus
+   is reported after the parallel loop.
+   then checks recorded genealogy log likelihood of all loci, and
+   genetree_stats_total and total log likelihoods (using recorded values)
 */
-int checkAll() {
-  int gen, mig_band, pop, heredity_factor, res = 1;
+int checkLoci(int firstLocus, int numChecked) {
+  int gen, locusIdx, mig_band, pop, heredity_factor, res = 1;
+  int failedLocus = 0, failedLocusIdx, failedStructure = 0;
+  int numThreads;
   double PERCISION = 0.0000001;
   double lnLd_gen, genLnLd, dataLnLd;
 
+  numChecked = min2(numChecked, dataSetup.numLoci);
+  failedLocusIdx = numChecked;
+  numThreads = beginParallelMove(MOVE_CHECKS, numChecked);
+#pragma omp parallel for private(gen) schedule(THREAD_SCHEDULING_STRATEGY) num_threads(numThreads) if(numThreads > 1)
+  for(locusIdx=0; locusIdx<numChecked; locusIdx++) {
+    gen = (firstLocus + locusIdx) % dataSetup.numLoci;
+    int structureOK = checkGtreeStructure(gen);
+    if(!structureOK || !checkLocusDataLikelihood(dataState.lociData[gen])) {
+#pragma omp critical(checkFailedLocus)
+      {
+        if(locusIdx < failedLocusIdx) {
+          failedLocusIdx = locusIdx;
+          failedLocus = gen;
+          failedStructure = !structureOK;
+        }
+      }
+    }
+  }
+
+  if(failedLocusIdx < numChecked) {
+    if(failedStructure) {
+      fprintf(stderr, "\nError: Checking gene tree structure failed\n");
+    } else {
+      fprintf(stderr, "\nError: checking recorded likelihood for gen %d!", failedLocus);
+    }
+    printGenealogyAndExit(failedLocus,0);
+    return 0;
+  }
+
   for(pop=0; pop<dataSetup.popTree->numPops; pop++) {
     genetree_stats_total_check.num_coals[pop]  = 0;
     genetree_stats_total_check.coal_stats[pop] = 0.0;
@@ -781,19 +821,6 @@ int checkAll() {
   dataLnLd = 0.0;
 
   for(gen=0; gen<dataSetup.numLoci; gen++) {
-    if(!checkGtreeStructure(gen)) {
-      fprintf(stderr, "\nError: Checking gene tree structure failed\n");
-      printGenealogyAndExit(gen,0);
-      return 0;
-    }
-
-
-    if(!checkLocusDataLikelihood(dataState.lociData[gen])) {
-      fprintf(stderr, "\nError: checking recorded likelihood for gen %d!", gen);
-      printGenealogyAndExit(gen,0);
-      return 0;
-    }
-
     lnLd_gen = gtreeLnLikelihood(gen);
 
     if(   fabs(locus_data[gen].genLogLikelihood - lnLd_gen) > PERCISION
@@ -903,3 +930,10 @@ int checkAll() {
   return res;
 
 }
+//-----------------------------------------------------------------------------
+/* checkAll()
+   invokes checkLoci on all loci
+*/
+int checkAll() {
+  return checkLoci(0, dataSetup.numLoci);
+}
@@ -2,7 +2,10 @@
 
 #include "DataLayerConstants.h"
 
+#include <vector>
+
 int checkGtreeStructure(int gen);
+int checkLoci(int firstLocus, int numChecked);
 int checkAll();
 
 //-----------------------------------------------------------------------------
@@ -24,9 +27,10 @@ typedef struct _CheckGtreeStructureAutoVars
   double delta_t;
   double PRECISION = 0.0000000001;
 
-  int living_mig_bands[MAX_MIG_BANDS];
-  int pop_queue[2*NSPECIES-1];
-  int pop_lins_in[2*NSPECIES-1];
+  // sized by checkGtreeStructure (numMigBands, numPops, numPops)
+  std::vector<int> living_mig_bands;
+  std::vector<int> pop_queue;
+  std::vector<int> pop_lins_in;
 } CheckGtreeStructureAutoVars;
 //-----------------------------------------------------------------------------
 //============================ END OF FILE ====================================
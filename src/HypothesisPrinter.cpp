@@ -34,30 +34,33 @@ void printOneMigBandHeader(int migband, FILE *file) {
           source, target);
 }
 
-void printHypStats(int iteration, FILE *file) {
+void printHypStats(int iteration, int stream) {
 
-  fprintf(file, "%d\t", iteration);
+  TRACE_RECORD *record = beginTraceRecord(stream, iteration);
 
   for (int pop = 0; pop < dataSetup.popTree->numPops; pop++) {
-    printOnePopStats(pop, file);
+    printOnePopStats(pop, record);
   }
 
   for (int migband = 0; migband < dataSetup.popTree->numMigBands; migband++) {
-    printOneMigBandStats(migband, file);
+    printOneMigBandStats(migband, record);
   }
 
-  fprintf(file, "\n");
-  fflush(file);
+  commitTraceRecord(stream);
+}
+
+int getMaxHypStats() {
+  return dataSetup.popTree->numPops + dataSetup.popTree->numMigBands;
 }
 
-void printOnePopStats(int pop, FILE *file) {
-  fprintf(file, "%0.35f\t%d\t",
-          genetree_stats_total.coal_stats[pop],
-          genetree_stats_total.num_coals[pop]);
+void printOnePopStats(int pop, TRACE_RECORD *record) {
+  addTraceStatPair(record,
+                   genetree_stats_total.coal_stats[pop],
+                   genetree_stats_total.num_coals[pop]);
 }
 
-void printOneMigBandStats(int migband, FILE *file) {
-  fprintf(file, "%0.35f\t%d\t",
-          genetree_stats_total.mig_stats[migband],
-          genetree_stats_total.num_migs[migband]);
+void printOneMigBandStats(int migband, TRACE_RECORD *record) {
+  addTraceStatPair(record,
+                   genetree_stats_total.mig_stats[migband],
+                   genetree_stats_total.num_migs[migband]);
 }
\ No newline at end of file
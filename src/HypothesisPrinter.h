@@ -2,6 +2,7 @@
 #define G_PHOCS_HYPOTHESISPRINTER_H
 
 #include <stdio.h>
+#include "TraceWriter.h"
 
 
 void printHypStatsHeader(FILE *hypStatsFile);
@@ -10,11 +11,13 @@ void printOnePopHeader(int pop, FILE *file);
 
 void printOneMigBandHeader(int migband, FILE *file);
 
-void printHypStats(int iteration, FILE *file);
+void printHypStats(int iteration, int stream);
 
-void printOnePopStats(int pop, FILE *file);
+int getMaxHypStats();
 
-void printOneMigBandStats(int migband, FILE *file);
+void printOnePopStats(int pop, TRACE_RECORD *record);
+
+void printOneMigBandStats(int migband, TRACE_RECORD *record);
 
 
 #endif
@@ -0,0 +1,457 @@
+/**
+    \file KernelBench.cpp
+    Microbenchmarks for likelihood and genealogy kernels.
+
+    Builds synthetic loci - random genealogies under the population tree,
+    samples and migration bands of a given control file, with random alignment
+    patterns - and times individual kernels on them in isolation, reporting
+    ns/op and patterns/sec.
+
+    Built from all G-PhoCS sources other than readTrace.cpp and
+    AlignmentMain.cpp, with GPhoCS.cpp compiled with -DGPHOCS_NO_MAIN.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
+
+#include "GPhoCS.h"
+#include "MCMCcontrol.h"
+#include "LocusDataLikelihood.h"
+#include "TraceLineages.h"
+#include "AllLoci.h"
+#include "patch.h"
+#include "utils.h"
+#include "MultiCoreUtils.h"
+#include "Profiler.h"
+
+
+// number of proposed ages of a node evaluated in proposals kernels
+#define NUM_AGE_PROPOSALS 4
+
+static struct option long_options[] = {
+  {"loci",      required_argument, 0, 'l'},
+  {"patterns",  required_argument, 0, 'p'},
+  {"ops",       required_argument, 0, 'o'},
+  {"kernel",    required_argument, 0, 'k'},
+  {"help",      no_argument,       0, 'h'},
+  {0, 0, 0, 0}
+};
+
+
+/* benchmarked kernels */
+typedef enum {
+  KERNEL_LNLD_FULL = 0,
+  KERNEL_LNLD_INCREMENTAL,
+  KERNEL_AGE_PROPOSALS,
+  KERNEL_AGE_PROPOSALS_BATCH,
+  KERNEL_ADJUST_AGE,
+  KERNEL_SPR,
+  KERNEL_SCALE_AGES,
+  KERNEL_TRACE_LINEAGE,
+  KERNEL_STATS_DELTA,
+  KERNEL_COPY_INTERVALS,
+  NUM_KERNELS
+} Kernel;
+
+static const char* kernelNames[NUM_KERNELS] = {
+  "lnld-full", "lnld-incremental", "proposals", "proposals-batch", "adjust-age",
+  "spr", "scale-ages", "trace-lineage", "stats-delta", "copy-intervals"
+};
+
+static const char* kernelDescriptions[NUM_KERNELS] = {
+  "computeLocusDataLikelihood from scratch",
+  "adjustGenNodeAge + incremental computeLocusDataLikelihood + revert",
+  "NUM_AGE_PROPOSALS ages of a node, each evaluated as in lnld-incremental",
+  "NUM_AGE_PROPOSALS ages of a node, evaluated by computeNodeAgeProposals",
+  "adjustGenNodeAge + revert",
+  "executeGenSPR + revert",
+  "scaleAllNodeAges + revert",
+  "traceLineage (detach and reconnect) + revert",
+  "LocusPopIntervals::computeStatsDelta (+1 and -1 over a population)",
+  "LocusEmbeddedGenealogy::copyIntervals"
+};
+
+
+static void printKernelBenchUsage(char *programName) {
+  int kernel;
+
+  printf("Usage: %s <control-file-name> [options]\n", programName);
+  printf("Population tree, samples and migration bands are taken from control file.\n");
+  printf("-l, --loci      NUMBER    Number of synthetic loci (default 16)\n");
+  printf("-p, --patterns  NUMBER    Number of alignment patterns per locus (default 100)\n");
+  printf("-o, --ops       NUMBER    Number of operations timed per kernel (default 10000)\n");
+  printf("-k, --kernel    NAME      Run only given kernel (default all):\n");
+  for(kernel=0; kernel<NUM_KERNELS; kernel++) {
+    printf("                            %-17s %s\n", kernelNames[kernel], kernelDescriptions[kernel]);
+  }
+  printf("-h, --help                This help page\n");
+}
+
+
+
+/***********************************************************************************
+ *	initSyntheticLoci
+ *	- creates locus data for all loci with given number of random (unphased)
+ *		alignment patterns, each appearing once
+ *	- returns 0 if all OK, and -1 otherwise
+ ***********************************************************************************/
+static int initSyntheticLoci(int numPatterns) {
+  const char bases[] = "TCAG";
+  int gen, patt, sample, res;
+  char **patternArray = (char **) malloc(numPatterns * sizeof(char *));
+  char *patternSpace = (char *) malloc(numPatterns * dataSetup.numSamples * sizeof(char));
+  int *numPhasesArray = (int *) malloc(numPatterns * sizeof(int));
+  int *patternCounts = (int *) malloc(numPatterns * sizeof(int));
+
+  dataState.lociData = (LocusData **) malloc(dataSetup.numLoci * sizeof(LocusData *));
+  if(patternArray == nullptr || patternSpace == nullptr || numPhasesArray == nullptr ||
+     patternCounts == nullptr || dataState.lociData == nullptr) {
+    fprintf(stderr, "Error: Out Of Memory when allocating synthetic patterns.\n");
+    return -1;
+  }
+
+  for(patt=0; patt<numPatterns; patt++) {
+    patternArray[patt] = patternSpace + patt * dataSetup.numSamples;
+    numPhasesArray[patt] = 1;
+    patternCounts[patt] = 1;
+  }
+
+  for(gen=0; gen<dataSetup.numLoci; gen++) {
+    dataState.lociData[gen] = createLocusData(dataSetup.numSamples, 1);
+    if(dataState.lociData[gen] == nullptr) {
+      fprintf(stderr, "Error: Out Of Memory when creating locus %d.\n", gen + 1);
+      return -1;
+    }
+    if(0 != setLocusConditionalPrecision(dataState.lociData[gen], mcmcSetup.floatConditionals)) {
+      return -1;
+    }
+    for(patt=0; patt<numPatterns; patt++) {
+      for(sample=0; sample<dataSetup.numSamples; sample++) {
+        patternArray[patt][sample] = bases[(int)(4 * rndu(gen))];
+      }
+    }
+    res = initializeLocusData(dataState.lociData[gen], patternArray, numPatterns,
+                              numPhasesArray, patternCounts);
+    if(res < 0) {
+      fprintf(stderr, "Error: Unable to initialize synthetic locus %d.\n", gen + 1);
+      return -1;
+    }
+  }
+
+  closeLeafPatternIndex();
+  free(patternArray);
+  free(patternSpace);
+  free(numPhasesArray);
+  free(patternCounts);
+  return 0;
+}
+/** end of initSyntheticLoci **/
+
+
+
+/***********************************************************************************
+ *	randomNonRootNode / randomInternalNode
+ *	- return a random node of genealogy of given locus (other than root),
+ *		and a random internal node (possibly root)
+ ***********************************************************************************/
+static int randomNonRootNode(int gen) {
+  int node, root = getLocusRoot(dataState.lociData[gen]);
+
+  do {
+    node = (int)((2 * dataSetup.numSamples - 1) * rndu(gen));
+  } while(node == root);
+  return node;
+}
+
+static int randomInternalNode(int gen) {
+  return dataSetup.numSamples + (int)((dataSetup.numSamples - 1) * rndu(gen));
+}
+/** end of randomNonRootNode / randomInternalNode **/
+
+
+
+/***********************************************************************************
+ *	randomNodeAge
+ *	- returns a random age for given internal node between the ages of its
+ *		oldest son and its father (up to 10% above current age for root)
+ ***********************************************************************************/
+static double randomNodeAge(int gen, int node) {
+  LocusData *locusData = dataState.lociData[gen];
+  int father = getNodeFather(locusData, node);
+  double lower = max2(getNodeAge(locusData, getNodeSon(locusData, node, 0)),
+                      getNodeAge(locusData, getNodeSon(locusData, node, 1)));
+  double upper = (father < 0) ? 1.1 * getNodeAge(locusData, node)
+                              : getNodeAge(locusData, father);
+
+  return lower + (upper - lower) * rndu(gen);
+}
+/** end of randomNodeAge **/
+
+
+
+/***********************************************************************************
+ *	benchSPR
+ *	- executes a random (valid) SPR on genealogy of given locus and reverts it
+ ***********************************************************************************/
+static void benchSPR(int gen) {
+  LocusData *locusData = dataState.lociData[gen];
+  int node, target, ancestor, targetFather;
+  double lower, upper;
+
+  node = randomNonRootNode(gen);
+  // target branch should not be in subtree of node
+  do {
+    target = (int)((2 * dataSetup.numSamples - 1) * rndu(gen));
+    for(ancestor = target; ancestor >= 0 && ancestor != node;
+        ancestor = getNodeFather(locusData, ancestor));
+  } while(ancestor == node);
+
+  // regraft above both node and target, and below father of target
+  targetFather = getNodeFather(locusData, target);
+  if(targetFather == getNodeFather(locusData, node)) {
+    targetFather = getNodeFather(locusData, targetFather);
+  }
+  lower = max2(getNodeAge(locusData, node), getNodeAge(locusData, target));
+  upper = (targetFather < 0) ? 1.1 * lower + 1e-6 : getNodeAge(locusData, targetFather);
+
+  executeGenSPR(locusData, node, target, lower + (upper - lower) * rndu(gen));
+  revertToSaved(locusData);
+}
+/** end of benchSPR **/
+
+
+
+/***********************************************************************************
+ *	runKernelOp
+ *	- runs one operation of given kernel on given locus
+ ***********************************************************************************/
+static void runKernelOp(Kernel kernel, int gen, AllLoci *lociEmbedded) {
+  LocusData *locusData = dataState.lociData[gen];
+  int node, pop, res, i;
+  double ages[NUM_AGE_PROPOSALS], lnLds[NUM_AGE_PROPOSALS];
+
+  switch(kernel) {
+    case KERNEL_LNLD_FULL:
+      computeLocusDataLikelihood(locusData, /*useOldConditionals*/ 0);
+      resetSaved(locusData);
+      break;
+    case KERNEL_LNLD_INCREMENTAL:
+      node = randomInternalNode(gen);
+      adjustGenNodeAge(locusData, node, randomNodeAge(gen, node));
+      computeLocusDataLikelihood(locusData, /*useOldConditionals*/ 1);
+      revertToSaved(locusData);
+      break;
+    case KERNEL_AGE_PROPOSALS:
+    case KERNEL_AGE_PROPOSALS_BATCH:
+      node = randomInternalNode(gen);
+      for(i=0; i<NUM_AGE_PROPOSALS; i++) {
+        ages[i] = randomNodeAge(gen, node);
+      }
+      if(kernel == KERNEL_AGE_PROPOSALS_BATCH) {
+        computeNodeAgeProposals(locusData, node, NUM_AGE_PROPOSALS, ages, lnLds);
+        break;
+      }
+      for(i=0; i<NUM_AGE_PROPOSALS; i++) {
+        adjustGenNodeAge(locusData, node, ages[i]);
+        lnLds[i] = computeLocusDataLikelihood(locusData, /*useOldConditionals*/ 1);
+        revertToSaved(locusData);
+      }
+      break;
+    case KERNEL_ADJUST_AGE:
+      node = randomInternalNode(gen);
+      adjustGenNodeAge(locusData, node, randomNodeAge(gen, node));
+      revertToSaved(locusData);
+      break;
+    case KERNEL_SPR:
+      benchSPR(gen);
+      break;
+    case KERNEL_SCALE_AGES:
+      scaleAllNodeAges(locusData, 0.9 + 0.2 * rndu(gen));
+      revertToSaved(locusData);
+      break;
+    case KERNEL_TRACE_LINEAGE:
+      node = randomNonRootNode(gen);
+      traceLineage(gen, node, 0);
+      res = traceLineage(gen, node, 1);
+      rejectMigSPR(gen, res);
+      break;
+    case KERNEL_STATS_DELTA:
+      // all intervals of a random non-root population with at least one interval
+      {
+        LocusPopIntervals &intervals = lociEmbedded->getLocus(gen).getIntervals();
+        pop = (int)(dataSetup.popTree->numPops * rndu(gen));
+        while(pop == dataSetup.popTree->rootPop ||
+              intervals.getPopEnd(pop)->getPrev() == intervals.getPopStart(pop)) {
+          pop = (pop + 1) % dataSetup.popTree->numPops;
+        }
+        intervals.computeStatsDelta(intervals.getPopStart(pop), intervals.getPopEnd(pop)->getPrev(), 1);
+        intervals.computeStatsDelta(intervals.getPopStart(pop), intervals.getPopEnd(pop)->getPrev(), -1);
+      }
+      break;
+    case KERNEL_COPY_INTERVALS:
+      lociEmbedded->getLocus(gen).copyIntervals(true);
+      break;
+    default:
+      break;
+  }
+}
+/** end of runKernelOp **/
+
+
+
+/***********************************************************************************
+ *	totalPatternsProcessed
+ *	- returns total number of patterns processed in conditional recomputations
+ *		over all loci
+ ***********************************************************************************/
+static long long totalPatternsProcessed() {
+  long long total = 0, numNodes, numPatterns, time;
+  int gen;
+
+  for(gen=0; gen<dataSetup.numLoci; gen++) {
+    getLocusDataCosts(dataState.lociData[gen], &numNodes, &numPatterns, &time);
+    total += numPatterns;
+  }
+  return total;
+}
+/** end of totalPatternsProcessed **/
+
+
+
+/***********************************************************************************
+ *	benchKernel
+ *	- times given number of operations of a kernel (spread over all loci, after
+ *		a warm-up pass over all loci) and prints ns/op and patterns/sec
+ ***********************************************************************************/
+static void benchKernel(Kernel kernel, int numOps, AllLoci *lociEmbedded) {
+  int op;
+  long long startTime, time, patterns;
+
+  if(kernel == KERNEL_STATS_DELTA && dataSetup.popTree->numPops < 2) {
+    printf("%-17s %10s   (skipped: needs at least 2 populations)\n", kernelNames[kernel], "-");
+    return;
+  }
+
+  for(op=0; op<dataSetup.numLoci; op++) {
+    runKernelOp(kernel, op, lociEmbedded);
+  }
+
+  patterns = totalPatternsProcessed();
+  startTime = profilerNow();
+  for(op=0; op<numOps; op++) {
+    runKernelOp(kernel, op % dataSetup.numLoci, lociEmbedded);
+  }
+  time = profilerNow() - startTime;
+  patterns = totalPatternsProcessed() - patterns;
+
+  if(patterns > 0) {
+    printf("%-17s %10d %12.1f %12.1f %14.1f\n", kernelNames[kernel], numOps,
+           (double) time / numOps, (double) patterns / numOps, patterns * 1e9 / time);
+  } else {
+    printf("%-17s %10d %12.1f %12s %14s\n", kernelNames[kernel], numOps,
+           (double) time / numOps, "-", "-");
+  }
+}
+/** end of benchKernel **/
+
+
+
+int main(int argc, char *argv[]) {
+  int c, option_index, res, gen, kernel;
+  int numLoci = 16, numPatterns = 100, numOps = 10000, onlyKernel = -1;
+
+  while(1) {
+    option_index = 0;
+    c = getopt_long(argc, argv, "l:p:o:k:h", long_options, &option_index);
+    if(c == -1)
+      break;
+
+    switch(c) {
+      case 'l':
+        numLoci = atoi(optarg);
+        break;
+      case 'p':
+        numPatterns = atoi(optarg);
+        break;
+      case 'o':
+        numOps = atoi(optarg);
+        break;
+      case 'k':
+        for(kernel=0; kernel<NUM_KERNELS; kernel++) {
+          if(0 == strcmp(optarg, kernelNames[kernel]))
+            onlyKernel = kernel;
+        }
+        if(onlyKernel < 0) {
+          fprintf(stderr, "Error: unknown kernel %s.\n", optarg);
+          exit(-1);
+        }
+        break;
+      case 'h':
+        printKernelBenchUsage(argv[0]);
+        exit(0);
+      case '?':
+      default:
+        printKernelBenchUsage(argv[0]);
+        exit(-1);
+    }
+  }
+
+  if(argv[optind] == nullptr || numLoci <= 0 || numPatterns <= 0 || numOps <= 0) {
+    printKernelBenchUsage(argv[0]);
+    exit(-1);
+  }
+
+  omp_set_num_threads(1);
+  initGeneralInfo();
+  if(0 != readControlFile(argv[optind])) {
+    exit(-1);
+  }
+  popPostOrder(dataSetup.popTree, dataSetup.popTree->rootPop,
+               dataSetup.popTree->popsPostOrder);
+  res = checkSettings();
+  finalizeNumParameters();
+  if(res > 0) {
+    fprintf(stderr, "Found %d errors when processing control settings.\n", res);
+    exit(-1);
+  }
+  if(mcmcSetup.randomSeed < 0) {
+    mcmcSetup.randomSeed = 1;
+  }
+
+  dataSetup.numLoci = numLoci;
+  initRandomGenerator(dataSetup.numLoci, mcmcSetup.randomSeed);
+  if(0 != initSyntheticLoci(numPatterns)) {
+    fprintf(stderr, "Error: unable to initialize synthetic loci.\n");
+    exit(-1);
+  }
+  // loci data are moved into locus arenas
+  allocateAllMemory();
+  if(initializeMCMC() <= 0) {
+    fprintf(stderr, "Error: unable to initialize synthetic loci.\n");
+    exit(-1);
+  }
+
+  // interval chains of all loci (for stats-delta and copy-intervals)
+  AllLoci lociEmbedded;
+  constructMigBandsTimes(dataSetup.popTree);
+  for(gen=0; gen<dataSetup.numLoci; gen++) {
+    LocusEmbeddedGenealogy &locus = lociEmbedded.getLocus(gen);
+    locus.constructEmbeddedGenealogy();
+    locus.computeGenetreeStats();
+    locus.copyIntervals(true);
+  }
+
+  printf("Synthetic data: %d loci, %d samples, %d patterns per locus, %d populations, %d migration bands.\n",
+         dataSetup.numLoci, dataSetup.numSamples, numPatterns,
+         dataSetup.popTree->numPops, dataSetup.popTree->numMigBands);
+  printf("%-17s %10s %12s %12s %14s\n", "kernel", "ops", "ns/op", "patterns/op", "patterns/sec");
+  for(kernel=0; kernel<NUM_KERNELS; kernel++) {
+    if(onlyKernel < 0 || onlyKernel == kernel) {
+      benchKernel((Kernel) kernel, numOps, &lociEmbedded);
+    }
+  }
+
+  freeLocusPartialSums();
+  return 0;
+}
@@ -13,7 +13,10 @@
 #include "utils.h"
 #include <stdlib.h>
 #include <math.h>
+#include <float.h>
 #include <string.h>
+#include <string>
+#include <unordered_map>
 #include "MultiCoreUtils.h"
 
 
@@ -25,6 +28,12 @@
 
 #define CODE_SIZE	4
 
+// single-precision conditionals of a pattern are rescaled by 2^FLOAT_SCALE_BITS
+// whenever all of them fall below 2^-FLOAT_SCALE_BITS (see computeFloatConditionals)
+#define FLOAT_SCALE_BITS		32
+#define FLOAT_SCALE_FACTOR		4294967296.0f
+#define FLOAT_SCALE_THRESHOLD	(1.0f/FLOAT_SCALE_FACTOR)
+
 
 
 /***************************************************************************************************************/
@@ -43,10 +52,36 @@ typedef struct LOCUS_SEQ_DATA {
   int* patternCount;			// array (of length numPatterns) of counts for each pattern
   int* numPhases;				// number of phases per pattern
   int* patternList;			// list of relevant patterns for likelihood computations (established when computing likelihood)
+  int* leafPatternIds;		// array (of length numPatterns) of ids of patterns in shared table of leaf conditionals
+  int* constantBases;			// array (of length numPatterns) of the base of each constant pattern (-1 for other patterns)
 } LocusSeqData;
 
 
 
+/***********************************************************************************
+ *	LeafPatternTable
+ *	- Data type which holds leaf conditionals of all distinct phased patterns of all loci.
+ *		Loci refer to their patterns by id (seqData.leafPatternIds), and leaves of
+ *		genealogies hold no conditional arrays of their own.
+ *	- conditionals of leaf l for pattern p start at conditionals[CODE_SIZE*(numLeaves*p + l)]
+ *	- patternIndex maps pattern strings to ids while loci are initialized
+ *		(see closeLeafPatternIndex)
+ ***********************************************************************************/
+typedef struct LEAF_PATTERN_TABLE {
+  int numLeaves;				// number of leaves in every pattern
+  int numPatterns;			// number of distinct patterns in table
+  int maxPatterns;			// number of patterns for which space is allocated
+  double* conditionals;		// leaf conditionals of all patterns (array of length CODE_SIZE * numLeaves * maxPatterns)
+  std::unordered_map<std::string, int>* patternIndex;
+} LeafPatternTable;
+
+static LeafPatternTable leafPatterns = {0, 0, 0, nullptr, nullptr};
+
+// number of threads splitting patterns of full recomputations (see setPatternThreads)
+static int patternThreads = 1;
+
+
+
 /***********************************************************************************
  *	LikelihoodNode
  *	- Data type which holds data for computing conditional probability
@@ -56,7 +91,10 @@ typedef struct LIKELIHOOD_NODE {
   int father;							// father of node in genealogy (-1 for root)
   int leftSon, rightSon;				// sons of node in genealogy
   double age;							// age of node
-  double* conditionalProbs;			// array conditional probabilities for base assignment at node (array of length CODE_SIZE * numPatterns)
+  union {
+    double* conditionalProbs;		// array conditional probabilities for base assignment at node (array of length CODE_SIZE * numPatterns)
+    float* floatConditionals;		// same array, for locus with single-precision conditionals (scaling counts in floatScales_m)
+  };
 } LikelihoodNode;
 
 
@@ -75,6 +113,10 @@ typedef struct PREVIOUS_VERSION {
   int* changedNodeIds;				// array of ids (or indices) of nodes changed
   int numChangedConditionals;			// number of nodes whose conditional probabilities were changed
   int* changedCondIds;				// array ids (or indices) of nodes whose conditionals were changed
+  int numPathNodes;					// number of nodes in dirtyPath[]
+  int* dirtyPath;						// internal nodes whose conditionals are recomputed, in post-order (see buildDirtyPath)
+  int* pathStack;						// work stack for buildDirtyPath
+  unsigned short* pathCounts;			// work counters for buildDirtyPath (all 0 between calls)
   LikelihoodNode** savedNodes;		// an array of pointers to previous versions.
 } PreviousVersion;
 
@@ -96,11 +138,22 @@ struct LOCUS_LIKELIHOOD {
   LikelihoodNode** nodeArray;		// array of pointers to nodes
   LocusSeqData seqData;			// holds sequence data for locus
   PreviousVersion savedVersion;	// notes on changes proposed to genealogy
+
+  // cost counters (see getLocusDataCosts)
+  long long numNodeRecomputations;	// number of nodes whose conditionals were recomputed
+  long long numPatternsProcessed;	// number of patterns processed in conditional recomputations
+  long long likelihoodTime;			// time spent in computeLocusDataLikelihood (ns, only with locus profiling)
 	
+  // precision of conditionals
+  unsigned short floatConditionals;	// 1 if conditionals are stored in single precision (see setLocusConditionalPrecision)
+  int* floatScales_m;				// scaling counts of single-precision conditionals (one per node version and pattern)
+
   // pointers for allocated memory
   double* doubleArray_m;
+  float* floatArray_m;				// conditionals and scaling counts in single-precision mode
   int* intArray_m;
   LikelihoodNode* nodeArray_m;
+  char* arena_m;					// block holding structure and all arrays (see moveLocusDataToArena), or nullptr
 };
 
 
@@ -111,6 +164,8 @@ struct LOCUS_LIKELIHOOD {
 
 
 int computeConditionalJC_new (LocusData* locusData, int nodeId, int numPatterns, int* patternIds, unsigned short overideOld);
+int buildDirtyPath (LocusData* locusData, int nodeId, unsigned short overideOld);
+void computePathConditionals (LocusData* locusData, int numPatterns, int* patternIds);
 int computeConditionalJC (LocusData* locusData, int nodeId, int numPatterns, int* patternIds, unsigned short overideOld);
 double	computeEdgeConditionalJC(double edgeLength);
 int	copyNodeToSaved(LocusData* locusData, int nodeId, unsigned short recalcConditionals);
@@ -118,8 +173,18 @@ int	copyNodeConditionals(LocusData* locusData, int nodeId);
 int computeLeafConditionals(LocusData* locusData, char* patternString);
 void computeSubtreeConditionals (double* sonConditionals, double* parentConditionals, double* edgeConditionals);
 void computeSubtreeConditionals_new (double* sonConditionals, double* parentConditionals, double* edgeSubstProb);
+static inline void computeConstantConditionals_new (double* leftConditionals, double* rightConditionals, double* parentConditionals,
+                                                    int constantBase, double* leftEdgeSubstProb, double* rightEdgeSubstProb);
+void computeFloatConditionals (LocusData* locusData, LikelihoodNode* node, int leftSonId, int rightSonId,
+                               int numPatterns, int* patternIds, double* leftEdgeSubstProb, double* rightEdgeSubstProb);
+void computePatternConditionalsDouble (LocusData* locusData, int nodeId, int pattId, double* edgeSubstProbs, double* conditionals);
 int computePairwiseLCAs_rec (LocusData* locusData, int nodeId, int** lcaMatrix, int* leafArray, int arrayOffset, int* numLeaves_out);
 int getSortedAges_rec (LocusData* locusData, int nodeId, double* sortedAges, double* sortedAges_aux, int arrayOffset, int* numInternalNodes_out);
+size_t layoutLocusData (LocusData* locusData, char* block);
+static inline int* getNodeScales (LocusData* locusData, LikelihoodNode* node);
+static inline double getNodeConditional (LocusData* locusData, LikelihoodNode* node, int index);
+static inline double* getSonConditionals (LocusData* locusData, int sonId, int pattId);
+static inline double computeRootPatternLogLikelihood (LocusData* locusData, int pattId);
 
 
 
@@ -152,20 +217,25 @@ LocusData* createLocusData (int numLeaves, unsigned short hetMode) {
     return nullptr;
   }
 
-  intArray = (int*)malloc(2*numNodes*sizeof(int));
+  intArray = (int*)malloc(4*numNodes*sizeof(int));
   if(intArray == nullptr) {
     fprintf(stderr, "\nError: Out Of Memory when allocating space for locusData array of integers (for changed node ids) ");
     return nullptr;
   }
   locusData->savedVersion.changedNodeIds = intArray;
   locusData->savedVersion.changedCondIds = intArray+numNodes;
+  locusData->savedVersion.dirtyPath = intArray+2*numNodes;
+  locusData->savedVersion.pathStack = intArray+3*numNodes;
+  locusData->savedVersion.numPathNodes = 0;
 
  	
-  locusData->savedVersion.recalcConditionals = (unsigned short*)malloc(numNodes*sizeof(unsigned short));
+  // recalcConditionals[] followed by pathCounts[]
+  locusData->savedVersion.recalcConditionals = (unsigned short*)calloc(2*numNodes, sizeof(unsigned short));
   if(locusData->savedVersion.recalcConditionals == nullptr) {
     fprintf(stderr, "\nError: Out Of Memory when allocating space for locusData recalcConditionals boolean array ");
     return nullptr;
   }
+  locusData->savedVersion.pathCounts = locusData->savedVersion.recalcConditionals + numNodes;
 
 	
   // every vertex has two copies - for genealogy changes
@@ -196,11 +266,20 @@ LocusData* createLocusData (int numLeaves, unsigned short hetMode) {
   locusData->mutationRate = 1.0;
   locusData->root = -1;
   locusData->doubleArray_m = nullptr;
+  locusData->floatArray_m = nullptr;
+  locusData->floatScales_m = nullptr;
+  locusData->floatConditionals = 0;
+  locusData->intArray_m = nullptr;
+  locusData->arena_m = nullptr;
   locusData->dataLogLikelihood = 0.0;
   locusData->savedVersion.dataLogLikelihood = 0.0;
 
   locusData->seqData.numPatterns = 0;
 
+  locusData->numNodeRecomputations = 0;
+  locusData->numPatternsProcessed = 0;
+  locusData->likelihoodTime = 0;
+
   // initialize node data structures (other than conditional array
   for(node=0; node<2*numNodes; node++) {
     locusData->nodeArray_m[node].conditionalProbs = nullptr;
@@ -239,6 +318,7 @@ LocusData* createLocusData (int numLeaves, unsigned short hetMode) {
 int initializeLocusData(LocusData* locusData, char** patternArray, int numPatterns, int* numPhases, int* patternCounts)	{
 	
   int node, patt, unphasedPatt;
+  int internalNode, numInternalNodes;
 	
   // auxiliary arrays
   char *patternString;
@@ -248,13 +328,26 @@ int initializeLocusData(LocusData* locusData, char** patternArray, int numPatter
   //	printf("Initializing locus data likelihood with %d patterns.\n",numPatterns);
 	
   // allocate seqData memory (pattern frequencies, conditional arrays, and numPhases)
-  locusData->doubleArray_m = (double*)malloc(2*(2*locusData->numLeaves-1)*CODE_SIZE*numPatterns*sizeof(double));
-  if(locusData->doubleArray_m == nullptr) {
-    fprintf(stderr, "\nError: Out Of Memory when allocating space for locusData array of doubles (for conditional probabilities of genealogy nodes) in initializeLocusData().\n");
-    return -1;
+  // leaf conditionals are kept in shared table of leaf patterns (see computeLeafConditionals),
+  // so conditional arrays are allocated only for the numLeaves-1 internal nodes
+  numInternalNodes = locusData->numLeaves-1;
+  if(locusData->floatConditionals) {
+    // single-precision conditionals, followed by scaling counts
+    locusData->floatArray_m = (float*)malloc(2*numInternalNodes*numPatterns*(CODE_SIZE*sizeof(float) + sizeof(int)));
+    if(locusData->floatArray_m == nullptr) {
+      fprintf(stderr, "\nError: Out Of Memory when allocating space for locusData array of floats (for conditional probabilities of genealogy nodes) in initializeLocusData().\n");
+      return -1;
+    }
+    locusData->floatScales_m = (int*)(locusData->floatArray_m + 2*numInternalNodes*CODE_SIZE*numPatterns);
+  } else {
+    locusData->doubleArray_m = (double*)malloc(2*numInternalNodes*CODE_SIZE*numPatterns*sizeof(double));
+    if(locusData->doubleArray_m == nullptr) {
+      fprintf(stderr, "\nError: Out Of Memory when allocating space for locusData array of doubles (for conditional probabilities of genealogy nodes) in initializeLocusData().\n");
+      return -1;
+    }
   }
 	
-  locusData->intArray_m = (int*)malloc(numPatterns*3*sizeof(int));
+  locusData->intArray_m = (int*)malloc(numPatterns*5*sizeof(int));
   if(locusData->intArray_m == nullptr) {
     fprintf(stderr, "\nError: Out Of Memory when alloating space for locusData->intArray_m in initializeLocusData().\n");
     return -1;
@@ -262,10 +355,18 @@ int initializeLocusData(LocusData* locusData, char** patternArray, int numPatter
   locusData->seqData.numPhases = locusData->intArray_m;
   locusData->seqData.patternList = locusData->intArray_m + numPatterns;
   locusData->seqData.patternCount = locusData->intArray_m + 2*numPatterns;
-
-  for(node=0; node < 2*locusData->numLeaves-1; node++) {
-    locusData->nodeArray[node]->conditionalProbs = locusData->doubleArray_m + (2*node)*numPatterns*CODE_SIZE;
-    locusData->savedVersion.savedNodes[node]->conditionalProbs = locusData->doubleArray_m + (2*node+1)*numPatterns*CODE_SIZE;
+  locusData->seqData.leafPatternIds = locusData->intArray_m + 3*numPatterns;
+  locusData->seqData.constantBases = locusData->intArray_m + 4*numPatterns;
+
+  for(node=locusData->numLeaves; node < 2*locusData->numLeaves-1; node++) {
+    internalNode = node - locusData->numLeaves;
+    if(locusData->floatConditionals) {
+      locusData->nodeArray[node]->floatConditionals = locusData->floatArray_m + (2*internalNode)*numPatterns*CODE_SIZE;
+      locusData->savedVersion.savedNodes[node]->floatConditionals = locusData->floatArray_m + (2*internalNode+1)*numPatterns*CODE_SIZE;
+    } else {
+      locusData->nodeArray[node]->conditionalProbs = locusData->doubleArray_m + (2*internalNode)*numPatterns*CODE_SIZE;
+      locusData->savedVersion.savedNodes[node]->conditionalProbs = locusData->doubleArray_m + (2*internalNode+1)*numPatterns*CODE_SIZE;
+    }
   }
 
   // initialize leaf conditionals for hom patterns
@@ -312,7 +413,15 @@ int initializeLocusData(LocusData* locusData, char** patternArray, int numPatter
  ***********************************************************************************/
 int freeLocusData (LocusData* locusData) {
 	
+  // memory of locus moved to arena is freed by owner of arena
+  // (other than double-precision conditionals allocated by useDoubleConditionals)
+  if(locusData->arena_m != nullptr) {
+    if(locusData->floatArray_m != nullptr && locusData->doubleArray_m != nullptr) free(locusData->doubleArray_m);
+    return 0;
+  }
+
   if(locusData->doubleArray_m != nullptr) free(locusData->doubleArray_m);
+  if(locusData->floatArray_m != nullptr) free(locusData->floatArray_m);
   if(locusData->intArray_m != nullptr) free(locusData->intArray_m);
   free(locusData->nodeArray);
   free(locusData->nodeArray_m);
@@ -327,6 +436,79 @@ int freeLocusData (LocusData* locusData) {
 
 
 
+/***********************************************************************************
+ *	getLocusDataArenaSize
+ *	- returns the number of bytes needed to hold the LocusData structure and all
+ *		its arrays (including conditionals) in a single block
+ ***********************************************************************************/
+size_t getLocusDataArenaSize (LocusData* locusData) {
+  return layoutLocusData(locusData, nullptr);
+}
+/** end of getLocusDataArenaSize **/
+
+
+
+/***********************************************************************************
+ *	moveLocusDataToArena
+ *	- moves locus data into given (cache-line aligned) block of
+ *		getLocusDataArenaSize bytes and frees its previous memory
+ * 	- returns a pointer to the moved structure.
+ ***********************************************************************************/
+LocusData* moveLocusDataToArena (LocusData* locusData, char* block) {
+  LocusData* newData = (LocusData*)block;
+
+  layoutLocusData(locusData, block);
+  freeLocusData(locusData);
+  newData->arena_m = block;
+
+  return newData;
+}
+/** end of moveLocusDataToArena **/
+
+
+
+/***********************************************************************************
+ *	closeLeafPatternIndex
+ *	- frees index of shared leaf patterns (used only to find repeated patterns
+ *		while loci are initialized). no loci may be initialized after this call.
+ * 	- returns the number of distinct leaf patterns in table
+ ***********************************************************************************/
+int closeLeafPatternIndex () {
+  delete leafPatterns.patternIndex;
+  leafPatterns.patternIndex = nullptr;
+  return leafPatterns.numPatterns;
+}
+/** end of closeLeafPatternIndex **/
+
+
+
+/***********************************************************************************
+ *	freeLeafPatterns
+ *	- frees shared table of leaf patterns (after all loci are freed)
+ ***********************************************************************************/
+void freeLeafPatterns () {
+  closeLeafPatternIndex();
+  free(leafPatterns.conditionals);
+  leafPatterns.conditionals = nullptr;
+  leafPatterns.numLeaves = leafPatterns.numPatterns = leafPatterns.maxPatterns = 0;
+}
+/** end of freeLeafPatterns **/
+
+
+
+/***********************************************************************************
+ *	setPatternThreads
+ *	- sets number of threads splitting pattern range of full recomputations of
+ *		conditionals (see computeConditionalJC_new)
+ ***********************************************************************************/
+void setPatternThreads (int numThreads) {
+  patternThreads = (numThreads > 1) ? numThreads : 1;
+}
+/** end of setPatternThreads **/
+
+
+
+
 /***********************************************************************************
  *	attachLeaf - UNUSED
  *	- attaches a leaf to existing sub-genealogy
@@ -384,6 +566,44 @@ double getLocusMutationRate (LocusData* locusData)	{
 /** end of getLocusMutationRate **/
 
 
+
+/***********************************************************************************
+ *	setLocusConditionalPrecision
+ *	- sets whether conditionals of locus are stored in single precision (useFloat = 1)
+ *		or in double precision (useFloat = 0, default)
+ *	- with single precision, conditionals of each pattern are rescaled to avoid
+ *		underflow, and likelihoods at root are summed (and logged) in double
+ *	- should be called before initializeLocusData
+ *	- returns 0 if all OK, and -1 otherwise
+ ***********************************************************************************/
+int setLocusConditionalPrecision (LocusData* locusData, unsigned short useFloat)	{
+#ifndef OPT1
+  if(useFloat) {
+    fprintf(stderr, "\nError: single-precision conditionals are supported only with OPT1 likelihood computation.\n");
+    return -1;
+  }
+#endif
+  if(locusData->doubleArray_m != nullptr || locusData->floatArray_m != nullptr) {
+    fprintf(stderr, "\nError: precision of conditionals should be set before locus data is initialized.\n");
+    return -1;
+  }
+  locusData->floatConditionals = useFloat;
+  return 0;
+}
+/** end of setLocusConditionalPrecision **/
+
+
+
+/***********************************************************************************
+ *	getLocusConditionalPrecision
+ *	- returns 1 if conditionals of locus are stored in single precision, and 0 otherwise
+ ***********************************************************************************/
+int getLocusConditionalPrecision (LocusData* locusData)	{
+  return locusData->floatConditionals;
+}
+/** end of getLocusConditionalPrecision **/
+
+
 /***********************************************************************************
  *	computeAllConditionals
  *	- computes all conditional likelihoods at all nodes of tree under all patterns
@@ -426,10 +646,12 @@ int computeAllConditionals (LocusData* locusData)  {
 double computeLocusDataLikelihood( LocusData* locusData,
                                    unsigned short useOldConditionals)  {
   int res, node;
-  int  patt, pattId, phase, numLivePatterns, conditional, numConditionals;
-  double prob;
+  int  patt, pattId, phase, numLivePatterns;
+  long long startTime;
 	
   if(locusData->seqData.numLivePatterns == 0) return 0.0;
+
+  startTime = startLocusCostTimer();
 	
   if(!useOldConditionals) {
     for(node = locusData->numLeaves; node < 2*locusData->numLeaves-1; node++) {
@@ -462,7 +684,10 @@ res = computeConditionalJC(locusData, locusData->root, numLivePatterns, locusDat
 #endif
 	
 
-  if(!res)	return locusData->dataLogLikelihood;
+  if(!res) {
+    stopLocusCostTimer(&locusData->likelihoodTime, startTime);
+    return locusData->dataLogLikelihood;
+  }
 	
   locusData->dataLogLikelihood = 0.0; 
 	
@@ -471,15 +696,11 @@ res = computeConditionalJC(locusData, locusData->root, numLivePatterns, locusDat
   // sum over root conditionals assuming uniform distribution at root
   for(patt=0; patt<numLivePatterns; patt+=locusData->seqData.numPhases[pattId]) {
     pattId = locusData->seqData.patternList[patt];
-    prob = 0.0;
-    numConditionals = CODE_SIZE*locusData->seqData.numPhases[pattId];
-    for(conditional=0; conditional<numConditionals; conditional++) {
-      prob += locusData->nodeArray[ locusData->root ]->conditionalProbs[pattId*CODE_SIZE+conditional];
-    }
-    locusData->dataLogLikelihood += log(prob/numConditionals) * locusData->seqData.patternCount[pattId];
+    locusData->dataLogLikelihood += computeRootPatternLogLikelihood(locusData, pattId) * locusData->seqData.patternCount[pattId];
   }
 	
   //	printf("new likelihood is %g.\n",locusData->dataLogLikelihood);
+  stopLocusCostTimer(&locusData->likelihoodTime, startTime);
   return locusData->dataLogLikelihood;
 }
 /** end of computeLocusDataLikelihood **/
@@ -499,16 +720,7 @@ double computePatternLogLikelihood (LocusData* locusData, int numPatterns, int*
   double logLikelihood = 0.0;
 
 	for (patt = 0; patt < numPatterns; patt++) {
-		int  conditional;
-		int pattId = patternIds[patt];
-		double prob = 0.0;
-		int numConditionals = CODE_SIZE * locusData->seqData.numPhases[pattId];
-		for (conditional = 0; conditional < numConditionals; conditional++) {
-			prob +=
-					locusData->nodeArray[locusData->root]->conditionalProbs[pattId
-							* CODE_SIZE + conditional];
-		}
-		logLikelihood += log(prob / numConditionals) * patternCounts[patt];
+		logLikelihood += computeRootPatternLogLikelihood(locusData, patternIds[patt]) * patternCounts[patt];
 	}
 	
   return logLikelihood;
@@ -518,6 +730,168 @@ double computePatternLogLikelihood (LocusData* locusData, int numPatterns, int*
 /** end of computePatternLogLikelihood **/
 
 
+
+
+/***********************************************************************************
+ *	computeNodeAgeProposals
+ *	- computes log-likelihood of data for several proposed ages of a single node
+ *		(all other ages unchanged), in a single pass over the path from node to root
+ *	- patterns are processed one by one for all proposals together, so conditionals
+ *		of sons and of siblings along the path are read once for all proposals
+ *	- results are identical to those of adjustGenNodeAge and computeLocusDataLikelihood
+ *	- does not modify locus data (should be called when no change is pending)
+ *	- loci with single-precision conditionals evaluate proposals one by one
+ *	- writes log-likelihood for each of numProposals ages in lnLds[]
+ *	- returns 0 if all OK, and -1 otherwise
+ ***********************************************************************************/
+int computeNodeAgeProposals (LocusData* locusData, int nodeId, int numProposals, double* ages, double* lnLds)	{
+  int prop, level, depth, base, pattId, phase, child, sibling, numConditionals;
+  int numNodes = 2*locusData->numLeaves-1;
+  unsigned short isLeaf = (nodeId < locusData->numLeaves);
+  unsigned short useSibling;
+  int* path;
+  double edgeLength, probSum, probSumTimesSubst;
+  double *scratch, *sonEdges, *upEdges, *pathEdges, *siblingEdges, *conditionals, *probs, *sonConditionals;
+  double siblingFactors[CODE_SIZE];
+  LikelihoodNode* node = locusData->nodeArray[nodeId];
+
+  for(prop=0; prop<numProposals; prop++) {
+    lnLds[prop] = 0.0;
+  }
+  if(locusData->seqData.numLivePatterns == 0 || numProposals <= 0)
+    return 0;
+
+#ifdef OPT1
+  if(locusData->floatConditionals)
+#endif
+  {
+    for(prop=0; prop<numProposals; prop++) {
+      adjustGenNodeAge(locusData, nodeId, ages[prop]);
+      lnLds[prop] = computeLocusDataLikelihood(locusData, /*useOldConditionals*/ 1);
+      revertToSaved(locusData);
+    }
+    return 0;
+  }
+
+  path = (int*)malloc(numNodes*sizeof(int));
+  scratch = (double*)malloc(((4 + 2 + CODE_SIZE + 1)*numProposals + 4*numNodes)*sizeof(double));
+  if(path == nullptr || scratch == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory when allocating space for evaluation of node age proposals.\n");
+    free(path);
+    free(scratch);
+    return -1;
+  }
+  sonEdges = scratch;									// left and right son edges of each proposal
+  upEdges = sonEdges + 4*numProposals;				// edge above node, for each proposal
+  conditionals = upEdges + 2*numProposals;			// conditionals along path, for each proposal
+  probs = conditionals + CODE_SIZE*numProposals;		// pattern probabilities, for each proposal
+  pathEdges = probs + numProposals;					// edge above each node on path (levels > 0)
+  siblingEdges = pathEdges + 2*numNodes;				// edge above sibling of each node on path
+
+  // path from node to root, and substitution probabilities of all edges involved
+  for(depth=0, path[0]=nodeId; path[depth] != locusData->root; depth++) {
+    path[depth+1] = locusData->nodeArray[ path[depth] ]->father;
+  }
+  depth++;
+  for(prop=0; prop<numProposals; prop++) {
+    if(!isLeaf) {
+      edgeLength = locusData->mutationRate * (ages[prop] - locusData->nodeArray[ node->leftSon ]->age);
+      sonEdges[4*prop] = computeEdgeConditionalJC(edgeLength);
+      sonEdges[4*prop+1] = 1 - 4.0*sonEdges[4*prop];
+      edgeLength = locusData->mutationRate * (ages[prop] - locusData->nodeArray[ node->rightSon ]->age);
+      sonEdges[4*prop+2] = computeEdgeConditionalJC(edgeLength);
+      sonEdges[4*prop+3] = 1 - 4.0*sonEdges[4*prop+2];
+    }
+    if(depth > 1) {
+      edgeLength = locusData->mutationRate * (locusData->nodeArray[ path[1] ]->age - ages[prop]);
+      upEdges[2*prop] = computeEdgeConditionalJC(edgeLength);
+      upEdges[2*prop+1] = 1 - 4.0*upEdges[2*prop];
+    }
+  }
+  for(level=1; level<depth; level++) {
+    child = path[level-1];
+    sibling = (locusData->nodeArray[ path[level] ]->leftSon == child) ? locusData->nodeArray[ path[level] ]->rightSon : locusData->nodeArray[ path[level] ]->leftSon;
+    edgeLength = locusData->mutationRate * (locusData->nodeArray[ path[level] ]->age - locusData->nodeArray[child]->age);
+    pathEdges[2*level] = computeEdgeConditionalJC(edgeLength);
+    pathEdges[2*level+1] = 1 - 4.0*pathEdges[2*level];
+    edgeLength = locusData->mutationRate * (locusData->nodeArray[ path[level] ]->age - locusData->nodeArray[sibling]->age);
+    siblingEdges[2*level] = computeEdgeConditionalJC(edgeLength);
+    siblingEdges[2*level+1] = 1 - 4.0*siblingEdges[2*level];
+  }
+
+  for(pattId=0; pattId<locusData->seqData.numPatterns; pattId++) {
+    if(locusData->seqData.patternCount[pattId] == 0)		continue;
+    for(prop=0; prop<numProposals; prop++) {
+      probs[prop] = 0.0;
+    }
+
+    for(phase=0; phase<locusData->seqData.numPhases[pattId]; phase++) {
+      // conditionals of node
+      for(prop=0; prop<numProposals; prop++) {
+        for(base=0; base<CODE_SIZE; base++)  {
+          conditionals[CODE_SIZE*prop + base] = isLeaf ? getSonConditionals(locusData, nodeId, pattId+phase)[base] : 1.0;
+        }
+        if(!isLeaf) {
+          computeSubtreeConditionals_new(getSonConditionals(locusData, node->leftSon, pattId+phase), conditionals + CODE_SIZE*prop, sonEdges + 4*prop);
+          computeSubtreeConditionals_new(getSonConditionals(locusData, node->rightSon, pattId+phase), conditionals + CODE_SIZE*prop, sonEdges + 4*prop + 2);
+        }
+      }
+
+      // conditionals of ancestors (as in computeSubtreeConditionals_new, with
+      // contribution of sibling computed once for all proposals)
+      for(level=1; level<depth; level++) {
+        child = path[level-1];
+        sibling = (locusData->nodeArray[ path[level] ]->leftSon == child) ? locusData->nodeArray[ path[level] ]->rightSon : locusData->nodeArray[ path[level] ]->leftSon;
+        sonConditionals = getSonConditionals(locusData, sibling, pattId+phase);
+        probSum = sonConditionals[0] + sonConditionals[1] + sonConditionals[2] + sonConditionals[3];
+        useSibling = (probSum < CODE_SIZE);
+        probSumTimesSubst = probSum * siblingEdges[2*level];
+        for(base=0; base<CODE_SIZE; base++)  {
+          siblingFactors[base] = probSumTimesSubst + sonConditionals[base]*siblingEdges[2*level+1];
+        }
+
+        for(prop=0; prop<numProposals; prop++) {
+          double* edge = (level == 1) ? upEdges + 2*prop : pathEdges + 2*level;
+          sonConditionals = conditionals + CODE_SIZE*prop;
+          probSum = sonConditionals[0] + sonConditionals[1] + sonConditionals[2] + sonConditionals[3];
+          if(probSum >= CODE_SIZE) {
+            for(base=0; base<CODE_SIZE; base++)  {
+              sonConditionals[base] = useSibling ? siblingFactors[base] : 1.0;
+            }
+            continue;
+          }
+          probSumTimesSubst = probSum * edge[0];
+          for(base=0; base<CODE_SIZE; base++)  {
+            sonConditionals[base] = probSumTimesSubst + sonConditionals[base]*edge[1];
+            if(useSibling)		sonConditionals[base] *= siblingFactors[base];
+          }
+        }
+      }
+
+      // sum over root conditionals (in order of computeRootPatternLogLikelihood)
+      for(prop=0; prop<numProposals; prop++) {
+        for(base=0; base<CODE_SIZE; base++)  {
+          probs[prop] += conditionals[CODE_SIZE*prop + base];
+        }
+      }
+    }// end of for(phase)
+
+    numConditionals = CODE_SIZE*locusData->seqData.numPhases[pattId];
+    for(prop=0; prop<numProposals; prop++) {
+      lnLds[prop] += log(probs[prop]/numConditionals) * locusData->seqData.patternCount[pattId];
+    }
+  }// end of for(pattId)
+
+  locusData->numNodeRecomputations += (long long)numProposals*depth;
+  locusData->numPatternsProcessed += (long long)numProposals*depth*locusData->seqData.numLivePatterns;
+
+  free(path);
+  free(scratch);
+  return 0;
+}
+/** end of computeNodeAgeProposals **/
+
+
 /***********************************************************************************
  *	!!!!!FOR DEBUGGING !!!!!
  ***********************************************************************************/
@@ -566,15 +940,14 @@ double computeLocusDataLikelihood_deb (LocusData* locusData, unsigned short useO
   // sum over root conditionals assuming uniform distribution at root
   for(patt=0; patt<numLivePatterns; patt+=locusData->seqData.numPhases[pattId]) {
     pattId = locusData->seqData.patternList[patt];
-    prob = 0.0;
     numConditionals = CODE_SIZE*locusData->seqData.numPhases[pattId];
     printf("pattern %d accumulative conditional:",pattId+1);
     for(conditional=0; conditional<numConditionals; conditional++) {
-      prob += locusData->nodeArray[ locusData->root ]->conditionalProbs[pattId*CODE_SIZE+conditional];
-      printf(" %g",locusData->nodeArray[ locusData->root ]->conditionalProbs[pattId*CODE_SIZE+conditional]);
+      prob = getNodeConditional(locusData, locusData->nodeArray[ locusData->root ], pattId*CODE_SIZE+conditional);
+      printf(" %g",prob);
     }
     printf("\n");
-    locusData->dataLogLikelihood += log(prob/numConditionals) * (double)locusData->seqData.patternCount[pattId];
+    locusData->dataLogLikelihood += computeRootPatternLogLikelihood(locusData, pattId) * (double)locusData->seqData.patternCount[pattId];
   }
 	
   //	printf("new likelihood is %g.\n",locusData->dataLogLikelihood);
@@ -717,7 +1090,8 @@ double reduceSitePatterns (LocusData* locusData, int numPatterns, int* patternId
  ***********************************************************************************/
 int checkLocusDataLikelihood (LocusData* locusData) {
   int node,   numConditionals;
-  double *savedConds, *newConds;
+  LikelihoodNode *savedNode, *newNode;
+  double savedCond, newCond;
 	
   computeLocusDataLikelihood (locusData,/*do not use old conditionals*/ 0);
 	
@@ -732,22 +1106,23 @@ int checkLocusDataLikelihood (LocusData* locusData) {
          locusData->savedVersion.dataLogLikelihood,locusData->dataLogLikelihood,locusData->savedVersion.dataLogLikelihood-locusData->dataLogLikelihood);
   printf("Checking conditionals...\n");
 
-  for(node=0; node<2*locusData->numLeaves-1; node++) {
-    savedConds = locusData->savedVersion.savedNodes[node]->conditionalProbs;
-    newConds   = locusData->nodeArray[node]->conditionalProbs;
+  // (leaf conditionals are shared and never recomputed)
+  for(node=locusData->numLeaves; node<2*locusData->numLeaves-1; node++) {
+    savedNode = locusData->savedVersion.savedNodes[node];
+    newNode   = locusData->nodeArray[node];
     int patt = 0, conditional = 0;
     for(	patt=0; 
             patt<locusData->seqData.numPatterns; 
-            patt+=locusData->seqData.numPhases[patt], 
-              savedConds+=numConditionals, 
-              newConds+=numConditionals) {
+            patt+=locusData->seqData.numPhases[patt]) {
 			
       numConditionals = CODE_SIZE*locusData->seqData.numPhases[patt];
       if(locusData->seqData.patternCount[patt] == 0)		continue;
       for(conditional=0; conditional<numConditionals; conditional++) {
-        if( newConds[conditional] != savedConds[conditional]) {
+        savedCond = getNodeConditional(locusData, savedNode, CODE_SIZE*patt + conditional);
+        newCond   = getNodeConditional(locusData, newNode, CODE_SIZE*patt + conditional);
+        if( newCond != savedCond) {
           printf("Inconsistent conditionals in node %d, patt %d, phased base %d (saved %g, recomputed %g).\n", 
-                 node, patt, conditional, savedConds[conditional], newConds[conditional]);
+                 node, patt, conditional, savedCond, newCond);
         }
       }
     }
@@ -761,6 +1136,109 @@ int checkLocusDataLikelihood (LocusData* locusData) {
 
 
 
+/***********************************************************************************
+ *	checkLocusConditionalPrecision
+ *	- re-computes log-likelihood of data at a locus with single-precision conditionals
+ *		in double precision (pattern by pattern, without modifying locus data)
+ *	- returns the absolute deviation of recorded log-likelihood from the
+ *		double-precision one (0 for locus with double-precision conditionals)
+ ***********************************************************************************/
+double checkLocusConditionalPrecision (LocusData* locusData)	{
+  int node, pattId, phase, base, numNodes = 2*locusData->numLeaves-1;
+  double edgeLength, prob, logLikelihood = 0.0;
+  double *edgeSubstProbs, *conditionals;
+
+  if(!locusData->floatConditionals || locusData->seqData.numLivePatterns == 0)
+    return 0.0;
+
+  edgeSubstProbs = (double*)malloc((2 + CODE_SIZE)*numNodes*sizeof(double));
+  if(edgeSubstProbs == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory when allocating space for precision check of locus data.\n");
+    exit(-1);
+  }
+  conditionals = edgeSubstProbs + 2*numNodes;
+
+  for(node=0; node<numNodes; node++) {
+    if(node == locusData->root)		continue;
+    edgeLength = locusData->mutationRate * (locusData->nodeArray[ locusData->nodeArray[node]->father ]->age - locusData->nodeArray[node]->age);
+    edgeSubstProbs[2*node] = computeEdgeConditionalJC(edgeLength);
+    edgeSubstProbs[2*node+1] = 1 - 4.0*edgeSubstProbs[2*node];
+  }
+
+  for(pattId=0; pattId<locusData->seqData.numPatterns; pattId+=locusData->seqData.numPhases[pattId]) {
+    if(locusData->seqData.patternCount[pattId] == 0)		continue;
+    prob = 0.0;
+    for(phase=0; phase<locusData->seqData.numPhases[pattId]; phase++) {
+      computePatternConditionalsDouble(locusData, locusData->root, pattId+phase, edgeSubstProbs, conditionals);
+      for(base=0; base<CODE_SIZE; base++) {
+        prob += conditionals[CODE_SIZE*locusData->root + base];
+      }
+    }
+    logLikelihood += log(prob/(CODE_SIZE*locusData->seqData.numPhases[pattId])) * locusData->seqData.patternCount[pattId];
+  }
+
+  free(edgeSubstProbs);
+  return fabs(logLikelihood - locusData->dataLogLikelihood);
+}
+/** end of checkLocusConditionalPrecision **/
+
+
+
+/***********************************************************************************
+ *	useDoubleConditionals
+ *	- switches locus with single-precision conditionals to double precision
+ *		(fall back when checkLocusConditionalPrecision finds large deviations)
+ *	- allocates double-precision conditionals (of internal nodes), and recomputes
+ *		all conditionals and the log-likelihood
+ *	- should be called only when no change is pending (saved version was reset)
+ *	- returns the delta in log-likelihood
+ ***********************************************************************************/
+double useDoubleConditionals (LocusData* locusData)	{
+  int node, patt, pattId, numNodes = 2*locusData->numLeaves-1;
+  int numPatterns = locusData->seqData.numPatterns;
+  double oldLnLd = locusData->dataLogLikelihood;
+  float* floatConditionals;
+
+  if(!locusData->floatConditionals)
+    return 0.0;
+
+  locusData->doubleArray_m = (double*)malloc(2*(locusData->numLeaves-1)*CODE_SIZE*numPatterns*sizeof(double));
+  if(locusData->doubleArray_m == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory when allocating space for locusData array of doubles (for conditional probabilities of genealogy nodes) in useDoubleConditionals().\n");
+    exit(-1);
+  }
+
+  // conditionals keep their offsets in new array (leaves have none)
+  for(node=0; node<2*numNodes; node++) {
+    floatConditionals = locusData->nodeArray_m[node].floatConditionals;
+    if(floatConditionals == nullptr)		continue;
+    locusData->nodeArray_m[node].conditionalProbs = locusData->doubleArray_m + (floatConditionals - locusData->floatArray_m);
+  }
+  locusData->floatConditionals = 0;
+
+  // recompute conditionals of internal nodes under all patterns
+  for(patt=0; patt<numPatterns; patt++) {
+    locusData->seqData.patternList[patt] = patt;
+  }
+  if(numPatterns > 0) {
+    computeConditionalJC_new(locusData, locusData->root, numPatterns, locusData->seqData.patternList, /*overrideOld=*/ 1);
+  }
+
+  // sum over root conditionals of live patterns
+  locusData->dataLogLikelihood = 0.0;
+  for(pattId=0; pattId<numPatterns; pattId++) {
+    if(locusData->seqData.patternCount[pattId] > 0) {
+      locusData->dataLogLikelihood += computeRootPatternLogLikelihood(locusData, pattId) * locusData->seqData.patternCount[pattId];
+    }
+  }
+  locusData->savedVersion.dataLogLikelihood = locusData->dataLogLikelihood;
+
+  return locusData->dataLogLikelihood - oldLnLd;
+}
+/** end of useDoubleConditionals **/
+
+
+
 /***********************************************************************************
  *	revertToSaved
  *	- reverts locus data structure (genealogy and conditional likelihoods) to saved version
@@ -1144,24 +1622,23 @@ void printLocusDataPatterns(LocusData* locusData, FILE* outFile)	{
   static const char baseSymbols[] = "TCAGYKWSMRN";
 
   int leaf, patt, base, ambigSize, firstBase, secondBase, phase;
-  double sumConds;
-  double* leafConditionals;
+  double sumConds, leafConditional;
   char ch;
 	
 	
   fprintf(outFile,"\n%d phased patterns:",locusData->seqData.numPatterns);
 	
   for(leaf=0; leaf<locusData->numLeaves; leaf++) {
-    leafConditionals = locusData->nodeArray[leaf]->conditionalProbs;
     fprintf(outFile,"\n%5d",leaf+1);
-    for(patt=0; patt<locusData->seqData.numPatterns; patt++, leafConditionals += CODE_SIZE) {
+    for(patt=0; patt<locusData->seqData.numPatterns; patt++) {
       ambigSize = 0;
       firstBase = secondBase = -1;
       sumConds = 0.0;
 			
       for(base=0; base<CODE_SIZE; base++) {
-        sumConds += leafConditionals[base];
-        if(leafConditionals[base] > 0.0) {
+        leafConditional = getSonConditionals(locusData, leaf, patt)[base];
+        sumConds += leafConditional;
+        if(leafConditional > 0.0) {
           ambigSize++;
           if(firstBase < 0)		firstBase = base;
           else if(secondBase < 0)	secondBase = base;
@@ -1261,6 +1738,33 @@ double getLocusDataLikelihood (LocusData* locusData){
 
 
 
+/***********************************************************************************
+ *	getLocusNumLivePatterns
+ *	- returns the number of patterns relevant for likelihood computation
+ ***********************************************************************************/
+int getLocusNumLivePatterns (LocusData* locusData){
+  return locusData->seqData.numLivePatterns;
+}
+/** end of getLocusNumLivePatterns **/
+
+
+
+/***********************************************************************************
+ *	getLocusDataCosts
+ *	- returns cost counters of likelihood computations for locus: number of nodes
+ *		whose conditionals were recomputed, number of patterns processed in these
+ *		recomputations, and time spent in computeLocusDataLikelihood (ns, counted
+ *		only when locus profiling is on - see Profiler.h)
+ ***********************************************************************************/
+void getLocusDataCosts (LocusData* locusData, long long* numNodeRecomputations, long long* numPatternsProcessed, long long* likelihoodTime){
+  *numNodeRecomputations = locusData->numNodeRecomputations;
+  *numPatternsProcessed = locusData->numPatternsProcessed;
+  *likelihoodTime = locusData->likelihoodTime;
+}
+/** end of getLocusDataCosts **/
+
+
+
 /***********************************************************************************
  *	getLocusRoot
  *	- returns the root node id
@@ -1321,16 +1825,69 @@ int getNodeSon (LocusData* locusData, int nodeId, unsigned short son)	{
  * 	- note that this is done before sampling begins (when data structure is initialized)
  * 		and these conditionals remain untouched after this point.
  * 	- we allow only nucleotide, het-ambiguity symbols or 'N' characters in a pattern (11 possibilities total)
- *	- saves same values in "saved conditionals array" - these do not change
+ *	- conditionals are kept in shared table of leaf patterns, and computed only for
+ *		patterns not already in table (entered by this or another locus). the locus
+ *		records the id of the pattern in table (seqData.leafPatternIds).
+ *	- constant patterns (a single base in all leaves with data) are marked with
+ *		their base in seqData.constantBases (see computeConstantConditionals_new).
+ *		patterns with missing data in all leaves are marked as constant with base 0.
  *	- returns 0, if all OK and -1, if bad pattern
  ***********************************************************************************/
 int computeLeafConditionals(LocusData* locusData, char* patternString)	{
-  int leaf, base;
-  double *conditionals, *conditionalsForSaved;
+  static const char baseSymbols[] = "TCAG";
+  int leaf, base, constantBase, maxPatterns;
+  double* conditionals;
+  double* newTable;
+  std::unordered_map<std::string, int>::iterator pattIter;
+
+  // find base of constant pattern (-1 for all missing, and -2 for non-constant patterns)
+  constantBase = -1;
+  for(leaf=0; leaf<locusData->numLeaves && constantBase > -2; leaf++) {
+    if(patternString[leaf] == 'N')		continue;
+    for(base=0; base<CODE_SIZE && baseSymbols[base] != patternString[leaf]; base++);
+    if(base == CODE_SIZE || (constantBase >= 0 && base != constantBase))
+      constantBase = -2;
+    else
+      constantBase = base;
+  }
+  locusData->seqData.constantBases[locusData->seqData.numPatterns] = (constantBase == -1) ? 0 : (constantBase < 0) ? -1 : constantBase;
+
+  if(leafPatterns.patternIndex == nullptr) {
+    if(leafPatterns.numPatterns > 0) {
+      fprintf(stderr, "\nError: computeLeafConditionals: index of leaf patterns was closed before all loci were initialized.\n");
+      return -1;
+    }
+    leafPatterns.patternIndex = new std::unordered_map<std::string, int>();
+    leafPatterns.numLeaves = locusData->numLeaves;
+  }
+  if(locusData->numLeaves != leafPatterns.numLeaves) {
+    fprintf(stderr, "\nError: computeLeafConditionals: locus has %d leaves, while other loci have %d.\n",
+            locusData->numLeaves, leafPatterns.numLeaves);
+    return -1;
+  }
+
+  std::string pattKey(patternString, locusData->numLeaves);
+  pattIter = leafPatterns.patternIndex->find(pattKey);
+  if(pattIter != leafPatterns.patternIndex->end()) {
+    locusData->seqData.leafPatternIds[locusData->seqData.numPatterns] = pattIter->second;
+    locusData->seqData.numPatterns++;
+    return 0;
+  }
+
+  // new pattern - make room for it in table
+  if(leafPatterns.numPatterns == leafPatterns.maxPatterns) {
+    maxPatterns = (leafPatterns.maxPatterns == 0) ? 1024 : 2*leafPatterns.maxPatterns;
+    newTable = (double*)realloc(leafPatterns.conditionals, (size_t)maxPatterns*leafPatterns.numLeaves*CODE_SIZE*sizeof(double));
+    if(newTable == nullptr) {
+      fprintf(stderr, "\nError: Out Of Memory when allocating space for shared table of leaf conditionals.\n");
+      return -1;
+    }
+    leafPatterns.conditionals = newTable;
+    leafPatterns.maxPatterns = maxPatterns;
+  }
 
   for(leaf=0; leaf<locusData->numLeaves; leaf++) {
-    conditionals = locusData->nodeArray[leaf]->conditionalProbs + locusData->seqData.numPatterns * CODE_SIZE;
-    conditionalsForSaved = locusData->savedVersion.savedNodes[leaf]->conditionalProbs + locusData->seqData.numPatterns * CODE_SIZE;
+    conditionals = leafPatterns.conditionals + CODE_SIZE*(leafPatterns.numLeaves*leafPatterns.numPatterns + leaf);
     for(base=0; base<CODE_SIZE; base++) {
       conditionals[base] = 0.0;
     }
@@ -1390,15 +1947,13 @@ int computeLeafConditionals(LocusData* locusData, char* patternString)	{
       fprintf(stderr, "\nError: Unexpected character '%c' for leaf %d in pattern.\n",leaf, patternString[leaf]);
       return -1;
     }// end of switch
-    // copy conditionals to saved
-    for(base=0; base<CODE_SIZE; base++) {
-      conditionalsForSaved[base] = conditionals[base];
-    }
-		
   }// end of for(leaf)
 
 
-  // advance number of patterns in locus
+  // add pattern to table and advance number of patterns in locus
+  (*leafPatterns.patternIndex)[pattKey] = leafPatterns.numPatterns;
+  locusData->seqData.leafPatternIds[locusData->seqData.numPatterns] = leafPatterns.numPatterns;
+  leafPatterns.numPatterns++;
   locusData->seqData.numPatterns++;
   return 0;
 }
@@ -1444,6 +1999,8 @@ int computeConditionalJC (LocusData* locusData, int nodeId, int numPatterns, int
   if(!overideOld) {
     copyNodeConditionals(locusData,nodeId);
   }
+  locusData->numNodeRecomputations++;
+  locusData->numPatternsProcessed += numPatterns;
 
 	
   leftSon = locusData->nodeArray[ node->leftSon ];
@@ -1466,9 +2023,9 @@ int computeConditionalJC (LocusData* locusData, int nodeId, int numPatterns, int
       node->conditionalProbs[CODE_SIZE*pattId + base] = 1.0;
     }
     //		printf("edge (%d,%d)", nodeId,node->leftSon);
-    computeSubtreeConditionals(&(leftSon->conditionalProbs[CODE_SIZE*pattId]),&(node->conditionalProbs[CODE_SIZE*pattId]),leftEdgeConditionalProb);
+    computeSubtreeConditionals(getSonConditionals(locusData, node->leftSon, pattId),&(node->conditionalProbs[CODE_SIZE*pattId]),leftEdgeConditionalProb);
     //		printf(", edge (%d,%d)", nodeId,node->rightSon);
-    computeSubtreeConditionals(&(rightSon->conditionalProbs[CODE_SIZE*pattId]),&(node->conditionalProbs[CODE_SIZE*pattId]),rightEdgeConditionalProb);
+    computeSubtreeConditionals(getSonConditionals(locusData, node->rightSon, pattId),&(node->conditionalProbs[CODE_SIZE*pattId]),rightEdgeConditionalProb);
     //		printf(".\n");
   }
                
@@ -1550,97 +2107,192 @@ void computeSubtreeConditionals (double* sonConditionals, double* parentConditio
 
 
 
+/***********************************************************************************
+ *	buildDirtyPath
+ *	- lists in savedVersion.dirtyPath[] the internal nodes whose conditionals
+ *		computeConditionalJC_new has to compute, in post-order (sons before fathers)
+ *	- if overideOld == 1, lists all internal nodes of subtree rooted at nodeId.
+ *		otherwise, lists all nodes changed since the last reset (changedCondIds[]:
+ *		nodes marked by adjustGenNodeAge, executeGenSPR and earlier computations)
+ *		and their ancestors, so work is proportional to the length of the changed
+ *		paths and not to the size of the genealogy. nodeId must then be the root.
+ *	- ancestors are found after the change is made (SPR moves subtrees), by
+ *		walking up father pointers until reaching a node already on the path.
+ *		pathCounts[] holds 1 + number of sons on path not yet listed.
+ *	- no recursion and no allocation
+ *	- returns number of nodes in path
+ ***********************************************************************************/
+int buildDirtyPath (LocusData* locusData, int nodeId, unsigned short overideOld)		{
+  PreviousVersion* saved = &locusData->savedVersion;
+  LikelihoodNode* node;
+  int i, father, numDirty, stackSize = 0;
+
+  saved->numPathNodes = 0;
+
+  if(overideOld) {
+    // reversed pre-order (node, right son, left son) is a post-order
+    if(nodeId < locusData->numLeaves)
+      return 0;
+    saved->pathStack[stackSize++] = nodeId;
+    while(stackSize > 0) {
+      nodeId = saved->pathStack[--stackSize];
+      saved->dirtyPath[saved->numPathNodes++] = nodeId;
+      node = locusData->nodeArray[nodeId];
+      if(node->leftSon  >= locusData->numLeaves)	saved->pathStack[stackSize++] = node->leftSon;
+      if(node->rightSon >= locusData->numLeaves)	saved->pathStack[stackSize++] = node->rightSon;
+    }
+    for(i=0; i<saved->numPathNodes/2; i++) {
+      nodeId = saved->dirtyPath[i];
+      saved->dirtyPath[i] = saved->dirtyPath[saved->numPathNodes-1-i];
+      saved->dirtyPath[saved->numPathNodes-1-i] = nodeId;
+    }
+    return saved->numPathNodes;
+  }
+
+  // mark changed nodes and their ancestors
+  numDirty = saved->numChangedConditionals;
+  for(i=0; i<numDirty; i++) {
+    nodeId = saved->changedCondIds[i];
+    if(saved->pathCounts[nodeId] > 0)
+      continue;
+    saved->pathCounts[nodeId] = 1;
+    for(father = locusData->nodeArray[nodeId]->father; father >= 0; father = locusData->nodeArray[father]->father) {
+      if(saved->pathCounts[father]++ > 0)
+        break;
+      saved->pathCounts[father] = 2;
+    }
+  }
+
+  // nodes on path with no sons on path are changed nodes - start from them
+  for(i=0; i<numDirty; i++) {
+    nodeId = saved->changedCondIds[i];
+    if(saved->pathCounts[nodeId] == 1)
+      saved->pathStack[stackSize++] = nodeId;
+  }
+
+  // list each node once all its sons on path were listed (leaves are not listed)
+  while(stackSize > 0) {
+    nodeId = saved->pathStack[--stackSize];
+    saved->pathCounts[nodeId] = 0;
+    if(nodeId >= locusData->numLeaves)
+      saved->dirtyPath[saved->numPathNodes++] = nodeId;
+    father = locusData->nodeArray[nodeId]->father;
+    if(father >= 0 && --saved->pathCounts[father] == 1)
+      saved->pathStack[stackSize++] = father;
+  }
+
+  return saved->numPathNodes;
+}
+/** end of buildDirtyPath **/
+
+
+
 /***********************************************************************************
  *	computeConditionalJC_new
- *	- RECURSIVE PROCEDURE
  *	-> SAME AS ORIGINAL LOGIC BUT CALLS computeSubtreeConditionals_new
  *	- computes conditional probabilities for a subtree of the genealogy at a specified locus
- *	- nodeId indicates the root of the subtree
+ *	- nodeId indicates the root of the subtree (root of genealogy, unless overideOld == 1)
  *	- conditional probabilities are written in conditionalProbs[] array of node
  *	- returns 1 if conditionals had to be recomputed, and 0 if old ones were used
  *	- recomputations are needed if this node has been modified or if recomputations were
- *		made in one of its subtrees
+ *		made in one of its subtrees. nodes are visited iteratively along the path
+ *		listed by buildDirtyPath.
+ *	- when all internal nodes are recomputed, the pattern range may be split among
+ *		threads (see setPatternThreads)
  *	- if overideOld == 1, then does not save old version
  ***********************************************************************************/
 int computeConditionalJC_new (LocusData* locusData, int nodeId, int numPatterns, int* patternIds, unsigned short overideOld)		{
-  int res;
-  int patt;
-  double edgeLength;
-  LikelihoodNode *node, *leftSon, *rightSon;
-  double leftEdgeConditionalProb[2];
-  double rightEdgeConditionalProb[2];
+  int pathNode, numPathNodes, numThreads = 1;
 
-	
-  // leaf case - no need for any computation, but propagate up, if leaf age has changed
-  if(nodeId < locusData->numLeaves) {
-    if(locusData->savedVersion.recalcConditionals[nodeId]) {
-      //printf("leaf %d updated. Will have to recompute parent.\n",nodeId);
-      return 100;
+  numPathNodes = buildDirtyPath(locusData, nodeId, overideOld);
+  if(numPathNodes == 0)
+    return 0;
+
+  // save old conditional probabilities (if haven't already been saved)
+  if(!overideOld) {
+    for(pathNode=0; pathNode<numPathNodes; pathNode++) {
+      copyNodeConditionals(locusData, locusData->savedVersion.dirtyPath[pathNode]);
     }
-    return locusData->savedVersion.recalcConditionals[nodeId];
   }
-  node = locusData->nodeArray[nodeId];
-  // internal node - compute conditionals for both children
-  res = computeConditionalJC_new(locusData, node->leftSon, numPatterns, patternIds, overideOld);
-  res = computeConditionalJC_new(locusData, node->rightSon, numPatterns, patternIds, overideOld) + res;
+  locusData->numNodeRecomputations += numPathNodes;
+  locusData->numPatternsProcessed += (long long)numPathNodes * numPatterns;
 
-  //	printf("Computing conditionals for node %d:\n",nodeId);
+  if(patternThreads > 1 && numPathNodes == locusData->numLeaves-1 && !omp_in_parallel()) {
+    numThreads = min2(patternThreads, numPatterns / PATTERN_THREADS_MIN_PATTERNS);
+  }
 
-  if(!overideOld && !res && !locusData->savedVersion.recalcConditionals[nodeId])
-    return 0;
-	
-  // save old conditional probabilities (if haven't already been saved)
-  if(!overideOld) {
-    copyNodeConditionals(locusData,nodeId);
+  if(numThreads <= 1) {
+    computePathConditionals(locusData, numPatterns, patternIds);
+    return 1;
   }
 
-	
-  leftSon = locusData->nodeArray[ node->leftSon ];
-  rightSon = locusData->nodeArray[ node->rightSon ];
+#pragma omp parallel num_threads(numThreads)
+  {
+    int thread = omp_get_thread_num();
+    int begin = (int)((long long)numPatterns * thread / numThreads);
+    int end   = (int)((long long)numPatterns * (thread+1) / numThreads);
+    computePathConditionals(locusData, end - begin, patternIds + begin);
+  }
 
+  return 1;
+}
+/** end of computeConditionalJC_new **/
 
-  edgeLength = locusData->mutationRate * (node->age - leftSon->age);
-  leftEdgeConditionalProb[0] = computeEdgeConditionalJC(edgeLength);
-  leftEdgeConditionalProb[1] = 1 - 4.0*leftEdgeConditionalProb[0];
 
-  edgeLength = locusData->mutationRate * (node->age - rightSon->age);
-  rightEdgeConditionalProb[0] = computeEdgeConditionalJC(edgeLength);
-  rightEdgeConditionalProb[1] = 1 - 4.0*rightEdgeConditionalProb[0];
-	
-  if(res>10) {
-    //printf("Node %d parent of %d,%d, one of which changed. Ages %g, %g, %g. Conditional probs: %g, %g.\n",
-    //         nodeId, node->leftSon, node->rightSon,node->age, leftSon->age, rightSon->age,leftEdgeConditionalProb[0],rightEdgeConditionalProb[0]);
-  }
 
-  for (patt=0; patt < numPatterns; patt++) {
-    int pattId = patternIds[patt];
-	int base = 1;
-#ifdef OPT2
-    if(nodeId != locusData->root && locusData->seqData.numBases[pattId] == 1) {
-	  node->conditionalProbs[CODE_SIZE*pattId] =
-	    leftSon->conditionalProbs[CODE_SIZE*pattId]*(leftEdgeConditionalProb[0]+leftEdgeConditionalProb[1])*
-	    rightSon->conditionalProbs[CODE_SIZE*pattId]*(rightEdgeConditionalProb[0]+rightEdgeConditionalProb[1]);
+/***********************************************************************************
+ *	computePathConditionals
+ *	- computes conditionals of all nodes in savedVersion.dirtyPath[] (in post-order)
+ *		for given patterns, from conditionals of their sons
+ *	- patterns are independent, so disjoint pattern ranges may be computed by
+ *		different threads at the same time
+ ***********************************************************************************/
+void computePathConditionals (LocusData* locusData, int numPatterns, int* patternIds)		{
+  int patt, pathNode;
+  double edgeLength;
+  LikelihoodNode *node, *leftSon, *rightSon;
+  double leftEdgeConditionalProb[2];
+  double rightEdgeConditionalProb[2];
 
-      for(base=1; base<CODE_SIZE; base++)  {
-        node->conditionalProbs[CODE_SIZE*pattId + base] = 0.0;
-      }
+  for(pathNode=0; pathNode<locusData->savedVersion.numPathNodes; pathNode++) {
+    node = locusData->nodeArray[ locusData->savedVersion.dirtyPath[pathNode] ];
+    leftSon = locusData->nodeArray[ node->leftSon ];
+    rightSon = locusData->nodeArray[ node->rightSon ];
+
+    edgeLength = locusData->mutationRate * (node->age - leftSon->age);
+    leftEdgeConditionalProb[0] = computeEdgeConditionalJC(edgeLength);
+    leftEdgeConditionalProb[1] = 1 - 4.0*leftEdgeConditionalProb[0];
+
+    edgeLength = locusData->mutationRate * (node->age - rightSon->age);
+    rightEdgeConditionalProb[0] = computeEdgeConditionalJC(edgeLength);
+    rightEdgeConditionalProb[1] = 1 - 4.0*rightEdgeConditionalProb[0];
+
+    if(locusData->floatConditionals) {
+      computeFloatConditionals(locusData, node, node->leftSon, node->rightSon, numPatterns, patternIds, leftEdgeConditionalProb, rightEdgeConditionalProb);
       continue;
-	}
+    }
+
+    for (patt=0; patt < numPatterns; patt++) {
+      int pattId = patternIds[patt];
+      int base = 1;
+#ifdef OPT2
+      if(locusData->seqData.constantBases[pattId] >= 0) {
+        computeConstantConditionals_new(getSonConditionals(locusData, node->leftSon, pattId), getSonConditionals(locusData, node->rightSon, pattId),
+                                        &(node->conditionalProbs[CODE_SIZE*pattId]), locusData->seqData.constantBases[pattId],
+                                        leftEdgeConditionalProb, rightEdgeConditionalProb);
+        continue;
+      }
 #endif
-    // initialize conditionals
-    for(base=0; base<CODE_SIZE; base++)  {
-      node->conditionalProbs[CODE_SIZE*pattId + base] = 1.0;
+      // initialize conditionals
+      for(base=0; base<CODE_SIZE; base++)  {
+        node->conditionalProbs[CODE_SIZE*pattId + base] = 1.0;
+      }
+      computeSubtreeConditionals_new(getSonConditionals(locusData, node->leftSon, pattId),&(node->conditionalProbs[CODE_SIZE*pattId]),leftEdgeConditionalProb);
+      computeSubtreeConditionals_new(getSonConditionals(locusData, node->rightSon, pattId),&(node->conditionalProbs[CODE_SIZE*pattId]),rightEdgeConditionalProb);
     }
-    //		printf("edge (%d,%d)", nodeId,node->leftSon);
-    computeSubtreeConditionals_new(&(leftSon->conditionalProbs[CODE_SIZE*pattId]),&(node->conditionalProbs[CODE_SIZE*pattId]),leftEdgeConditionalProb);
-    //		printf(", edge (%d,%d)", nodeId,node->rightSon);
-    computeSubtreeConditionals_new(&(rightSon->conditionalProbs[CODE_SIZE*pattId]),&(node->conditionalProbs[CODE_SIZE*pattId]),rightEdgeConditionalProb);
-    //		printf(".\n");
-  }
-               
-  return 1;
+  }// end of for(pathNode)
 }
-/** end of computeConditionalJC_new **/
+/** end of computePathConditionals **/
 
 
 
@@ -1679,6 +2331,171 @@ void computeSubtreeConditionals_new (double* sonConditionals, double* parentCond
 /** end of computeSubtreeConditionals_new **/
 
 
+
+/***********************************************************************************
+ *	computeConstantConditionals_new
+ *	- computes conditionals of a node for a constant pattern (single base in all
+ *		leaves with data) from those of its sons (the work of computeSubtreeConditionals_new
+ *		for both sons)
+ *	- under JC, conditionals of all nodes for such a pattern take one value for
+ *		constantBase and a single other value for all other bases, so only two
+ *		values are computed. these are computed by the same operations as in
+ *		computeSubtreeConditionals_new (results are identical).
+ ***********************************************************************************/
+static inline void computeConstantConditionals_new (double* leftConditionals, double* rightConditionals, double* parentConditionals,
+                                                    int constantBase, double* leftEdgeSubstProb, double* rightEdgeSubstProb)	{
+  int base, otherBase = (constantBase + 1) % CODE_SIZE;
+  double probSum, probSumTimesSubst;
+  double same = 1.0, other = 1.0;
+
+  // sons with missing data in all leaves ('N') do not contribute
+  probSum = leftConditionals[0] + leftConditionals[1] + leftConditionals[2] + leftConditionals[3];
+  if(probSum < CODE_SIZE) {
+    probSumTimesSubst = probSum * leftEdgeSubstProb[0];
+    same  *= (probSumTimesSubst + leftConditionals[constantBase]*leftEdgeSubstProb[1]);
+    other *= (probSumTimesSubst + leftConditionals[otherBase]*leftEdgeSubstProb[1]);
+  }
+  probSum = rightConditionals[0] + rightConditionals[1] + rightConditionals[2] + rightConditionals[3];
+  if(probSum < CODE_SIZE) {
+    probSumTimesSubst = probSum * rightEdgeSubstProb[0];
+    same  *= (probSumTimesSubst + rightConditionals[constantBase]*rightEdgeSubstProb[1]);
+    other *= (probSumTimesSubst + rightConditionals[otherBase]*rightEdgeSubstProb[1]);
+  }
+
+  for(base=0; base<CODE_SIZE; base++)  {
+    parentConditionals[base] = other;
+  }
+  parentConditionals[constantBase] = same;
+}
+/** end of computeConstantConditionals_new **/
+
+
+
+/***********************************************************************************
+ *	computeFloatConditionals
+ *	- single-precision version of the pattern loop of computeConditionalJC_new
+ *	- computes conditionals of node for given patterns from those of its sons,
+ *		using edge substitution probabilities of both edges (computed in double)
+ *	- contribution of each son is computed as in computeSubtreeConditionals_new,
+ *		fused into a single branch-free pass over the bases of a pattern
+ *	- conditionals of a pattern are rescaled by 2^FLOAT_SCALE_BITS whenever all of
+ *		them fall below 2^-FLOAT_SCALE_BITS, and the number of rescalings (including
+ *		those of sons) is recorded in scaling count of pattern at node. denormals
+ *		left after rescaling are negligible and are flushed to zero.
+ *	- leaf sons read (exact) leaf conditionals from shared table, with no scaling
+ ***********************************************************************************/
+void computeFloatConditionals (LocusData* locusData, LikelihoodNode* node, int leftSonId, int rightSonId,
+                               int numPatterns, int* patternIds, double* leftEdgeSubstProb, double* rightEdgeSubstProb)		{
+  int patt, base, scale;
+  float leftSum, rightSum, leftOffset, rightOffset, leftFactor, rightFactor, maxConditional;
+  float *conditionals, *leftConditionals, *rightConditionals;
+  float leftLeaf[CODE_SIZE], rightLeaf[CODE_SIZE];
+  double* leafConditionals;
+  float leftSubstProb[2]  = {(float)leftEdgeSubstProb[0],  (float)leftEdgeSubstProb[1]};
+  float rightSubstProb[2] = {(float)rightEdgeSubstProb[0], (float)rightEdgeSubstProb[1]};
+  unsigned short leftIsLeaf = (leftSonId < locusData->numLeaves);
+  unsigned short rightIsLeaf = (rightSonId < locusData->numLeaves);
+  LikelihoodNode* leftSon = locusData->nodeArray[leftSonId];
+  LikelihoodNode* rightSon = locusData->nodeArray[rightSonId];
+  int* scales = getNodeScales(locusData, node);
+  int* leftScales = leftIsLeaf ? nullptr : getNodeScales(locusData, leftSon);
+  int* rightScales = rightIsLeaf ? nullptr : getNodeScales(locusData, rightSon);
+
+  for (patt=0; patt < numPatterns; patt++) {
+    int pattId = patternIds[patt];
+    conditionals = node->floatConditionals + CODE_SIZE*pattId;
+    if(leftIsLeaf) {
+      leafConditionals = getSonConditionals(locusData, leftSonId, pattId);
+      for(base=0; base<CODE_SIZE; base++)  {
+        leftLeaf[base] = (float)leafConditionals[base];
+      }
+      leftConditionals = leftLeaf;
+    } else {
+      leftConditionals = leftSon->floatConditionals + CODE_SIZE*pattId;
+    }
+    if(rightIsLeaf) {
+      leafConditionals = getSonConditionals(locusData, rightSonId, pattId);
+      for(base=0; base<CODE_SIZE; base++)  {
+        rightLeaf[base] = (float)leafConditionals[base];
+      }
+      rightConditionals = rightLeaf;
+    } else {
+      rightConditionals = rightSon->floatConditionals + CODE_SIZE*pattId;
+    }
+
+    // contribution of son for base b is offset + factor*conditional[b]
+    // (offset 1 and factor 0 for son with missing data)
+    leftSum = leftConditionals[0] + leftConditionals[1] + leftConditionals[2] + leftConditionals[3];
+    rightSum = rightConditionals[0] + rightConditionals[1] + rightConditionals[2] + rightConditionals[3];
+    leftOffset  = (leftSum  >= CODE_SIZE) ? 1.0f : leftSum*leftSubstProb[0];
+    leftFactor  = (leftSum  >= CODE_SIZE) ? 0.0f : leftSubstProb[1];
+    rightOffset = (rightSum >= CODE_SIZE) ? 1.0f : rightSum*rightSubstProb[0];
+    rightFactor = (rightSum >= CODE_SIZE) ? 0.0f : rightSubstProb[1];
+
+    maxConditional = 0.0f;
+    for(base=0; base<CODE_SIZE; base++)  {
+      conditionals[base] = (leftOffset + leftFactor*leftConditionals[base]) * (rightOffset + rightFactor*rightConditionals[base]);
+      maxConditional = (conditionals[base] > maxConditional) ? conditionals[base] : maxConditional;
+    }
+
+    // rescale pattern, if needed
+    scale = (leftIsLeaf ? 0 : leftScales[pattId]) + (rightIsLeaf ? 0 : rightScales[pattId]);
+    if(maxConditional < FLOAT_SCALE_THRESHOLD && maxConditional > 0.0f) {
+      do {
+        for(base=0; base<CODE_SIZE; base++)  {
+          conditionals[base] *= FLOAT_SCALE_FACTOR;
+        }
+        maxConditional *= FLOAT_SCALE_FACTOR;
+        scale++;
+      } while(maxConditional < FLOAT_SCALE_THRESHOLD);
+    }
+    for(base=0; base<CODE_SIZE; base++)  {
+      conditionals[base] = (conditionals[base] < FLT_MIN) ? 0.0f : conditionals[base];
+    }
+    scales[pattId] = scale;
+  }
+
+}
+/** end of computeFloatConditionals **/
+
+
+
+/***********************************************************************************
+ *	computePatternConditionalsDouble
+ *	- RECURSIVE PROCEDURE
+ *	- computes double-precision conditionals of a single pattern for subtree
+ *		rooted at nodeId, without modifying locus data (used to check
+ *		single-precision conditionals - see checkLocusConditionalPrecision)
+ *	- edgeSubstProbs holds substitution probabilities (p, 1-4p) of edge above
+ *		each node, and conditionals of node are written in conditionals[] array
+ *		(CODE_SIZE entries per node)
+ ***********************************************************************************/
+void computePatternConditionalsDouble (LocusData* locusData, int nodeId, int pattId, double* edgeSubstProbs, double* conditionals)		{
+  int base;
+  LikelihoodNode* node = locusData->nodeArray[nodeId];
+  double* nodeConditionals = conditionals + CODE_SIZE*nodeId;
+
+  // leaf conditionals are read from shared table
+  if(nodeId < locusData->numLeaves) {
+    for(base=0; base<CODE_SIZE; base++)  {
+      nodeConditionals[base] = getSonConditionals(locusData, nodeId, pattId)[base];
+    }
+    return;
+  }
+
+  computePatternConditionalsDouble(locusData, node->leftSon, pattId, edgeSubstProbs, conditionals);
+  computePatternConditionalsDouble(locusData, node->rightSon, pattId, edgeSubstProbs, conditionals);
+
+  for(base=0; base<CODE_SIZE; base++)  {
+    nodeConditionals[base] = 1.0;
+  }
+  computeSubtreeConditionals_new(conditionals + CODE_SIZE*node->leftSon, nodeConditionals, edgeSubstProbs + 2*node->leftSon);
+  computeSubtreeConditionals_new(conditionals + CODE_SIZE*node->rightSon, nodeConditionals, edgeSubstProbs + 2*node->rightSon);
+
+}
+/** end of computePatternConditionalsDouble **/
+
+
 /***********************************************************************************
  *	computePairwiseLCAs_rec
  *	- recursive procedure for computing a 2D matrix with the ids of the LCAs (least
@@ -1913,6 +2730,185 @@ int copyNodeConditionals(LocusData* locusData, int nodeId) {
 
 
 
+/***********************************************************************************
+ *	getNodeScales
+ *	- returns array of scaling counts (one per pattern) of single-precision
+ *		conditionals of given node version
+ ***********************************************************************************/
+static inline int* getNodeScales (LocusData* locusData, LikelihoodNode* node) {
+  return locusData->floatScales_m + (node->floatConditionals - locusData->floatArray_m) / CODE_SIZE;
+}
+/** end of getNodeScales **/
+
+
+
+/***********************************************************************************
+ *	getNodeConditional
+ *	- returns conditional of given index (CODE_SIZE*pattId + base) at node, as
+ *		stored (without scaling), in either precision
+ ***********************************************************************************/
+static inline double getNodeConditional (LocusData* locusData, LikelihoodNode* node, int index) {
+  if(locusData->floatConditionals)
+    return node->floatConditionals[index];
+  return node->conditionalProbs[index];
+}
+/** end of getNodeConditional **/
+
+
+
+/***********************************************************************************
+ *	getSonConditionals
+ *	- returns (double-precision) conditionals of given pattern at son of a node:
+ *		from shared table of leaf patterns for a leaf, and from conditionals
+ *		array of node otherwise
+ ***********************************************************************************/
+static inline double* getSonConditionals (LocusData* locusData, int sonId, int pattId) {
+  if(sonId < locusData->numLeaves)
+    return leafPatterns.conditionals + CODE_SIZE*(leafPatterns.numLeaves*locusData->seqData.leafPatternIds[pattId] + sonId);
+  return locusData->nodeArray[sonId]->conditionalProbs + CODE_SIZE*pattId;
+}
+/** end of getSonConditionals **/
+
+
+
+/***********************************************************************************
+ *	computeRootPatternLogLikelihood
+ *	- returns log-likelihood of a single (unphased) pattern from root conditionals,
+ *		assuming uniform distribution at root and averaging over all phases
+ *	- single-precision conditionals are summed in double, after undoing the
+ *		scaling of each phase
+ ***********************************************************************************/
+static inline double computeRootPatternLogLikelihood (LocusData* locusData, int pattId) {
+  int conditional, phase, base, minScale;
+  int numPhases = locusData->seqData.numPhases[pattId];
+  int numConditionals = CODE_SIZE*numPhases;
+  LikelihoodNode* root = locusData->nodeArray[ locusData->root ];
+  int* scales;
+  double prob = 0.0, phaseProb;
+
+  if(!locusData->floatConditionals) {
+    for(conditional=0; conditional<numConditionals; conditional++) {
+      prob += root->conditionalProbs[pattId*CODE_SIZE+conditional];
+    }
+    return log(prob/numConditionals);
+  }
+
+  scales = getNodeScales(locusData, root) + pattId;
+  minScale = scales[0];
+  for(phase=1; phase<numPhases; phase++) {
+    if(scales[phase] < minScale)		minScale = scales[phase];
+  }
+  for(phase=0; phase<numPhases; phase++) {
+    phaseProb = 0.0;
+    for(base=0; base<CODE_SIZE; base++) {
+      phaseProb += root->floatConditionals[(pattId+phase)*CODE_SIZE+base];
+    }
+    prob += ldexp(phaseProb, -FLOAT_SCALE_BITS*(scales[phase]-minScale));
+  }
+  return log(prob/numConditionals) - minScale*FLOAT_SCALE_BITS*M_LN2;
+}
+/** end of computeRootPatternLogLikelihood **/
+
+
+
+/***********************************************************************************
+ *	layoutLocusData
+ *	- lays out the LocusData structure and all its arrays in a single block:
+ *		structure, nodes, node pointers, conditionals, pattern arrays and change
+ *		logs, each starting on a cache line
+ *	- if block is not nullptr, copies locus data into block (pointers of copy are
+ *		set to arrays in block). otherwise, only measures layout.
+ *	- returns size of layout (in bytes)
+ ***********************************************************************************/
+static char* carveLocusArray(char* block, size_t* offset, size_t bytes) {
+  char* array = (block == nullptr) ? nullptr : block + *offset;
+  *offset += (bytes + 63) & ~(size_t)63;
+  return array;
+}
+
+size_t layoutLocusData (LocusData* locusData, char* block) {
+  int node, numNodes = 2*locusData->numLeaves-1;
+  size_t offset = 0;
+  // conditionals of internal nodes only (leaf conditionals are shared - see computeLeafConditionals)
+  size_t numConditionals = (locusData->doubleArray_m == nullptr) ? 0 : 2*(locusData->numLeaves-1)*CODE_SIZE*locusData->seqData.numPatterns;
+  size_t numFloatConditionals = (!locusData->floatConditionals) ? 0 : 2*(locusData->numLeaves-1)*CODE_SIZE*locusData->seqData.numPatterns;
+  size_t numPatternInts = (locusData->intArray_m == nullptr) ? 0 : 5*locusData->seqData.numPatterns;
+
+  LocusData* newData = (LocusData*)carveLocusArray(block, &offset, sizeof(LocusData));
+  LikelihoodNode* nodeArray_m = (LikelihoodNode*)carveLocusArray(block, &offset, 2*numNodes*sizeof(LikelihoodNode));
+  LikelihoodNode** nodePointers = (LikelihoodNode**)carveLocusArray(block, &offset, 2*numNodes*sizeof(LikelihoodNode*));
+  double* doubleArray_m = (double*)carveLocusArray(block, &offset, numConditionals*sizeof(double));
+  float* floatArray_m = (float*)carveLocusArray(block, &offset, numFloatConditionals*sizeof(float) + numFloatConditionals/CODE_SIZE*sizeof(int));
+  int* intArray_m = (int*)carveLocusArray(block, &offset, numPatternInts*sizeof(int));
+  int* changedIds = (int*)carveLocusArray(block, &offset, 4*numNodes*sizeof(int));
+  unsigned short* recalcConditionals = (unsigned short*)carveLocusArray(block, &offset, 2*numNodes*sizeof(unsigned short));
+
+  if(block == nullptr)
+    return offset;
+
+  *newData = *locusData;
+
+  // nodes (and their conditionals, at same offsets in new array)
+  memcpy(nodeArray_m, locusData->nodeArray_m, 2*numNodes*sizeof(LikelihoodNode));
+  for(node=0; node<2*numNodes; node++) {
+    if(nodeArray_m[node].conditionalProbs == nullptr) {
+      continue;
+    } else if(locusData->floatConditionals) {
+      nodeArray_m[node].floatConditionals = floatArray_m + (nodeArray_m[node].floatConditionals - locusData->floatArray_m);
+    } else {
+      nodeArray_m[node].conditionalProbs = doubleArray_m + (nodeArray_m[node].conditionalProbs - locusData->doubleArray_m);
+    }
+  }
+  newData->nodeArray_m = nodeArray_m;
+  if(numConditionals > 0) {
+    memcpy(doubleArray_m, locusData->doubleArray_m, numConditionals*sizeof(double));
+    newData->doubleArray_m = doubleArray_m;
+  }
+  if(numFloatConditionals > 0) {
+    // conditionals followed by scaling counts (one per CODE_SIZE conditionals)
+    memcpy(floatArray_m, locusData->floatArray_m, numFloatConditionals*sizeof(float) + numFloatConditionals/CODE_SIZE*sizeof(int));
+    newData->floatArray_m = floatArray_m;
+    newData->floatScales_m = (int*)(floatArray_m + numFloatConditionals);
+  } else {
+    newData->floatArray_m = nullptr;
+    newData->floatScales_m = nullptr;
+  }
+
+  // node pointers (current and saved versions)
+  newData->nodeArray = nodePointers;
+  newData->savedVersion.savedNodes = nodePointers + numNodes;
+  for(node=0; node<numNodes; node++) {
+    newData->nodeArray[node] = nodeArray_m + (locusData->nodeArray[node] - locusData->nodeArray_m);
+    newData->savedVersion.savedNodes[node] = nodeArray_m + (locusData->savedVersion.savedNodes[node] - locusData->nodeArray_m);
+  }
+
+  // pattern arrays
+  if(numPatternInts > 0) {
+    memcpy(intArray_m, locusData->intArray_m, numPatternInts*sizeof(int));
+    newData->intArray_m = intArray_m;
+    newData->seqData.numPhases = intArray_m + (locusData->seqData.numPhases - locusData->intArray_m);
+    newData->seqData.patternList = intArray_m + (locusData->seqData.patternList - locusData->intArray_m);
+    newData->seqData.patternCount = intArray_m + (locusData->seqData.patternCount - locusData->intArray_m);
+    newData->seqData.leafPatternIds = intArray_m + (locusData->seqData.leafPatternIds - locusData->intArray_m);
+    newData->seqData.constantBases = intArray_m + (locusData->seqData.constantBases - locusData->intArray_m);
+  }
+
+  // change logs
+  memcpy(changedIds, locusData->savedVersion.changedNodeIds, 4*numNodes*sizeof(int));
+  newData->savedVersion.changedNodeIds = changedIds;
+  newData->savedVersion.changedCondIds = changedIds + numNodes;
+  newData->savedVersion.dirtyPath = changedIds + 2*numNodes;
+  newData->savedVersion.pathStack = changedIds + 3*numNodes;
+  memcpy(recalcConditionals, locusData->savedVersion.recalcConditionals, 2*numNodes*sizeof(unsigned short));
+  newData->savedVersion.recalcConditionals = recalcConditionals;
+  newData->savedVersion.pathCounts = recalcConditionals + numNodes;
+
+  return offset;
+}
+/** end of layoutLocusData **/
+
+
+
 /***************************************************************************************************************/
 /******                                        END OF FILE                                                ******/
 /***************************************************************************************************************/
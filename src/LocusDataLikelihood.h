@@ -18,7 +18,7 @@
 #include "GenericTree.h"
 
 #define OPT1	
-#define OPT2_not
+#define OPT2
 
 /***************************************************************************************************************/
 /******                                              DATA TYPES                                           ******/
@@ -66,6 +66,36 @@ int initializeLocusData(LocusData* locusData, char** patternArray, int numPatter
 
 
 
+/***********************************************************************************
+*	closeLeafPatternIndex / freeLeafPatterns
+*	- leaf conditionals of all loci are kept in a single table, holding each
+*		distinct phased pattern once (loci refer to patterns by id)
+*	- closeLeafPatternIndex frees the index used to find repeated patterns while
+*		loci are initialized, and returns the number of distinct patterns.
+*		no loci may be initialized after this call.
+*	- freeLeafPatterns frees the table (after all loci are freed)
+***********************************************************************************/
+int  closeLeafPatternIndex ();
+void freeLeafPatterns ();
+
+
+
+/***********************************************************************************
+*	setPatternThreads
+*	- sets number of threads among which the pattern range of a full recomputation
+*		of conditionals (all internal nodes) within a single locus is split:
+*		computeAllConditionals, computeLocusDataLikelihood from scratch and
+*		scaleAllNodeAges (1, the default, computes all patterns in calling thread)
+*	- only loci with at least PATTERN_THREADS_MIN_PATTERNS live patterns per thread
+*		are split, and never when called from within a parallel (locus) loop
+*	- each thread computes all nodes for a contiguous range of patterns, so results
+*		do not depend on number of threads
+***********************************************************************************/
+#define PATTERN_THREADS_MIN_PATTERNS 1024
+void setPatternThreads (int numThreads);
+
+
+
 /***********************************************************************************
 *	freeLocusData
 *	- frees all allocated memory for LocusData
@@ -75,6 +105,20 @@ int	freeLocusData (LocusData* locusData);
 
 
 
+/***********************************************************************************
+*	getLocusDataArenaSize / moveLocusDataToArena
+*	- getLocusDataArenaSize returns the number of bytes needed to hold the LocusData
+*		structure and all its arrays (including conditionals) in a single block
+*	- moveLocusDataToArena moves locus data into given (cache-line aligned) block
+*		of getLocusDataArenaSize bytes and frees its previous memory. memory of
+*		block is not freed by freeLocusData (it is owned by caller).
+* 	- returns a pointer to the moved structure.
+***********************************************************************************/
+size_t getLocusDataArenaSize (LocusData* locusData);
+LocusData* moveLocusDataToArena (LocusData* locusData, char* block);
+
+
+
 /***********************************************************************************
 *	attachLeaf - UNUSED
 *	- attaches a leaf to existing sub-genealogy
@@ -103,6 +147,27 @@ void setLocusMutationRate (LocusData* locusData, double newRate);
 double getLocusMutationRate (LocusData* locusData);
 
 
+
+/***********************************************************************************
+*	setLocusConditionalPrecision
+*	- sets whether conditionals of locus are stored in single precision (useFloat = 1)
+*		or in double precision (useFloat = 0, default)
+*	- with single precision, conditionals of each pattern are rescaled to avoid
+*		underflow, and likelihoods at root are summed (and logged) in double
+*	- should be called before initializeLocusData
+*	- returns 0 if all OK, and -1 otherwise
+***********************************************************************************/
+int setLocusConditionalPrecision (LocusData* locusData, unsigned short useFloat);
+
+
+
+/***********************************************************************************
+*	getLocusConditionalPrecision
+*	- returns 1 if conditionals of locus are stored in single precision, and 0 otherwise
+***********************************************************************************/
+int getLocusConditionalPrecision (LocusData* locusData);
+
+
 /***********************************************************************************
 *	computeAllConditionals
 *	- computes all conditional likelihoods at all nodes of tree under all patterns
@@ -138,6 +203,20 @@ double computePatternLogLikelihood (LocusData* locusData, int numPatterns, int*
 
 
 
+/***********************************************************************************
+*	computeNodeAgeProposals
+*	- computes log-likelihood of data for several proposed ages of a single node
+*		(all other ages unchanged) in a single pass over the path from node to root,
+*		for batches of candidate moves (e.g., multiple-try proposals)
+*	- results are identical to those of adjustGenNodeAge and computeLocusDataLikelihood
+*	- does not modify locus data (should be called when no change is pending)
+*	- writes log-likelihood for each of numProposals ages in lnLds[]
+*	- returns 0 if all OK, and -1 otherwise
+***********************************************************************************/
+int computeNodeAgeProposals (LocusData* locusData, int nodeId, int numProposals, double* ages, double* lnLds);
+
+
+
 /***********************************************************************************
 *	!!!!! FOR DEBUGGING !!!!!
 ***********************************************************************************/
@@ -178,6 +257,30 @@ int checkLocusDataLikelihood (LocusData* locusData);
 
 
 
+/***********************************************************************************
+*	checkLocusConditionalPrecision
+*	- re-computes log-likelihood of data at a locus with single-precision conditionals
+*		in double precision (pattern by pattern, without modifying locus data)
+*	- returns the absolute deviation of recorded log-likelihood from the
+*		double-precision one (0 for locus with double-precision conditionals)
+***********************************************************************************/
+double checkLocusConditionalPrecision (LocusData* locusData);
+
+
+
+/***********************************************************************************
+*	useDoubleConditionals
+*	- switches locus with single-precision conditionals to double precision
+*		(fall back when checkLocusConditionalPrecision finds large deviations)
+*	- allocates double-precision conditionals, converts leaf conditionals and
+*		recomputes all other conditionals and the log-likelihood
+*	- should be called only when no change is pending (saved version was reset)
+*	- returns the delta in log-likelihood
+***********************************************************************************/
+double useDoubleConditionals (LocusData* locusData);
+
+
+
 /***********************************************************************************
 *	revertToSaved
 *	- reverts locus data structure (genealogy and conditional likelihoods) to saved version
@@ -310,6 +413,25 @@ double getLocusDataLikelihood (LocusData* locusData);
 
 
 
+/***********************************************************************************
+*	getLocusNumLivePatterns
+*	- returns the number of patterns relevant for likelihood computation
+***********************************************************************************/
+int getLocusNumLivePatterns (LocusData* locusData);
+
+
+
+/***********************************************************************************
+*	getLocusDataCosts
+*	- returns cost counters of likelihood computations for locus: number of nodes
+*		whose conditionals were recomputed, number of patterns processed in these
+*		recomputations, and time spent in computeLocusDataLikelihood (ns, counted
+*		only when locus profiling is on - see Profiler.h)
+***********************************************************************************/
+void getLocusDataCosts (LocusData* locusData, long long* numNodeRecomputations, long long* numPatternsProcessed, long long* likelihoodTime);
+
+
+
 /***********************************************************************************
 *	getLocusRoot
 *	- returns the root node id
@@ -1,6 +1,7 @@
 
 #include "LocusEmbeddedGenealogy.h"
 #include "DbgErrMsgIntervals.h"
+#include "MultiCoreUtils.h"
 
 
 /*
@@ -106,6 +107,15 @@ LocusData *LocusEmbeddedGenealogy::getLocusData() {
 }
 
 
+/*
+ * getIntervals
+ * @return: a reference to proposal intervals of current locus
+*/
+LocusPopIntervals &LocusEmbeddedGenealogy::getIntervals() {
+    return intervalsPro_;
+}
+
+
 /*
  * getLogLikelihood
  * @return: locus gen log-likelihood
@@ -508,18 +518,10 @@ int LocusEmbeddedGenealogy::updateGB_InternalNode(double finetune) {
     dataLogLd = (dataLogLikelihood_ - dataLogLd);
     genLogLd = (genLogLikelihood_ - genLogLd);
 
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    pState_->dataLogLikelihood += dataLogLd;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    pState_->logLikelihood += (genLogLd + dataLogLd) / pSetup_->numLoci;
+    //record changes in total likelihoods as partial sums of this locus
+    //(reduced into pState_ by caller after the locus loop)
+    LOCUS_PARTIAL_SUM(locusID_, LOCUS_SUM_DATA_LNLD) += dataLogLd;
+    LOCUS_PARTIAL_SUM(locusID_, LOCUS_SUM_LNLD) += (genLogLd + dataLogLd) / pSetup_->numLoci;
 
     return (accepted);
 }
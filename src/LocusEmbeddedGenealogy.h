@@ -105,6 +105,9 @@ public:
     //get locus data
     LocusData* getLocusData();
 
+    //get proposal intervals
+    LocusPopIntervals& getIntervals();
+
     // ********************* PRINT methods *********************
 
     //print embedded genealogy
@@ -1,6 +1,7 @@
 
 #include "LocusGenealogy.h"
 #include "DataLayerConstants.h"
+#include "GPhoCS.h"
 
 #include <iostream>
 #include <cassert>
@@ -10,7 +11,7 @@
     LocusGenealogy - Constructor
     Initialize leafNodes vector with N leaf nodes (N=num samples)
     Initialize coalNodes vector with N-1 leaf nodes
-    Reserve place in migNodes_ vector with X nodes (X=MAX_MIGS)
+    Reserve place in migNodes_ vector with X nodes (X=max-migs setting)
     Set ids of leafNodes and coalNodes
 */
 LocusGenealogy::LocusGenealogy(int numSamples, LocusData *pLocusData)
@@ -30,7 +31,7 @@ LocusGenealogy::LocusGenealogy(int numSamples, LocusData *pLocusData)
     }
 
     //reserve max migrations
-    migNodes_.reserve(MAX_MIGS);
+    migNodes_.reserve(dataSetup.maxMigs);
 }
 
 
@@ -6,6 +6,7 @@
 #include "TreeNode.h"
 
 #include <iostream>
+#include <new>
 
 
 /*
@@ -19,8 +20,11 @@ LocusPopIntervals::LocusPopIntervals(int locusID, int nIntervals)
           pPopTree_(dataSetup.popTree), //todo: get dataSetup as a pointer
           stats_(dataSetup.popTree->numPops, dataSetup.popTree->numMigBands) {
 
-    //allocate N intervals (N = number of intervals, given as argument)
-    intervalsArray_ = new PopInterval[nIntervals];
+    //allocate N intervals in locus arena (N = number of intervals, given as argument)
+    intervalsArray_ = (PopInterval *) locusArenaAlloc(locusID,
+                                                      nIntervals * sizeof(PopInterval));
+    for (int i = 0; i < nIntervals; i++)
+        new(&intervalsArray_[i]) PopInterval();
 
     //intervals pool points to head of intervals array
     pIntervalsPool_ = intervalsArray_;
@@ -124,8 +128,7 @@ LocusPopIntervals::getNewPos(const LocusPopIntervals &other, PopInterval *p) {
  * LocusPopIntervals class destructor
 */
 LocusPopIntervals::~LocusPopIntervals() {
-    //delete array of intervals
-    delete intervalsArray_;
+    //array of intervals is freed with locus arena
 }
 
 
@@ -8,6 +8,7 @@
 */
 
 #include "MCMCcontrol.h"
+#include "MultiCoreUtils.h"
 
 
 /***************************************************************************************************************/
@@ -83,9 +84,14 @@ int initGeneralInfo() {
 	strcpy(ioSetup.combStatsFileName, "NONE");
 	strcpy(ioSetup.cladeStatsFileName, "NONE");
 	strcpy(ioSetup.traceFileName, "mcmc-trace.out");
+	strcpy(ioSetup.profileFileName, "NONE");
+	strcpy(ioSetup.locusCostFileName, "NONE");
 
 	ioSetup.samplesPerLog 	= 100;
 	ioSetup.logsPerLine 	= 100;
+	ioSetup.asyncTraceWriter = 1;
+	ioSetup.traceFlushSeconds = 10.0;
+	ioSetup.binaryTraceFormat = 0;
 
 	mcmcSetup.randomSeed = -1;
 	mcmcSetup.useData  = 0;
@@ -99,6 +105,11 @@ int initGeneralInfo() {
 	mcmcSetup.findFinetunesSamplesPerStep = 100;
 	mcmcSetup.findFinetunesNumSteps = 100;
 	mcmcSetup.genetreeSamples = 1;
+	mcmcSetup.checkLevel = CHECK_FULL;
+	mcmcSetup.checkLociPerLog = 10;
+	mcmcSetup.floatConditionals = 0;
+	mcmcSetup.precisionCheckIterations = 10;
+	mcmcSetup.precisionTolerance = 0.01;
 	mcmcSetup.finetunes.coalTime = -1.0;
 	mcmcSetup.finetunes.migTime = -1.0;
 	mcmcSetup.finetunes.theta = -1.0;
@@ -109,6 +120,7 @@ int initGeneralInfo() {
 
 	dataSetup.numLoci = -1;
 	dataSetup.numPopPartitions = 0;
+	dataSetup.maxMigs = DEFAULT_MAX_MIGS;
 	return 0;
 } 
 /** end of initGeneralInfo **/
@@ -615,6 +627,52 @@ int readGeneralInfo(FILE* fctl) {
 			strncpy(ioSetup.cladeStatsFileName, token2, NAME_LENGTH-1);
 		} else if(0 == strcmp("hyp-stats-file",token)) {
 			strncpy(ioSetup.hypStatsFileName, token2, NAME_LENGTH-1);
+		} else if(0 == strcmp("profile-file",token)) {
+			strncpy(ioSetup.profileFileName, token2, NAME_LENGTH-1);
+		} else if(0 == strcmp("locus-cost-file",token)) {
+			strncpy(ioSetup.locusCostFileName, token2, NAME_LENGTH-1);
+		} else if(0 == strcmp("trace-writer",token)) {
+			if(0 == strcmp("SYNC", token2)) {
+				ioSetup.asyncTraceWriter = 0;
+			} else if(0 == strcmp("ASYNC", token2)) {
+				ioSetup.asyncTraceWriter = 1;
+				token2 = strtokCS(nullptr, parseFileDelims);
+				if(token2 != nullptr && (sscanf(token2, "%lf", &ioSetup.traceFlushSeconds) != 1 || ioSetup.traceFlushSeconds < 0.0)) {
+					fprintf(stderr,"Error: flush interval for trace-writer ASYNC should be non-negative number of seconds, got %s.\n", token2);
+					numErrors++;
+				}
+			} else {
+				fprintf(stderr,"Error: value of trace-writer should be SYNC or ASYNC, got %s.\n", token2);
+				numErrors++;
+			}
+		} else if(0 == strcmp("conditional-precision",token)) {
+			if(0 == strcmp("DOUBLE", token2)) {
+				mcmcSetup.floatConditionals = 0;
+			} else if(0 == strcmp("FLOAT", token2)) {
+				mcmcSetup.floatConditionals = 1;
+				token2 = strtokCS(nullptr, parseFileDelims);
+				if(token2 != nullptr && (sscanf(token2, "%d", &mcmcSetup.precisionCheckIterations) != 1 || mcmcSetup.precisionCheckIterations < 0)) {
+					fprintf(stderr,"Error: number of check iterations for conditional-precision FLOAT should be non-negative integer, got %s.\n", token2);
+					numErrors++;
+				}
+				token2 = (token2 == nullptr) ? nullptr : strtokCS(nullptr, parseFileDelims);
+				if(token2 != nullptr && (sscanf(token2, "%lf", &mcmcSetup.precisionTolerance) != 1 || mcmcSetup.precisionTolerance < 0.0)) {
+					fprintf(stderr,"Error: tolerance for conditional-precision FLOAT should be non-negative number, got %s.\n", token2);
+					numErrors++;
+				}
+			} else {
+				fprintf(stderr,"Error: value of conditional-precision should be DOUBLE or FLOAT, got %s.\n", token2);
+				numErrors++;
+			}
+		} else if(0 == strcmp("trace-format",token)) {
+			if(0 == strcmp("TEXT", token2)) {
+				ioSetup.binaryTraceFormat = 0;
+			} else if(0 == strcmp("BINARY", token2)) {
+				ioSetup.binaryTraceFormat = 1;
+			} else {
+				fprintf(stderr,"Error: value of trace-format should be TEXT or BINARY, got %s.\n", token2);
+				numErrors++;
+			}
 		} else if(0 == strcmp("num-pop-partitions",token)) {
 			if (sscanf(token2, "%d", &dataSetup.numPopPartitions) != 1 || dataSetup.numPopPartitions <= 0) {
 				fprintf(stderr,"Error: value for num-pop-partitions should be positive integer, got %s.\n", token2);
@@ -625,6 +683,11 @@ int readGeneralInfo(FILE* fctl) {
 				fprintf(stderr,"Error: value for num-loci should be positive integer, got %s.\n", token2);
 				numErrors++;
 			}
+		} else if(0 == strcmp("max-migs",token)) {
+			if (sscanf(token2, "%d", &dataSetup.maxMigs) != 1 || dataSetup.maxMigs <= 0) {
+				fprintf(stderr,"Error: value for max-migs should be positive integer, got %s.\n", token2);
+				numErrors++;
+			}
 		} else if(0 == strcmp("random-seed",token)) {
 			if (sscanf(token2, "%d", &mcmcSetup.randomSeed) != 1) {
 				fprintf(stderr,"Error: value for random-seed should be integer, got %s.\n", token2);
@@ -767,6 +830,37 @@ int readGeneralInfo(FILE* fctl) {
 				fprintf(stderr,"Error: value for find-finetunes-samples-per-step should be positive integer, got %s.\n", token2);
 				numErrors++;
 			}
+		} else if(0 == strcmp("check-level",token)) {
+			if(0 == strcmp("OFF", token2)) {
+				mcmcSetup.checkLevel = CHECK_OFF;
+			} else if(0 == strcmp("FULL", token2)) {
+				mcmcSetup.checkLevel = CHECK_FULL;
+			} else if(0 == strcmp("SAMPLED", token2)) {
+				mcmcSetup.checkLevel = CHECK_SAMPLED;
+				token2 = strtokCS(nullptr, parseFileDelims);
+				if(token2 != nullptr && (sscanf(token2, "%d", &mcmcSetup.checkLociPerLog) != 1 || mcmcSetup.checkLociPerLog <= 0)) {
+					fprintf(stderr,"Error: number of loci per log for check-level SAMPLED should be positive integer, got %s.\n", token2);
+					numErrors++;
+				}
+			} else {
+				fprintf(stderr,"Error: value of check-level should be OFF, SAMPLED, or FULL, got %s.\n", token2);
+				numErrors++;
+			}
+		} else if(0 == strcmp("locus-scheduling",token)) {
+			if(0 != parseLocusScheduling(token2, strtokCS(nullptr, parseFileDelims))) {
+				numErrors++;
+			}
+		} else if(0 == strcmp("move-threads",token)) {
+			char* mode = strtokCS(nullptr, parseFileDelims);
+			char* threads = (mode == nullptr) ? nullptr : strtokCS(nullptr, parseFileDelims);
+			char* chunk = (threads == nullptr) ? nullptr : strtokCS(nullptr, parseFileDelims);
+			if(0 != parseMoveThreading(token2, mode, threads, chunk)) {
+				numErrors++;
+			}
+		} else if(0 == strcmp("thread-placement",token)) {
+			if(0 != parseThreadPlacement(token2)) {
+				numErrors++;
+			}
 		} else {
 			fprintf(stderr, "Error: argument '%s' is not accepted in GENERAL-INFO module.\n",token);
 			numErrors++;
@@ -54,8 +54,13 @@ struct IO_SETUP {
 	char combStatsFileName[NAME_LENGTH];
 	char cladeStatsFileName[NAME_LENGTH];
 	char hypStatsFileName[NAME_LENGTH];
+	char profileFileName[NAME_LENGTH];		// name of profile file (for per-move run-time profile, AUTO for <trace-file>.profile.jsonl)
+	char locusCostFileName[NAME_LENGTH];	// name of locus cost report file (for per-locus cost accounting, AUTO for <trace-file>.locus-costs.tsv)
 	int samplesPerLog;						// number of samples for which to generate a log summary in stdout
 	int logsPerLine;						// number of sample logs per log line
+	int asyncTraceWriter;					// 1 if trace and stats files are written by a background thread
+	double traceFlushSeconds;				// time between flushes of trace and stats files (with async writer)
+	int binaryTraceFormat;					// 1 if trace and stats files are written in binary format (see TraceFile.h)
 	
 	FILE*	traceFile;						// trace file
 	FILE*	debugFile;						// debugging file
@@ -69,6 +74,19 @@ struct IO_SETUP {
 
 extern struct IO_SETUP ioSetup;
 
+/*********
+ * levels of consistency checks performed at each log
+ *	- OFF:     no checks
+ *	- SAMPLED: full checks on a rotating subset of loci (checkLociPerLog per log),
+ *	           and checks of totals over all loci using recorded values
+ *	- FULL:    full checks on all loci
+ *********/
+typedef enum {
+	CHECK_OFF = 0,
+	CHECK_SAMPLED,
+	CHECK_FULL
+} CheckLevel;
+
 /*********
  * mcmc setup
  *********/
@@ -95,6 +113,15 @@ struct MCMC_SETUP {
 	int findFinetunes;					//if == 1, dynamically search for finetunes
 	int findFinetunesSamplesPerStep;	//if using find-finetunes, this is the number of samples to take before adjusting finetune values
 	int findFinetunesNumSteps;  		//if using find-finetunes, this is the number of steps before settling in
+
+	// consistency checks
+	CheckLevel checkLevel;				// level of consistency checks at each log (default is CHECK_FULL)
+	int checkLociPerLog;				// number of loci checked at each log in CHECK_SAMPLED mode
+
+	// precision of conditional likelihoods (see setLocusConditionalPrecision)
+	unsigned short floatConditionals;	// flag which is turned on to store conditionals in single precision (default is 0)
+	int precisionCheckIterations;		// number of first iterations in which single-precision loci are checked against double precision
+	double precisionTolerance;			// maximal deviation in locus log-likelihood before falling back to double precision
 	
 	double* printFactors;			// array of factors in which to output parameters (allocated in readControlFile)
 //  char traceFileTitle[500];
@@ -113,6 +140,7 @@ typedef struct _DATA_SETUP
 	int numSamples;					// number of total samples
 	int maxSamples;					// maximum number of samples for allocation purposes
 	int numPopPartitions;			// number of partitions to break each pop into for stats
+	int maxMigs;					// maximum number of migration events per genealogy
 	
 	int* numSamplesPerPop;			// number of samples per population
 	char**		sampleNames;		// array of sample names - ordered according to population order
@@ -12,8 +12,13 @@
 #include "MemoryMng.h"
 #include "DataLayer.h"
 #include "MCMCcontrol.h"
+#include "GPhoCS.h"
+#include "PopInterval.h"
+#include "MultiCoreUtils.h"
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <new>
 #include "EventsDAG.h"
 
 
@@ -35,11 +40,284 @@ int**                nodeEvents;
 Locus_SuperStruct*   locus_data;
 extern DAGsPerLocus<Event>* pAllDAGs;
 
+// memory of arrays of total stats (see allocGenetreeStats)
+static char*         totalStatsArrays;
+
+
+/*-----------------------------------------------------------------------------
+ *
+ * Per-locus blocks
+ *
+ * Arrays sized by number of samples, populations, migration bands and
+ * max number of migrations (max-migs) of each locus are packed in a
+ * single block per locus, which is part of the arena of the locus.
+ *
+ *---------------------------------------------------------------------------*/
+
+#define ARENA_LINE_SIZE 64
+
+typedef struct _LOCUS_BLOCK
+{
+  char*  base;      // start of block (nullptr when only measuring size)
+  size_t size;      // number of bytes carved out of block so far
+  size_t capacity;  // size of block (bytes)
+} LOCUS_BLOCK;
+
+// arenas of all loci (see allocLocusArenas)
+static LOCUS_BLOCK*  locusArenas;
+
+//-----------------------------------------------------------------------------
+// carves an array of given size (in bytes, rounded up to 8) out of a block
+static void* carveArray(LOCUS_BLOCK* block, size_t bytes)
+{
+  void* array = (block->base == nullptr) ? nullptr : block->base + block->size;
+  block->size += (bytes + 7) & ~(size_t)7;
+  return array;
+}
+
+//-----------------------------------------------------------------------------
+// carves an array of given size out of a block, starting on a cache line
+static void* carveLine(LOCUS_BLOCK* block, size_t bytes)
+{
+  block->size = (block->size + ARENA_LINE_SIZE - 1) & ~(size_t)(ARENA_LINE_SIZE - 1);
+  return carveArray(block, bytes);
+}
+
+//-----------------------------------------------------------------------------
+// sets arrays of genetree stats to arrays carved out of a block
+static void layoutGenetreeStats(GENETREE_STATS* stats, LOCUS_BLOCK* block)
+{
+  int numPops     = dataSetup.popTree->numPops;
+  int numMigBands = dataSetup.popTree->numMigBands;
+
+  stats->coal_stats = (double*)carveArray(block, numPops     * sizeof(double));
+  stats->mig_stats  = (double*)carveArray(block, numMigBands * sizeof(double));
+  stats->num_coals  = (int*)   carveArray(block, numPops     * sizeof(int));
+  stats->num_migs   = (int*)   carveArray(block, numMigBands * sizeof(int));
+}
+
+//-----------------------------------------------------------------------------
+// sets all sized arrays of given locus to arrays carved out of a block
+static void layoutLocusBlock(int gen, LOCUS_BLOCK* block)
+{
+  int i;
+  int numPops     = dataSetup.popTree->numPops;
+  int numMigBands = dataSetup.popTree->numMigBands;
+  int maxMigs     = dataSetup.maxMigs;
+  int maxNodes    = 2 * dataSetup.numSamples - 1;
+  Locus_SuperStruct* data = &locus_data[gen];
+
+  event_chains[gen].first_event = (int*)carveArray(block, numPops * sizeof(int));
+  event_chains[gen].last_event  = (int*)carveArray(block, numPops * sizeof(int));
+
+  genetree_migs[gen].living_mignodes = (int*)carveArray(block, maxMigs * sizeof(int));
+  genetree_migs[gen].mignodes =
+    (GENETREE_MIGS::MIGNODE*)carveArray(block, maxMigs * sizeof(GENETREE_MIGS::MIGNODE));
+
+  layoutGenetreeStats(&genetree_stats[gen], block);
+  layoutGenetreeStats(&data->genetree_stats_check, block);
+
+  for( i = 0; i < NUM_DELTA_STATS_INSTANCES; ++i )
+  {
+    GENETREE_STATS_DELTA* delta = &data->genetree_stats_delta[i];
+    delta->pops_changed      = (int*)   carveArray(block, numPops     * sizeof(int));
+    delta->mig_bands_changed = (int*)   carveArray(block, numMigBands * sizeof(int));
+    delta->coal_stats_delta  = (double*)carveArray(block, numPops     * sizeof(double));
+    delta->mig_stats_delta   = (double*)carveArray(block, numMigBands * sizeof(double));
+  }
+
+  data->rubberband_migs.orig_events = (int*)   carveArray(block, (maxMigs + numMigBands) * sizeof(int));
+  data->rubberband_migs.new_events  = (int*)   carveArray(block, (maxMigs + numMigBands) * sizeof(int));
+  data->rubberband_migs.pops        = (int*)   carveArray(block, (maxMigs + numMigBands) * sizeof(int));
+  data->rubberband_migs.new_ages    = (double*)carveArray(block, (maxMigs + numMigBands) * sizeof(double));
+
+  data->mig_spr_stats.old_migs       = (int*)   carveArray(block, maxMigs * sizeof(int));
+  data->mig_spr_stats.new_migs_in    = (int*)   carveArray(block, maxMigs * sizeof(int));
+  data->mig_spr_stats.new_migs_out   = (int*)   carveArray(block, maxMigs * sizeof(int));
+  data->mig_spr_stats.new_migs_bands = (int*)   carveArray(block, maxMigs * sizeof(int));
+  data->mig_spr_stats.new_migs_ages  = (double*)carveArray(block, maxMigs * sizeof(double));
+
+  data->scratch.rubberband_mig_bands = (int*)carveArray(block, numMigBands * sizeof(int));
+  data->scratch.ripple_pops          = (int*)carveArray(block, numPops     * sizeof(int));
+  data->scratch.recalc_mig_bands     = (int*)carveArray(block, numMigBands * sizeof(int));
+  data->scratch.trace_mig_bands      = (int*)carveArray(block, numMigBands * sizeof(int));
+  data->scratch.trace_targets        = (int*)carveArray(block, maxNodes    * sizeof(int));
+}
+
+//-----------------------------------------------------------------------------
+// allocates (zeroed) arrays of total genetree stats and of stats partitions
+static void allocGenetreeStats()
+{
+  int i;
+  LOCUS_BLOCK block = {nullptr, 0};
+
+  // measure size of arrays of a single stats struct
+  layoutGenetreeStats(&genetree_stats_total, &block);
+  totalStatsArrays = (char*)calloc( 2 + dataSetup.numPopPartitions, block.size );
+  if(totalStatsArrays == nullptr)
+  {
+    fprintf(stderr, "\nError: Out Of Memory genetree stats total.\n");
+    exit(-1);
+  }
+
+  block.base = totalStatsArrays;
+  block.size = 0;
+  layoutGenetreeStats(&genetree_stats_total, &block);
+  layoutGenetreeStats(&genetree_stats_total_check, &block);
+  for( i = 0; i < dataSetup.numPopPartitions; ++i )
+    layoutGenetreeStats(&genetree_stats_total_partitioned[i], &block);
+}
+
+
+/*-----------------------------------------------------------------------------
+ *
+ * getMaxLocusEvents
+ *
+ *---------------------------------------------------------------------------*/
+
+int getMaxLocusEvents()
+{
+  // start and end of each population, sample start of each population,
+  // coalescences, migrations (in and out, with room for a proposal),
+  // migration band starts and ends, and spares (the pool is never empty).
+  return   3 * dataSetup.popTree->numPops
+         + dataSetup.numSamples
+         + 3 * dataSetup.maxMigs
+         + 2 * dataSetup.popTree->numMigBands
+         + 2;
+}
+/** end of getMaxLocusEvents **/
+
+
+/*-----------------------------------------------------------------------------
+ *
+ * Per-locus arenas
+ *
+ * All hot state of a locus - likelihood data and conditionals, event pool,
+ * node surrogates, per-locus block and interval pools - is held in a single
+ * cache-line aligned arena, in this order. Each arena is allocated and first
+ * touched by the thread that handles the locus in (STATIC scheduled) locus
+ * loops, so its pages are placed near that thread (arenas are page-aligned
+ * with thread-placement NUMA, see MultiCoreUtils.h).
+ *
+ *---------------------------------------------------------------------------*/
+
+//-----------------------------------------------------------------------------
+// lays out arena of given locus (measures only if block has no base).
+// interval pools are not laid out, only measured (see locusArenaAlloc).
+static void layoutLocusArena(int gen, LOCUS_BLOCK* block)
+{
+  int i;
+  int maxNodes = 2 * dataSetup.numSamples - 1;
+  char* locusDataBlock;
+  Event* events;
+
+  locusDataBlock = (char*)carveLine(block,
+                          getLocusDataArenaSize(dataState.lociData[gen]));
+  events = (Event*)carveLine(block, event_chains[gen].total_events * sizeof(Event));
+  nodePops[gen]   = (int*)carveLine(block, maxNodes * sizeof(int));
+  nodeEvents[gen] = (int*)carveArray(block, maxNodes * sizeof(int));
+  carveLine(block, 0);
+  layoutLocusBlock(gen, block);
+
+  if(block->base == nullptr)
+  {
+    // proposal and original interval pools of LocusPopIntervals
+    for( i = 0; i < 2; ++i )
+      carveLine(block, getMaxLocusEvents() * sizeof(PopInterval));
+    carveLine(block, 0);
+    return;
+  }
+
+  dataState.lociData[gen] = moveLocusDataToArena(dataState.lociData[gen],
+                                                 locusDataBlock);
+  event_chains[gen].events = events;
+  for( i = 0; i < event_chains[gen].total_events; ++i )
+    new (&events[i]) Event();
+}
+
+//-----------------------------------------------------------------------------
+// allocates and lays out arenas of all loci (after loci data are created)
+static void allocLocusArenas()
+{
+  int gen;
+  size_t alignment = getLocusArenaAlignment();
+
+  locusArenas = (LOCUS_BLOCK*)calloc( dataSetup.numLoci, sizeof(LOCUS_BLOCK) );
+  if(locusArenas == nullptr)
+  {
+    fprintf(stderr, "\nError: Out Of Memory locus arenas.\n");
+    exit(-1);
+  }
+  for( gen = 0; gen < dataSetup.numLoci; ++gen )
+  {
+    layoutLocusArena(gen, &locusArenas[gen]);
+    locusArenas[gen].capacity = (locusArenas[gen].size + alignment - 1)
+                                / alignment * alignment;
+    locusArenas[gen].size     = 0;
+  }
+
+  // same assignment of loci to threads as STATIC locus scheduling
+#pragma omp parallel for schedule(static)
+  for( gen = 0; gen < dataSetup.numLoci; ++gen )
+  {
+    void* base;
+    if(0 != posix_memalign(&base, alignment, locusArenas[gen].capacity))
+    {
+      fprintf(stderr, "\nError: Out Of Memory arena of locus %d.\n", gen + 1);
+      exit(-1);
+    }
+    memset(base, 0, locusArenas[gen].capacity);
+    locusArenas[gen].base = (char*)base;
+    layoutLocusArena(gen, &locusArenas[gen]);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void* locusArenaAlloc(int gen, size_t bytes)
+{
+  LOCUS_BLOCK* arena = &locusArenas[gen];
+  void* array = carveLine(arena, bytes);
+
+  if(arena->size > arena->capacity)
+  {
+    fprintf(stderr, "\nError: arena of locus %d exhausted (%zu bytes).\n",
+            gen + 1, arena->capacity);
+    exit(-1);
+  }
+  return array;
+}
+/** end of locusArenaAlloc **/
+
+//-----------------------------------------------------------------------------
+size_t getLocusArenaSize(int gen)
+{
+  return locusArenas[gen].capacity;
+}
+/** end of getLocusArenaSize **/
+
+//-----------------------------------------------------------------------------
+void freeLocusArenas()
+{
+  int gen;
+
+  if(locusArenas == nullptr)
+    return;
+  for( gen = 0; gen < dataSetup.numLoci; ++gen )
+    free(locusArenas[gen].base);
+  free(locusArenas);
+  locusArenas = nullptr;
+}
+/** end of freeLocusArenas **/
+
 
 /*-----------------------------------------------------------------------------
  *
  * GetMem
  *
+ * Called after loci data are created, since they are moved into the
+ * arenas of the loci.
+ *
  *---------------------------------------------------------------------------*/
 
 int GetMem( void )
@@ -49,8 +327,9 @@ int GetMem( void )
 
   // for debugging purposes   ELIMINATE LATER !!!!
 
+  // zeroed, since stats deltas hold vectors (reserved in init() below)
   locus_data = (Locus_SuperStruct*)
-               malloc( dataSetup.numLoci * sizeof(Locus_SuperStruct) );
+               calloc( dataSetup.numLoci, sizeof(Locus_SuperStruct) );
   if(locus_data == nullptr)
   {
     fprintf(stderr, "\nError: Out Of Memory genLogLikelihood.\n");
@@ -65,20 +344,8 @@ int GetMem( void )
     fprintf(stderr, "\nError: Out Of Memory nodePop array.\n");
     exit(-1);
   }
+  // node arrays of each locus are allocated in its arena (see below)
   nodeEvents  = nodePops + dataSetup.numLoci;
-  nodePops[0] = (int*)
-                malloc( 2 * dataSetup.numLoci * maxNodes * sizeof(int) );
-  if( nodePops[0] == nullptr )
-  {
-    fprintf(stderr, "\nError: Out Of Memory nodePop space.\n");
-    exit(-1);
-  }
-
-  for( gen = 0; gen < dataSetup.numLoci; ++gen )
-  {
-    nodePops[gen]   = nodePops[0]   + maxNodes * gen;
-    nodeEvents[gen] = nodePops[gen] + maxNodes * dataSetup.numLoci;
-  }
 
   // get memory for genetree_migs and initialize
   // get memory for event_chains and stats and initialize
@@ -104,6 +371,23 @@ int GetMem( void )
   }
 
   event_chains.reserve( dataSetup.numLoci );
+
+  // max number of events should cover all possible
+  // coalescences (+1 auxiliary),
+  // migrations (X2), added migrations (X2) and population endings,
+  // and migration bands (start + end + changed event).
+  for( gen = 0; gen < dataSetup.numLoci; ++gen )
+    event_chains[gen].total_events  =    2 * dataSetup.numSamples
+                                       + 4 * dataSetup.maxMigs
+                                       + 3 * dataSetup.popTree->numMigBands
+                                       + dataSetup.popTree->numPops
+                                       + 10;
+
+  // event pools, node arrays and per-locus blocks (and locus data) of
+  // each locus are held in its arena
+  allocLocusArenas();
+  allocGenetreeStats();
+
   pAllDAGs = new DAGsPerLocus<Event>( dataSetup.numLoci, dataSetup.popTree->numPops);
 
   genetree_stats_flat.sortedAgesArray = (double*)
@@ -115,38 +399,11 @@ int GetMem( void )
   }
 
 
-  // max number of events should cover all possible
-  // coalescences (+1 auxiliary),
-  // migrations (X2), added migrations (X2) and population endings,
-  // and migration bands (start + end + changed event).
-  event_chains[0].total_events  =    2 * dataSetup.numSamples
-                                   + 4 * MAX_MIGS
-                                   + 3 * dataSetup.popTree->numMigBands
-                                   + dataSetup.popTree->numPops
-                                   + 10;
-  for( gen = 1; gen < dataSetup.numLoci; ++gen )
-    event_chains[gen].total_events = event_chains[0].total_events;
-
-  // compute max number of events for all loci
-  count = event_chains[0].total_events * dataSetup.numLoci;
-
-  event_chains[0].events = new Event[count];
-  if(event_chains[0].events == nullptr)
-  {
-    fprintf(stderr, "\nError: Out Of Memory event space.\n");
-    exit(-1);
-  }
-
   for( gen = 0; gen < dataSetup.numLoci; ++gen )
   {
-    if( gen > 0 )
-    {
-      event_chains[gen].events =   event_chains[gen-1].events
-                                 + event_chains[gen-1].total_events;
-    }
     genetree_migs[gen].num_migs = 0;
     //initialize mignodes
-    for( i = 0; i < MAX_MIGS; ++i)
+    for( i = 0; i < dataSetup.maxMigs; ++i)
     {
       genetree_migs[gen].mignodes[i].age            =  0;
       genetree_migs[gen].mignodes[i].target_pop     = -1;
@@ -160,7 +417,11 @@ int GetMem( void )
 
     // initialize genetree_stats_delta
     for( i = 0; i < NUM_DELTA_STATS_INSTANCES; ++i)
+    {
       locus_data[gen].genetree_stats_delta[i].init();
+      locus_data[gen].genetree_stats_delta[i].changed_events.reserve(
+                                                        getMaxLocusEvents());
+    }
 
   }
   // initialize genetree_node_stats
@@ -259,13 +520,13 @@ int GetMem( void )
 int FreeMem (void)
 {
   // free(genLogLikelihood);
-  free(nodePops[0]);
   free(nodePops);
   free(genetree_migs);
   free(genetree_stats);
   free(genetree_stats_total_partitioned);
+  free(totalStatsArrays);
   //free(rubberband_migs);
-  free(event_chains[0].events);
+  freeLocusArenas();
   //free(event_chains); //done by STL
   free(genetree_stats_flat.sortedAgesArray);
   free(genetree_node_stats.doubleArray);
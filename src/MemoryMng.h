@@ -19,6 +19,16 @@
 int GetMem();
 int FreeMem();
 
+// max number of events in population intervals of a locus
+int getMaxLocusEvents();
+
+// per-locus arenas (allocated by GetMem, after loci data are created):
+// allocation from arena of a locus (never freed on its own), size of arena
+// of a locus (bytes), and freeing of all arenas (called by FreeMem)
+void*  locusArenaAlloc(int gen, size_t bytes);
+size_t getLocusArenaSize(int gen);
+void   freeLocusArenas();
+
 /*-----------------------------------------------------------------------------
  *
  * Global data structures
@@ -0,0 +1,616 @@
+/**
+   \file MultiCoreUtils.cpp
+   Run-time control of multi-threaded locus loops.
+
+   Contains the locus scheduler which determines the order in which loci
+   are handed out to threads, and the OpenMP schedule used for locus loops,
+   and the per-move threading settings which determine which moves run their
+   locus loops in parallel and with how many threads, and the placement of
+   threads (and of locus memory) on NUMA nodes.
+*/
+#include "MultiCoreUtils.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <vector>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+
+struct LOCUS_SCHEDULER locusScheduler = {LOCUS_SCHED_STATIC, 0, 0, nullptr, nullptr, nullptr};
+
+/* weight of newly measured times when refining cost estimates */
+#define LOCUS_COST_SMOOTHING	0.5
+
+
+struct LOCUS_PARTIAL_SUMS locusPartialSums = {0, 0, 0, nullptr};
+
+/* size (in bytes) of a cache line, for padding of per-locus partial sums */
+#define CACHE_LINE_SIZE	64
+
+
+struct THREAD_PLACEMENT threadPlacement = {THREAD_PLACEMENT_NONE, 0, 0, nullptr, nullptr};
+
+/* max id of NUMA nodes looked up in sysfs */
+#define MAX_NUMA_NODES	256
+
+/* default: all moves threaded in AUTO mode with all available threads */
+struct MOVE_THREADING moveThreading[NUM_THREADED_MOVES] = {
+	{MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0},
+	{MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0},
+	{MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}, {MOVE_THREADS_AUTO, 0, 0}
+};
+
+/* move names used in control file, ordered as in ThreadedMove */
+static const char* moveThreadingNames[NUM_THREADED_MOVES] = {
+	"coal-time", "mig-time", "spr", "theta", "mig-rate", "tau", "sample-age", "locus-rate", "mixing", "sync-events", "checks", "comb-stats"
+};
+
+/* minimal number of loci per thread for a move to run in parallel in AUTO mode.
+ * moves which traverse and re-embed genealogies (and recompute data likelihood)
+ * do enough work per locus to be worth forking for a couple of loci per thread.
+ * theta and mig-rate only re-evaluate a closed-form genealogy likelihood per
+ * locus, so they need many loci per thread to pay for the parallel region.
+ * sync-events only walks the event chains of each locus once. checks
+ * recompute the full data likelihood of each checked locus. comb-stats walks
+ * the event chains of each locus once per comb.
+ */
+static const int moveAutoMinLociPerThread[NUM_THREADED_MOVES] = {
+	2, 2, 2, 1000, 1000, 2, 2, 2, 2, 100, 2, 20
+};
+
+
+
+/***********************************************************************************
+ *	sortLociByCost
+ *	- sorts locus order by decreasing cost (ties broken by locus id)
+ ***********************************************************************************/
+static void sortLociByCost() {
+	const double* cost = locusScheduler.cost;
+	std::sort(locusScheduler.order, locusScheduler.order + locusScheduler.numLoci,
+	          [cost](int a, int b) { return (cost[a] > cost[b]) || (cost[a] == cost[b] && a < b); });
+}
+/** end of sortLociByCost **/
+
+
+
+/***********************************************************************************
+ *	setRuntimeSchedule
+ *	- sets OpenMP runtime schedule according to scheduling strategy and given
+ *		chunk size (0 means OpenMP default)
+ ***********************************************************************************/
+static void setRuntimeSchedule(int chunkSize) {
+	switch(locusScheduler.mode) {
+	case LOCUS_SCHED_STATIC:
+		omp_set_schedule(omp_sched_static, chunkSize);
+		break;
+	case LOCUS_SCHED_DYNAMIC:
+		omp_set_schedule(omp_sched_dynamic, chunkSize);
+		break;
+	case LOCUS_SCHED_GUIDED:
+		omp_set_schedule(omp_sched_guided, chunkSize);
+		break;
+	case LOCUS_SCHED_COST:
+		omp_set_schedule(omp_sched_dynamic, max2(chunkSize, 1));
+		break;
+	}
+}
+/** end of setRuntimeSchedule **/
+
+
+
+/***********************************************************************************
+ *	parseLocusScheduling
+ *	- parses name of scheduling strategy (STATIC, DYNAMIC, GUIDED or COST) and optional
+ *		chunk size (nullptr if not specified) into locusScheduler
+ *	- returns 0 if all OK, and -1 otherwise.
+ ***********************************************************************************/
+int parseLocusScheduling(const char* name, const char* chunk) {
+	int chunkSize = 0;
+
+	if(0 == strcmp("STATIC", name)) {
+		locusScheduler.mode = LOCUS_SCHED_STATIC;
+	} else if(0 == strcmp("DYNAMIC", name)) {
+		locusScheduler.mode = LOCUS_SCHED_DYNAMIC;
+	} else if(0 == strcmp("GUIDED", name)) {
+		locusScheduler.mode = LOCUS_SCHED_GUIDED;
+	} else if(0 == strcmp("COST", name)) {
+		locusScheduler.mode = LOCUS_SCHED_COST;
+	} else {
+		fprintf(stderr, "Error: value of locus-scheduling should be STATIC, DYNAMIC, GUIDED, or COST, got %s.\n", name);
+		return -1;
+	}
+
+	if(chunk != nullptr) {
+		if(sscanf(chunk, "%d", &chunkSize) != 1 || chunkSize <= 0) {
+			fprintf(stderr, "Error: chunk size for locus-scheduling should be positive integer, got %s.\n", chunk);
+			return -1;
+		}
+	}
+	locusScheduler.chunkSize = chunkSize;
+
+	return 0;
+}
+/** end of parseLocusScheduling **/
+
+
+
+/***********************************************************************************
+ *	initLocusScheduler
+ *	- allocates scheduler arrays and sets initial locus order according to given
+ *		cost estimates (array of length numLoci)
+ *	- sets OpenMP runtime schedule according to scheduling strategy
+ *	- returns 0
+ ***********************************************************************************/
+int initLocusScheduler(int numLoci, double* initialCosts) {
+	int locus;
+
+	locusScheduler.numLoci = numLoci;
+	locusScheduler.order = (int*)malloc(numLoci*sizeof(int));
+	locusScheduler.cost = (double*)malloc(2*numLoci*sizeof(double));
+	if(locusScheduler.order == nullptr || locusScheduler.cost == nullptr) {
+		fprintf(stderr, "\nError: Out Of Memory while allocating locus scheduler.\n");
+		exit(-1);
+	}
+	locusScheduler.measuredTime = locusScheduler.cost + numLoci;
+
+	for(locus=0; locus<numLoci; locus++) {
+		locusScheduler.order[locus] = locus;
+		locusScheduler.cost[locus] = (initialCosts != nullptr) ? initialCosts[locus] : 1.0;
+		locusScheduler.measuredTime[locus] = 0.0;
+	}
+
+	if(locusScheduler.mode == LOCUS_SCHED_COST) {
+		// most expensive loci first, each idle thread grabs the next one
+		sortLociByCost();
+	}
+	setRuntimeSchedule(locusScheduler.chunkSize);
+
+	return 0;
+}
+/** end of initLocusScheduler **/
+
+
+
+/***********************************************************************************
+ *	freeLocusScheduler
+ *	- frees scheduler arrays
+ ***********************************************************************************/
+void freeLocusScheduler() {
+	free(locusScheduler.order);
+	free(locusScheduler.cost);
+	locusScheduler.order = nullptr;
+	locusScheduler.cost = locusScheduler.measuredTime = nullptr;
+	locusScheduler.numLoci = 0;
+}
+/** end of freeLocusScheduler **/
+
+
+
+/***********************************************************************************
+ *	getLocusSchedulingName
+ *	- returns name of current scheduling strategy
+ ***********************************************************************************/
+const char* getLocusSchedulingName() {
+	switch(locusScheduler.mode) {
+	case LOCUS_SCHED_STATIC:	return "STATIC";
+	case LOCUS_SCHED_DYNAMIC:	return "DYNAMIC";
+	case LOCUS_SCHED_GUIDED:	return "GUIDED";
+	case LOCUS_SCHED_COST:		return "COST";
+	}
+	return "UNKNOWN";
+}
+/** end of getLocusSchedulingName **/
+
+
+
+/***********************************************************************************
+ *	updateLocusSchedule
+ *	- in COST mode, refines cost estimates using measured locus times and re-sorts
+ *		loci by decreasing cost. measured times are then reset.
+ *	- does nothing in other modes
+ ***********************************************************************************/
+void updateLocusSchedule() {
+	int locus;
+	double totalTime = 0.0, totalCost = 0.0;
+
+	if(locusScheduler.mode != LOCUS_SCHED_COST)
+		return;
+
+	for(locus=0; locus<locusScheduler.numLoci; locus++) {
+		totalTime += locusScheduler.measuredTime[locus];
+		totalCost += locusScheduler.cost[locus];
+	}
+	if(totalTime <= 0.0 || totalCost <= 0.0)
+		return;
+
+	// bring measured times to the scale of current estimates and blend them in
+	for(locus=0; locus<locusScheduler.numLoci; locus++) {
+		locusScheduler.cost[locus] =
+			(1.0 - LOCUS_COST_SMOOTHING) * locusScheduler.cost[locus] +
+			LOCUS_COST_SMOOTHING * locusScheduler.measuredTime[locus] * totalCost / totalTime;
+		locusScheduler.measuredTime[locus] = 0.0;
+	}
+
+	sortLociByCost();
+}
+/** end of updateLocusSchedule **/
+
+
+
+/***********************************************************************************
+ *	initLocusPartialSums
+ *	- allocates (cache-line aligned) partial sums for given number of loci,
+ *		populations and migration bands, and sets them all to 0
+ *	- returns 0
+ ***********************************************************************************/
+int initLocusPartialSums(int numLoci, int numPops, int numMigBands) {
+	int doublesPerLine = CACHE_LINE_SIZE / sizeof(double);
+	void* values;
+
+	locusPartialSums.numLoci = numLoci;
+	locusPartialSums.numPops = numPops;
+	locusPartialSums.stride = LOCUS_SUM_STATS + numPops + numMigBands;
+	locusPartialSums.stride = ((locusPartialSums.stride + doublesPerLine - 1) / doublesPerLine) * doublesPerLine;
+
+	if(0 != posix_memalign(&values, CACHE_LINE_SIZE, numLoci*locusPartialSums.stride*sizeof(double))) {
+		fprintf(stderr, "\nError: Out Of Memory while allocating locus partial sums.\n");
+		exit(-1);
+	}
+	locusPartialSums.values = (double*)values;
+	memset(locusPartialSums.values, 0, numLoci*locusPartialSums.stride*sizeof(double));
+
+	return 0;
+}
+/** end of initLocusPartialSums **/
+
+
+
+/***********************************************************************************
+ *	freeLocusPartialSums
+ *	- frees partial sums
+ ***********************************************************************************/
+void freeLocusPartialSums() {
+	free(locusPartialSums.values);
+	locusPartialSums.values = nullptr;
+	locusPartialSums.numLoci = 0;
+}
+/** end of freeLocusPartialSums **/
+
+
+
+/***********************************************************************************
+ *	reduceLocusPartialSums
+ *	- adds partial sums of given slot to *total in locus order, and resets them
+ *	- returns sum of partial sums (in locus order)
+ ***********************************************************************************/
+double reduceLocusPartialSums(int slot, double* total) {
+	int locus;
+	double sum = 0.0;
+	double* value = locusPartialSums.values + slot;
+
+	for(locus=0; locus<locusPartialSums.numLoci; locus++, value+=locusPartialSums.stride) {
+		if(*value != 0.0) {
+			sum += *value;
+			if(total != nullptr) {
+				*total += *value;
+			}
+			*value = 0.0;
+		}
+	}
+
+	return sum;
+}
+/** end of reduceLocusPartialSums **/
+
+
+
+/***********************************************************************************
+ *	parseMoveThreading
+ *	- parses threading settings for a move (or for "all" moves): move name, mode
+ *		(ON, OFF or AUTO) and optional number of threads and chunk size
+ *		(nullptr if not specified)
+ *	- returns 0 if all OK, and -1 otherwise.
+ ***********************************************************************************/
+int parseMoveThreading(const char* moveName, const char* mode, const char* threads, const char* chunk) {
+	struct MOVE_THREADING settings = {MOVE_THREADS_AUTO, 0, 0};
+	int move;
+
+	if(mode == nullptr) {
+		fprintf(stderr, "Error: move-threads for %s should specify ON, OFF, or AUTO.\n", moveName);
+		return -1;
+	} else if(0 == strcmp("ON", mode)) {
+		settings.mode = MOVE_THREADS_ON;
+	} else if(0 == strcmp("OFF", mode)) {
+		settings.mode = MOVE_THREADS_OFF;
+	} else if(0 == strcmp("AUTO", mode)) {
+		settings.mode = MOVE_THREADS_AUTO;
+	} else {
+		fprintf(stderr, "Error: mode of move-threads should be ON, OFF, or AUTO, got %s.\n", mode);
+		return -1;
+	}
+
+	if(threads != nullptr) {
+		if(sscanf(threads, "%d", &settings.numThreads) != 1 || settings.numThreads < 0) {
+			fprintf(stderr, "Error: number of threads in move-threads should be non-negative integer, got %s.\n", threads);
+			return -1;
+		}
+	}
+	if(chunk != nullptr) {
+		if(sscanf(chunk, "%d", &settings.chunkSize) != 1 || settings.chunkSize < 0) {
+			fprintf(stderr, "Error: chunk size in move-threads should be non-negative integer, got %s.\n", chunk);
+			return -1;
+		}
+	}
+
+	if(0 == strcmp("all", moveName)) {
+		for(move=0; move<NUM_THREADED_MOVES; move++) {
+			moveThreading[move] = settings;
+		}
+		return 0;
+	}
+
+	for(move=0; move<NUM_THREADED_MOVES; move++) {
+		if(0 == strcmp(moveThreadingNames[move], moveName)) {
+			moveThreading[move] = settings;
+			return 0;
+		}
+	}
+
+	fprintf(stderr, "Error: move name in move-threads should be one of all");
+	for(move=0; move<NUM_THREADED_MOVES; move++) {
+		fprintf(stderr, ", %s", moveThreadingNames[move]);
+	}
+	fprintf(stderr, ". Got %s.\n", moveName);
+	return -1;
+}
+/** end of parseMoveThreading **/
+
+
+
+/***********************************************************************************
+ *	getMoveNumThreads
+ *	- returns number of threads to use in locus loops of given move
+ ***********************************************************************************/
+static int getMoveNumThreads(ThreadedMove move, int numLoci) {
+	int numThreads = omp_get_max_threads();
+
+	if(moveThreading[move].numThreads > 0) {
+		numThreads = min2(numThreads, moveThreading[move].numThreads);
+	}
+
+	switch(moveThreading[move].mode) {
+	case MOVE_THREADS_OFF:
+		return 1;
+	case MOVE_THREADS_ON:
+		break;
+	case MOVE_THREADS_AUTO:
+		numThreads = min2(numThreads, numLoci / moveAutoMinLociPerThread[move]);
+		break;
+	}
+
+	if(threadPlacement.mode == THREAD_PLACEMENT_NUMA && numThreads > 1) {
+		// all threads take part, so that each locus is handled by its owner
+		numThreads = omp_get_max_threads();
+	}
+
+	return max2(numThreads, 1);
+}
+/** end of getMoveNumThreads **/
+
+
+
+/***********************************************************************************
+ *	beginParallelMove
+ *	- determines number of threads to use in locus loops of given move, according
+ *		to move settings and number of loci, and sets the OpenMP run-time schedule
+ *		for the move
+ *	- returns number of threads (1 means loops should run serially)
+ ***********************************************************************************/
+int beginParallelMove(ThreadedMove move, int numLoci) {
+	int numThreads = getMoveNumThreads(move, numLoci);
+
+	if(threadPlacement.mode == THREAD_PLACEMENT_NUMA) {
+		setRuntimeSchedule(0);
+	} else if(numThreads > 1) {
+		setRuntimeSchedule(moveThreading[move].chunkSize > 0 ? moveThreading[move].chunkSize : locusScheduler.chunkSize);
+	}
+
+	return numThreads;
+}
+/** end of beginParallelMove **/
+
+
+
+/***********************************************************************************
+ *	printMoveThreading
+ *	- prints threading settings of all moves for given number of loci
+ ***********************************************************************************/
+void printMoveThreading(int numLoci) {
+	static const char* modeNames[] = {"OFF", "ON", "AUTO"};
+	int move;
+
+	printf("Threads used by each move (max %d threads):\n", omp_get_max_threads());
+	for(move=0; move<NUM_THREADED_MOVES; move++) {
+		printf("  %-12s %-5s %2d threads", moveThreadingNames[move], modeNames[moveThreading[move].mode], getMoveNumThreads((ThreadedMove)move, numLoci));
+		if(moveThreading[move].chunkSize > 0) {
+			printf(", chunk %d", moveThreading[move].chunkSize);
+		}
+		printf("\n");
+	}
+}
+/** end of printMoveThreading **/
+
+
+
+/***********************************************************************************
+ *	parseThreadPlacement
+ *	- parses thread placement mode (NONE or NUMA) into threadPlacement
+ *	- returns 0 if all OK, and -1 otherwise.
+ ***********************************************************************************/
+int parseThreadPlacement(const char* mode) {
+	if(0 == strcmp("NONE", mode)) {
+		threadPlacement.mode = THREAD_PLACEMENT_NONE;
+	} else if(0 == strcmp("NUMA", mode)) {
+		threadPlacement.mode = THREAD_PLACEMENT_NUMA;
+	} else {
+		fprintf(stderr, "Error: value of thread-placement should be NONE or NUMA, got %s.\n", mode);
+		return -1;
+	}
+	return 0;
+}
+/** end of parseThreadPlacement **/
+
+
+
+#if defined(ENABLE_OMP_THREADS) && defined(__linux__)
+/***********************************************************************************
+ *	readNumaNodeCpus
+ *	- reads CPUs of each NUMA node (from sysfs), keeping only CPUs of given set
+ *	- fills ids of nodes with CPUs in set, and their CPUs. if NUMA topology is not
+ *		available, all CPUs of set are put in a single node (id 0).
+ ***********************************************************************************/
+static void readNumaNodeCpus(const cpu_set_t* cpuSet, std::vector<int>& nodeIds, std::vector< std::vector<int> >& nodeCpus) {
+	char fileName[64], line[4096];
+	char* range;
+	int node, cpu, first, last, numChars;
+	FILE* file;
+
+	for(node=0; node<MAX_NUMA_NODES; node++) {
+		snprintf(fileName, sizeof(fileName), "/sys/devices/system/node/node%d/cpulist", node);
+		file = fopen(fileName, "r");
+		if(file == nullptr)
+			continue;
+
+		// list of CPU ranges (e.g. 0-3,8-11)
+		std::vector<int> cpus;
+		range = fgets(line, sizeof(line), file);
+		while(range != nullptr && sscanf(range, "%d%n", &first, &numChars) == 1) {
+			range += numChars;
+			last = first;
+			if(*range == '-' && sscanf(range+1, "%d%n", &last, &numChars) == 1) {
+				range += 1 + numChars;
+			}
+			for(cpu=first; cpu<=last && cpu<CPU_SETSIZE; cpu++) {
+				if(CPU_ISSET(cpu, cpuSet))
+					cpus.push_back(cpu);
+			}
+			range = (*range == ',') ? range+1 : nullptr;
+		}
+		fclose(file);
+
+		if(!cpus.empty()) {
+			nodeIds.push_back(node);
+			nodeCpus.push_back(cpus);
+		}
+	}
+
+	if(nodeCpus.empty()) {
+		std::vector<int> cpus;
+		for(cpu=0; cpu<CPU_SETSIZE; cpu++) {
+			if(CPU_ISSET(cpu, cpuSet))
+				cpus.push_back(cpu);
+		}
+		nodeIds.push_back(0);
+		nodeCpus.push_back(cpus);
+	}
+}
+/** end of readNumaNodeCpus **/
+#endif
+
+
+
+/***********************************************************************************
+ *	initThreadPlacement
+ *	- in NUMA mode, pins all OpenMP threads to CPUs (unless the OpenMP runtime
+ *		already binds threads, through OMP_PROC_BIND) and fixes locus ownership
+ *		(STATIC locus scheduling, with all threads in parallel moves)
+ *	- threads are spread evenly over NUMA nodes in contiguous groups, so that the
+ *		contiguous blocks of loci owned by a group of threads are on one node
+ *	- called before loci memory is allocated
+ *	- returns number of NUMA nodes used by threads (0 if threads were not pinned)
+ ***********************************************************************************/
+int initThreadPlacement() {
+	if(threadPlacement.mode != THREAD_PLACEMENT_NUMA)
+		return 0;
+
+	if(locusScheduler.mode != LOCUS_SCHED_STATIC || locusScheduler.chunkSize != 0) {
+		printf("Thread placement NUMA: using STATIC locus scheduling (instead of %s), so that each locus is handled by its owner.\n",
+		       getLocusSchedulingName());
+		locusScheduler.mode = LOCUS_SCHED_STATIC;
+		locusScheduler.chunkSize = 0;
+	}
+
+#if defined(ENABLE_OMP_THREADS) && defined(__linux__)
+	int numThreads = omp_get_max_threads();
+	int thread, node, numNodes, numFailed = 0;
+	std::vector<int> nodeIds;
+	std::vector< std::vector<int> > nodeCpus;
+	cpu_set_t cpuSet;
+
+	if(omp_get_proc_bind() != omp_proc_bind_false) {
+		printf("Thread placement NUMA: threads are bound by the OpenMP runtime (OMP_PROC_BIND).\n");
+		return 0;
+	}
+	if(0 != sched_getaffinity(0, sizeof(cpuSet), &cpuSet)) {
+		fprintf(stderr, "Warning: unable to get CPU affinity of process, threads are not pinned.\n");
+		return 0;
+	}
+	readNumaNodeCpus(&cpuSet, nodeIds, nodeCpus);
+	numNodes = min2((int)nodeCpus.size(), numThreads);
+
+	threadPlacement.threadCpus = (int*)malloc(2*numThreads*sizeof(int));
+	if(threadPlacement.threadCpus == nullptr) {
+		fprintf(stderr, "\nError: Out Of Memory while allocating thread placement.\n");
+		exit(-1);
+	}
+	threadPlacement.threadNodes = threadPlacement.threadCpus + numThreads;
+
+	// thread t is on node t*numNodes/numThreads, where it has rank
+	// t - (first thread of node), which determines its CPU on node
+	for(thread=0; thread<numThreads; thread++) {
+		node = (int)((long long)thread * numNodes / numThreads);
+		int rank = thread - (int)(((long long)node * numThreads + numNodes - 1) / numNodes);
+		threadPlacement.threadNodes[thread] = nodeIds[node];
+		threadPlacement.threadCpus[thread] = nodeCpus[node][rank % nodeCpus[node].size()];
+	}
+
+#pragma omp parallel num_threads(numThreads) reduction(+:numFailed)
+	{
+		cpu_set_t threadSet;
+		CPU_ZERO(&threadSet);
+		CPU_SET(threadPlacement.threadCpus[omp_get_thread_num()], &threadSet);
+		if(0 != sched_setaffinity(0, sizeof(threadSet), &threadSet))
+			numFailed++;
+	}
+	if(numFailed > 0) {
+		fprintf(stderr, "Warning: unable to pin %d of %d threads to CPUs.\n", numFailed, numThreads);
+	}
+
+	threadPlacement.numThreads = numThreads;
+	threadPlacement.numNodes = numNodes;
+	printf("Thread placement NUMA: pinned %d threads to CPUs on %d NUMA nodes.\n", numThreads, numNodes);
+	return numNodes;
+#else
+	printf("Thread placement NUMA: pinning threads requires a multi-threaded Linux build, threads are not pinned.\n");
+	return 0;
+#endif
+}
+/** end of initThreadPlacement **/
+
+
+
+/***********************************************************************************
+ *	getLocusArenaAlignment
+ *	- returns alignment (and size granularity) of locus arenas: a cache line, or
+ *		a page in NUMA mode
+ ***********************************************************************************/
+size_t getLocusArenaAlignment() {
+	if(threadPlacement.mode == THREAD_PLACEMENT_NUMA) {
+		return (size_t)sysconf(_SC_PAGESIZE);
+	}
+	return CACHE_LINE_SIZE;
+}
+/** end of getLocusArenaAlignment **/
@@ -5,36 +5,374 @@
 
 	#include <omp.h>
 
-	#define THREAD_SCHEDULING_STRATEGY static //use static, dynamic or guided. see openmp help for difference. you can also set: dynamic,100 if you wish to specify the chunk size. DEFAULT = static
-
-	/* flags to disable or enable MT on specific methods
-	 * comment out a DEFINE to disable.
+	/* locus loops are scheduled at run time (see setLocusScheduling below).
+	 * the schedule is set through omp_set_schedule() according to the
+	 * locus-scheduling setting in the control file / command line.
 	 */
+	#define THREAD_SCHEDULING_STRATEGY runtime
 
-	#define THREAD_UpdateGB_InternalNode
-	#define THREAD_UpdateGB_MigrationNode
-	#define THREAD_UpdateGB_MigSPR
-	#define THREAD_UpdateTau
-	#define THREAD_UpdateMigRates
-	#define THREAD_mixing
-	//#define THREAD_UpdateTheta
-	#define THREAD_UpdateSampleAge
+	/* which moves run their locus loops in parallel, and with how many
+	 * threads, is set at run time (see MoveThreading below).
+	 */
 
 #else
 extern "C"{
+  typedef enum omp_sched_t {
+    omp_sched_static = 1,
+    omp_sched_dynamic = 2,
+    omp_sched_guided = 3,
+    omp_sched_auto = 4
+  } omp_sched_t;
+
   void omp_set_num_threads(int n);
   int omp_get_max_threads();
   int omp_get_thread_num();
+  int omp_in_parallel();
+  void omp_set_schedule(omp_sched_t kind, int chunk_size);
+  double omp_get_wtime();
 }
 #endif
 
+#include "Profiler.h"
+
+
+
+/***************************************************************************************************************/
+/******                                    LOCUS SCHEDULING                                               ******/
+/***************************************************************************************************************/
+
+
+
+/*********
+ * LocusScheduling - strategies for handing out loci to threads in locus loops
+ *	- STATIC:  contiguous blocks of loci per thread (OpenMP static)
+ *	- DYNAMIC: loci handed out on demand in chunks (OpenMP dynamic)
+ *	- GUIDED:  loci handed out on demand in shrinking chunks (OpenMP guided)
+ *	- COST:    loci sorted by decreasing estimated cost and handed out on demand,
+ *	           so that idle threads pick up the next most expensive locus.
+ *	           cost is initially estimated as numLivePatterns x numLeaves and is
+ *	           refined by per-locus timings measured during the run.
+ *********/
+typedef enum {
+	LOCUS_SCHED_STATIC = 0,
+	LOCUS_SCHED_DYNAMIC,
+	LOCUS_SCHED_GUIDED,
+	LOCUS_SCHED_COST
+} LocusScheduling;
+
+
+/*********
+ * locus scheduler state
+ *********/
+struct LOCUS_SCHEDULER {
+	LocusScheduling mode;		// scheduling strategy
+	int chunkSize;				// chunk size handed to OpenMP (0 means default)
+	int numLoci;				// number of loci being scheduled
+	int* order;					// order in which loci are handed out (permutation of 0..numLoci-1)
+	double* cost;				// estimated cost of each locus
+	double* measuredTime;		// time (in seconds) measured for each locus since last reordering
+};
+
+extern struct LOCUS_SCHEDULER locusScheduler;
+
+/* locus handed out at position i of a scheduled locus loop */
+#define SCHEDULED_LOCUS(i)	(locusScheduler.order[i])
+
+
+
+/***************************************************************************************************************/
+/******                                    LOCUS PARTIAL SUMS                                             ******/
+/***************************************************************************************************************/
+
+
+
+/*********
+ * LocusSumSlot - quantities summed over loci in parallel locus loops
+ *	each locus adds its contribution to its own slot, and slots are reduced in
+ *	locus order after the loop, so totals do not depend on number of threads or
+ *	on the order in which loci were handed out to threads.
+ *	slots from LOCUS_SUM_STATS on hold per-pop coal stats and per-mig-band
+ *	mig stats deltas of genetree_stats_total (see LOCUS_SUM_COAL_STATS below).
+ *********/
+typedef enum {
+	LOCUS_SUM_DATA_LNLD = 0,	// data log-likelihood
+	LOCUS_SUM_GEN_LNLD,			// genealogy log-likelihood
+	LOCUS_SUM_LNLD,				// total log-likelihood (normalized by number of loci)
+	LOCUS_SUM_ACCEPTED,			// number of accepted proposals
+	LOCUS_SUM_NTJ_BELOW,		// number of nodes moved by rubber band below old age
+	LOCUS_SUM_NTJ_ABOVE,		// number of nodes moved by rubber band above old age
+	LOCUS_SUM_RATE_VAR,			// variance of locus mutation rates
+	LOCUS_SUM_STATS				// first genealogy stats slot
+} LocusSumSlot;
+
+
+/*********
+ * per-locus partial sums
+ *	- row of each locus is padded to a multiple of a cache line, so threads
+ *	  handling different loci never write to the same line
+ *********/
+struct LOCUS_PARTIAL_SUMS {
+	int numLoci;				// number of loci
+	int numPops;				// number of populations (for stats slots)
+	int stride;					// number of doubles per locus (padded)
+	double* values;				// numLoci x stride partial sums
+};
+
+extern struct LOCUS_PARTIAL_SUMS locusPartialSums;
+
+/* partial sum of given slot for given locus */
+#define LOCUS_PARTIAL_SUM(locus, slot)	(locusPartialSums.values[(locus)*locusPartialSums.stride + (slot)])
+
+/* slots for coal stats of a population and mig stats of a migration band */
+#define LOCUS_SUM_COAL_STATS(pop)		(LOCUS_SUM_STATS + (pop))
+#define LOCUS_SUM_MIG_STATS(mig_band)	(LOCUS_SUM_STATS + locusPartialSums.numPops + (mig_band))
+
+
+
+/***********************************************************************************
+ *	initLocusPartialSums
+ *	- allocates (cache-line aligned) partial sums for given number of loci,
+ *		populations and migration bands, and sets them all to 0
+ *	- returns 0
+ ***********************************************************************************/
+int initLocusPartialSums(int numLoci, int numPops, int numMigBands);
+
+
+
+/***********************************************************************************
+ *	freeLocusPartialSums
+ *	- frees partial sums
+ ***********************************************************************************/
+void freeLocusPartialSums();
+
+
+
+/***********************************************************************************
+ *	reduceLocusPartialSums
+ *	- adds partial sums of given slot to *total in locus order, and resets them
+ *	- returns sum of partial sums (in locus order)
+ ***********************************************************************************/
+double reduceLocusPartialSums(int slot, double* total);
+
+
+
+/***************************************************************************************************************/
+/******                                    MOVE THREADING                                                 ******/
+/***************************************************************************************************************/
+
+
+
+/*********
+ * ThreadedMove - MCMC moves (and other per-iteration passes) with parallel locus loops
+ *********/
+typedef enum {
+	MOVE_COAL_TIME = 0,		// UpdateGB_InternalNode
+	MOVE_MIG_TIME,			// UpdateGB_MigrationNode
+	MOVE_SPR,				// UpdateGB_MigSPR
+	MOVE_THETA,				// UpdateTheta
+	MOVE_MIG_RATE,			// UpdateMigRates
+	MOVE_TAU,				// UpdateTau
+	MOVE_SAMPLE_AGE,		// UpdateSampleAge
+	MOVE_LOCUS_RATE,		// UpdateLocusRate
+	MOVE_MIXING,			// mixing
+	MOVE_SYNC_EVENTS,		// synchronizeEvents pass at end of iteration
+	MOVE_CHECKS,			// consistency checks at each log (checkLoci)
+	MOVE_COMB_STATS,		// comb stats computed at each sample (calculateCombStats)
+	NUM_THREADED_MOVES
+} ThreadedMove;
+
+
+/*********
+ * MoveThreadingMode - whether a move runs its locus loops in parallel
+ *	- AUTO runs in parallel only when there are enough loci per thread to
+ *	  amortize the fork/join cost of a parallel region (threshold depends on
+ *	  how much work the move does per locus)
+ *********/
+typedef enum {
+	MOVE_THREADS_OFF = 0,
+	MOVE_THREADS_ON,
+	MOVE_THREADS_AUTO
+} MoveThreadingMode;
+
+
+/*********
+ * threading settings for a single move
+ *********/
+struct MOVE_THREADING {
+	MoveThreadingMode mode;
+	int numThreads;				// max number of threads for move (0 means all available)
+	int chunkSize;				// chunk size for locus loops (0 means locus-scheduling default)
+};
+
+extern struct MOVE_THREADING moveThreading[NUM_THREADED_MOVES];
+
+
+
+/***********************************************************************************
+ *	parseMoveThreading
+ *	- parses threading settings for a move (or for "all" moves): move name, mode
+ *		(ON, OFF or AUTO) and optional number of threads and chunk size
+ *		(nullptr if not specified)
+ *	- returns 0 if all OK, and -1 otherwise.
+ ***********************************************************************************/
+int parseMoveThreading(const char* moveName, const char* mode, const char* threads, const char* chunk);
+
+
+
+/***********************************************************************************
+ *	beginParallelMove
+ *	- determines number of threads to use in locus loops of given move, according
+ *		to move settings and number of loci, and sets the OpenMP run-time schedule
+ *		for the move
+ *	- returns number of threads (1 means loops should run serially)
+ ***********************************************************************************/
+int beginParallelMove(ThreadedMove move, int numLoci);
+
+
+
+/***********************************************************************************
+ *	printMoveThreading
+ *	- prints threading settings of all moves for given number of loci
+ ***********************************************************************************/
+void printMoveThreading(int numLoci);
+
+
+
+/***********************************************************************************
+ *	parseLocusScheduling
+ *	- parses name of scheduling strategy (STATIC, DYNAMIC, GUIDED or COST) and optional
+ *		chunk size (nullptr if not specified) into locusScheduler
+ *	- returns 0 if all OK, and -1 otherwise.
+ ***********************************************************************************/
+int parseLocusScheduling(const char* name, const char* chunk);
+
+
+
+/***********************************************************************************
+ *	initLocusScheduler
+ *	- allocates scheduler arrays and sets initial locus order according to given
+ *		cost estimates (array of length numLoci)
+ *	- sets OpenMP runtime schedule according to scheduling strategy
+ *	- returns 0
+ ***********************************************************************************/
+int initLocusScheduler(int numLoci, double* initialCosts);
+
+
+
+/***********************************************************************************
+ *	freeLocusScheduler
+ *	- frees scheduler arrays
+ ***********************************************************************************/
+void freeLocusScheduler();
+
+
+
+/***********************************************************************************
+ *	getLocusSchedulingName
+ *	- returns name of current scheduling strategy
+ ***********************************************************************************/
+const char* getLocusSchedulingName();
+
+
+
+/***********************************************************************************
+ *	startLocusTimer / stopLocusTimer
+ *	- measure time spent on a given locus (monotonic clock, in nanoseconds)
+ *	- time is added to busy time of calling thread (see Profiler.h), to locus
+ *		profile (if locus profiling is on) and, in COST mode, to measured time of locus
+ *	- each locus is handled by a single thread within a loop, so no locking needed
+ ***********************************************************************************/
+static inline long long startLocusTimer() {
+	return profilerNow();
+}
+
+static inline void stopLocusTimer(int locus, long long startTime) {
+	long long time = profilerNow() - startTime;
+	addThreadBusyTime(time);
+	if(locusProfiles != nullptr)
+		locusProfiles[locus].time += time;
+	if(locusScheduler.mode == LOCUS_SCHED_COST)
+		locusScheduler.measuredTime[locus] += time * 1e-9;
+}
+
+
+
+/***********************************************************************************
+ *	updateLocusSchedule
+ *	- in COST mode, refines cost estimates using measured locus times and re-sorts
+ *		loci by decreasing cost. measured times are then reset.
+ *	- does nothing in other modes
+ ***********************************************************************************/
+void updateLocusSchedule();
+
+
+
+/***************************************************************************************************************/
+/******                                    THREAD PLACEMENT                                               ******/
+/***************************************************************************************************************/
+
+
+
+/*********
+ * ThreadPlacement - placement of threads and of locus memory
+ *	- NONE: threads are not pinned. the arena of each locus is first touched by
+ *	        the thread which handles the locus in STATIC locus loops.
+ *	- NUMA: each thread is pinned to a CPU, with threads spread evenly over NUMA
+ *	        nodes (consecutive threads on the same node). every locus loop hands
+ *	        each locus to the thread that owns it (STATIC scheduling with all
+ *	        threads, the same assignment used when locus arenas are allocated),
+ *	        so the memory of each locus stays on the node of the thread handling
+ *	        it throughout the run. locus arenas are page-aligned, so that no page
+ *	        is shared by loci of different threads.
+ *********/
+typedef enum {
+	THREAD_PLACEMENT_NONE = 0,
+	THREAD_PLACEMENT_NUMA
+} ThreadPlacement;
+
+
+/*********
+ * thread placement state
+ *********/
+struct THREAD_PLACEMENT {
+	ThreadPlacement mode;		// placement mode
+	int numThreads;				// number of threads placed (0 if threads are not pinned)
+	int numNodes;				// number of NUMA nodes used by threads
+	int* threadCpus;			// CPU each thread is pinned to
+	int* threadNodes;			// NUMA node of each thread
+};
+
+extern struct THREAD_PLACEMENT threadPlacement;
+
+
+
+/***********************************************************************************
+ *	parseThreadPlacement
+ *	- parses thread placement mode (NONE or NUMA) into threadPlacement
+ *	- returns 0 if all OK, and -1 otherwise.
+ ***********************************************************************************/
+int parseThreadPlacement(const char* mode);
 
-//#define RECORD_METHOD_TIMES
 
 
+/***********************************************************************************
+ *	initThreadPlacement
+ *	- in NUMA mode, pins all OpenMP threads to CPUs (unless the OpenMP runtime
+ *		already binds threads, through OMP_PROC_BIND) and fixes locus ownership
+ *		(STATIC locus scheduling, with all threads in parallel moves)
+ *	- called before loci memory is allocated
+ *	- returns number of NUMA nodes used by threads (0 if threads were not pinned)
+ ***********************************************************************************/
+int initThreadPlacement();
 
 
 
+/***********************************************************************************
+ *	getLocusArenaAlignment
+ *	- returns alignment (and size granularity) of locus arenas: a cache line, or
+ *		a page in NUMA mode
+ ***********************************************************************************/
+size_t getLocusArenaAlignment();
 
 
 
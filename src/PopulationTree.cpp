@@ -54,7 +54,8 @@ PopulationTree* createPopTree(int numCurPops)
 {
   int pop, migBand, numPops = 2*numCurPops-1;
 
-  PopulationTree* popTree = (PopulationTree*) malloc( sizeof(PopulationTree) );
+  // zeroed, since migBandsPerTarget is a vector (see initializeMigBandTimes)
+  PopulationTree* popTree = (PopulationTree*) calloc( 1, sizeof(PopulationTree) );
   if(popTree == nullptr)
   {
     fprintf(stderr, "\nError: Out Of Memory population tree.\n");
@@ -73,6 +74,12 @@ PopulationTree* createPopTree(int numCurPops)
     exit(-1);
   }
 	
+  popTree->popsPostOrder = (int*) malloc( numPops * sizeof(int) );
+  if(popTree->popsPostOrder == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory post-order queue in population tree.\n");
+    exit(-1);
+  }
+
   popTree->isAncestralArray = (unsigned short*) malloc( numPops * numPops * sizeof(unsigned short));
   if(popTree->isAncestralArray == nullptr) {
     fprintf(stderr, "\nError: Out Of Memory boolean 2D array for isAncestrals in population tree.\n");
@@ -161,6 +168,7 @@ int freePopTree(PopulationTree* popTree) {
   free(popTree->isAncestralArray);
   free(popTree->pops);
   free(popTree->popArray);
+  free(popTree->popsPostOrder);
   free(popTree);
 
   return 0;
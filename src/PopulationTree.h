@@ -110,7 +110,7 @@ typedef struct _POPULATION_TREE
     //contains MigBandsPerTarget structs.
     std::vector<MigBandsPerTarget> migBandsPerTarget;
 
-	int popsPostOrder[2 * NSPECIES - 1]; // post-order queue of populations
+	int*	popsPostOrder;		// post-order queue of populations (numPops)
 	//std::vector<int> popQueue; //version with vector
 
     std::map<int,int> leafToPop; //map between leaf to its pop //todo: initialize this
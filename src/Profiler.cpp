@@ -0,0 +1,264 @@
+/**
+   \file Profiler.cpp
+   Run-time profiling of MCMC moves.
+
+   Records wall time (monotonic clock, in nanoseconds), number of calls,
+   proposals and accepted proposals per MCMC move, and busy time of each
+   thread in parallel locus loops. Profile is optionally written as a stream
+   of JSON lines (one line per log interval) to a file next to the trace file.
+   Optionally, also records time and proposals per locus (locus profiling).
+*/
+#include "Profiler.h"
+#include "MultiCoreUtils.h"
+#include "utils.h"
+
+
+/* names of profiled methods (ordered as in METHOD_NAME) */
+static const char* methodNames[NUM_PROFILED_METHODS] = {
+	"coal-time", "mig-time", "spr", "tau", "mig-rate", "mixing", "theta",
+	"sample-age", "locus-rate", "sync-events", "checks", "comb-stats", "iteration"
+};
+
+/* methods whose time is spent in parallel locus loops (counted as busy or idle
+ * time of threads) */
+static const int methodInLocusLoops[NUM_PROFILED_METHODS] = {
+	1, 1, 1, 1, 0, 1, 0, 1, 1, 0, 0, 0, 0
+};
+
+
+static struct {
+	FILE* file;											// profile file (nullptr if none)
+	int numThreads;										// number of thread profiles
+	long long startTime;								// time profiler was initialized (ns)
+	long long lastWriteTime;							// time of last write to profile file (ns)
+	METHOD_PROFILE methods[NUM_PROFILED_METHODS];		// method profiles
+	METHOD_PROFILE lastMethods[NUM_PROFILED_METHODS];	// method profiles at last write
+	THREAD_PROFILE* threads;							// thread profiles
+	long long* lastBusyTimes;							// busy times of threads at last write
+} profiler = {nullptr, 0, 0, 0, {}, {}, nullptr, nullptr};
+
+LOCUS_PROFILE* locusProfiles = nullptr;
+
+
+
+/***********************************************************************************
+ *	initProfiler
+ *	- resets all profiles and allocates thread profiles for given number of threads
+ *	- opens profile file with given name (nullptr for no profile file)
+ *	- returns 0 if all OK, and -1 if profile file could not be opened
+ ***********************************************************************************/
+int initProfiler(const char* fileName, int numThreads) {
+	int method;
+
+	profiler.numThreads = max2(numThreads, 1);
+	profiler.threads = (THREAD_PROFILE*)calloc(profiler.numThreads, sizeof(THREAD_PROFILE));
+	profiler.lastBusyTimes = (long long*)calloc(profiler.numThreads, sizeof(long long));
+	if(profiler.threads == nullptr || profiler.lastBusyTimes == nullptr) {
+		fprintf(stderr, "\nError: Out Of Memory while allocating thread profiles.\n");
+		exit(-1);
+	}
+
+	for(method=0; method<NUM_PROFILED_METHODS; method++) {
+		profiler.methods[method].start = 0;
+		profiler.methods[method].wallTime = 0;
+		profiler.methods[method].calls = 0;
+		profiler.methods[method].proposals = 0;
+		profiler.methods[method].accepted = 0;
+		profiler.lastMethods[method] = profiler.methods[method];
+	}
+	profiler.startTime = profiler.lastWriteTime = profilerNow();
+
+	profiler.file = nullptr;
+	if(fileName != nullptr) {
+		profiler.file = fopen(fileName, "w");
+		if(profiler.file == nullptr) {
+			fprintf(stderr, "Error: Could not open profile file %s.\n", fileName);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+/** end of initProfiler **/
+
+
+
+/***********************************************************************************
+ *	setStartTimeMethod / setEndTimeMethod
+ *	- start and stop wall clock of a given method (each pair counts as one call)
+ ***********************************************************************************/
+void setStartTimeMethod(enum METHOD_NAME method) {
+	profiler.methods[method].start = profilerNow();
+}
+
+void setEndTimeMethod(enum METHOD_NAME method) {
+	profiler.methods[method].wallTime += profilerNow() - profiler.methods[method].start;
+	profiler.methods[method].calls++;
+}
+/** end of setStartTimeMethod / setEndTimeMethod **/
+
+
+
+/***********************************************************************************
+ *	addMethodProposals
+ *	- records number of proposals and accepted proposals made by a given method
+ ***********************************************************************************/
+void addMethodProposals(enum METHOD_NAME method, long proposals, long accepted) {
+	profiler.methods[method].proposals += proposals;
+	profiler.methods[method].accepted += accepted;
+}
+/** end of addMethodProposals **/
+
+
+
+/***********************************************************************************
+ *	addThreadBusyTime
+ *	- adds time spent by calling thread on a locus in a parallel locus loop
+ ***********************************************************************************/
+void addThreadBusyTime(long long time) {
+	int thread = omp_get_thread_num();
+
+	if(profiler.threads != nullptr && thread < profiler.numThreads) {
+		profiler.threads[thread].busyTime += time;
+	}
+}
+/** end of addThreadBusyTime **/
+
+
+
+/***********************************************************************************
+ *	getMethodSeconds
+ *	- returns wall time accumulated by given method (in seconds)
+ ***********************************************************************************/
+double getMethodSeconds(enum METHOD_NAME method) {
+	return profiler.methods[method].wallTime * 1e-9;
+}
+/** end of getMethodSeconds **/
+
+
+
+/***********************************************************************************
+ *	writeProfile
+ *	- writes profile of last log interval (ending at given iteration) as a JSON
+ *		line to profile file (does nothing if there is no profile file)
+ ***********************************************************************************/
+void writeProfile(int iteration) {
+	int method, thread;
+	long long now, wallTime, busyTime, idleTime, loopTime = 0;
+	long proposals, accepted;
+
+	if(profiler.file == nullptr)
+		return;
+
+	now = profilerNow();
+	fprintf(profiler.file, "{\"iteration\":%d,\"elapsed_ns\":%lld,\"interval_ns\":%lld,\"moves\":[",
+	        iteration, now - profiler.startTime, now - profiler.lastWriteTime);
+
+	for(method=0; method<NUM_PROFILED_METHODS; method++) {
+		wallTime  = profiler.methods[method].wallTime  - profiler.lastMethods[method].wallTime;
+		proposals = profiler.methods[method].proposals - profiler.lastMethods[method].proposals;
+		accepted  = profiler.methods[method].accepted  - profiler.lastMethods[method].accepted;
+		if(methodInLocusLoops[method]) {
+			loopTime += wallTime;
+		}
+		fprintf(profiler.file, "%s{\"name\":\"%s\",\"calls\":%ld,\"wall_ns\":%lld,\"proposals\":%ld,\"accepted\":%ld,\"proposals_per_sec\":%.1f}",
+		        (method == 0) ? "" : ",", methodNames[method],
+		        profiler.methods[method].calls - profiler.lastMethods[method].calls,
+		        wallTime, proposals, accepted,
+		        (wallTime > 0) ? proposals * 1e9 / wallTime : 0.0);
+		profiler.lastMethods[method] = profiler.methods[method];
+	}
+
+	fprintf(profiler.file, "],\"threads\":[");
+	for(thread=0; thread<profiler.numThreads; thread++) {
+		busyTime = profiler.threads[thread].busyTime - profiler.lastBusyTimes[thread];
+		idleTime = max2(loopTime - busyTime, 0);
+		fprintf(profiler.file, "%s{\"thread\":%d,\"busy_ns\":%lld,\"idle_ns\":%lld}",
+		        (thread == 0) ? "" : ",", thread, busyTime, idleTime);
+		profiler.lastBusyTimes[thread] = profiler.threads[thread].busyTime;
+	}
+	fprintf(profiler.file, "]}\n");
+	fflush(profiler.file);
+
+	profiler.lastWriteTime = now;
+}
+/** end of writeProfile **/
+
+
+
+/***********************************************************************************
+ *	printMethodTimes
+ *	- prints summary of profile of the whole run to stdout
+ ***********************************************************************************/
+void printMethodTimes() {
+	int method, thread;
+	long long loopTime = 0;
+	double seconds;
+
+	printf("===== METHOD RUN TIME ======\n");
+	printf("%-12s %10s %12s %12s %12s %14s\n", "method", "calls", "time (sec)", "proposals", "accepted", "proposals/sec");
+	for(method=0; method<NUM_PROFILED_METHODS; method++) {
+		if(profiler.methods[method].calls == 0)
+			continue;
+		if(methodInLocusLoops[method]) {
+			loopTime += profiler.methods[method].wallTime;
+		}
+		seconds = getMethodSeconds((enum METHOD_NAME)method);
+		printf("%-12s %10ld %12.3f %12ld %12ld %14.1f\n", methodNames[method],
+		       profiler.methods[method].calls, seconds,
+		       profiler.methods[method].proposals, profiler.methods[method].accepted,
+		       (seconds > 0.0) ? profiler.methods[method].proposals / seconds : 0.0);
+	}
+
+	if(profiler.numThreads > 1) {
+		printf("===== THREAD BUSY TIME IN LOCUS LOOPS ======\n");
+		for(thread=0; thread<profiler.numThreads; thread++) {
+			printf("thread %3d: busy %10.3f sec, idle %10.3f sec\n", thread,
+			       profiler.threads[thread].busyTime * 1e-9,
+			       max2(loopTime - profiler.threads[thread].busyTime, 0) * 1e-9);
+		}
+	}
+}
+/** end of printMethodTimes **/
+
+
+
+/***********************************************************************************
+ *	initLocusProfiles / freeLocusProfiles
+ *	- turns locus profiling on (allocating zeroed profiles for given number of loci)
+ *		and off (freeing them)
+ *	- initLocusProfiles returns 0
+ ***********************************************************************************/
+int initLocusProfiles(int numLoci) {
+	locusProfiles = (LOCUS_PROFILE*)calloc(numLoci, sizeof(LOCUS_PROFILE));
+	if(locusProfiles == nullptr) {
+		fprintf(stderr, "\nError: Out Of Memory while allocating locus profiles.\n");
+		exit(-1);
+	}
+	return 0;
+}
+
+void freeLocusProfiles() {
+	free(locusProfiles);
+	locusProfiles = nullptr;
+}
+/** end of initLocusProfiles / freeLocusProfiles **/
+
+
+
+/***********************************************************************************
+ *	closeProfiler
+ *	- closes profile file and frees thread profiles
+ ***********************************************************************************/
+void closeProfiler() {
+	if(profiler.file != nullptr) {
+		fclose(profiler.file);
+		profiler.file = nullptr;
+	}
+	free(profiler.threads);
+	free(profiler.lastBusyTimes);
+	profiler.threads = nullptr;
+	profiler.lastBusyTimes = nullptr;
+	profiler.numThreads = 0;
+}
+/** end of closeProfiler **/
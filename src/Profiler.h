@@ -0,0 +1,214 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+/**
+   \file Profiler.h
+   Run-time profiling of MCMC moves.
+
+   Records wall time (monotonic clock, in nanoseconds), number of calls,
+   proposals and accepted proposals per MCMC move, and busy time of each
+   thread in parallel locus loops. Profile is optionally written as a stream
+   of JSON lines (one line per log interval) to a file next to the trace file.
+   Optionally, also records time and proposals per locus (locus profiling).
+*/
+
+#include <stdio.h>
+#include <chrono>
+
+
+/***************************************************************************************************************/
+/******                                              DATA TYPES                                           ******/
+/***************************************************************************************************************/
+
+
+
+/*********
+ * METHOD_NAME - profiled methods (MCMC moves and other per-iteration passes)
+ *********/
+enum METHOD_NAME
+{
+	T_UpdateGB_InternalNode,
+	T_UpdateGB_MigrationNode,
+	T_UpdateGB_MigSPR,
+	T_UpdateTau,
+	T_UpdateMigRates,
+	T_mixing,
+	T_UpdateTheta,
+	T_UpdateSampleAge,
+	T_UpdateLocusRate,
+	T_SyncEvents,
+	T_Checks,
+	T_CombStats,
+	T_MCMCIterations,
+	NUM_PROFILED_METHODS
+};
+
+
+
+/*********
+ * profile of a single method
+ *********/
+typedef struct {
+	long long start;				// start time of current call (ns)
+	long long wallTime;				// accumulated wall time (ns)
+	long calls;						// number of calls
+	long proposals;					// number of proposals made
+	long accepted;					// number of accepted proposals
+} METHOD_PROFILE;
+
+
+
+/*********
+ * profile of a single thread (padded to a cache line)
+ *********/
+typedef struct {
+	long long busyTime;				// time spent on loci in parallel locus loops (ns)
+	char pad[64 - sizeof(long long)];
+} THREAD_PROFILE;
+
+
+
+/*********
+ * profile of a single locus (padded to a cache line)
+ *	- kept only when locus profiling is on (see initLocusProfiles)
+ *	- cost counters of likelihood computations are kept in LocusData
+ *		(see getLocusDataCosts in LocusDataLikelihood.h)
+ *********/
+typedef struct {
+	long long time;					// time spent on locus in parallel locus loops (ns)
+	long long traceLineageTime;		// time spent in traceLineage (ns)
+	long proposals;					// number of genealogy proposals made for locus
+	long accepted;					// number of accepted genealogy proposals
+	char pad[64 - 2*sizeof(long long) - 2*sizeof(long)];
+} LOCUS_PROFILE;
+
+extern LOCUS_PROFILE* locusProfiles;	// per-locus profiles (nullptr if locus profiling is off)
+
+
+
+/***************************************************************************************************************/
+/******                               EXTERNAL FUNCTION DECLARATION                                       ******/
+/***************************************************************************************************************/
+
+
+
+/***********************************************************************************
+ *	profilerNow
+ *	- returns current time of monotonic clock in nanoseconds
+ ***********************************************************************************/
+static inline long long profilerNow() {
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+	           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+
+/***********************************************************************************
+ *	initProfiler
+ *	- resets all profiles and allocates thread profiles for given number of threads
+ *	- opens profile file with given name (nullptr for no profile file)
+ *	- returns 0 if all OK, and -1 if profile file could not be opened
+ ***********************************************************************************/
+int initProfiler(const char* fileName, int numThreads);
+
+
+
+/***********************************************************************************
+ *	setStartTimeMethod / setEndTimeMethod
+ *	- start and stop wall clock of a given method (each pair counts as one call)
+ ***********************************************************************************/
+void setStartTimeMethod(enum METHOD_NAME method);
+void setEndTimeMethod(enum METHOD_NAME method);
+
+
+
+/***********************************************************************************
+ *	addMethodProposals
+ *	- records number of proposals and accepted proposals made by a given method
+ ***********************************************************************************/
+void addMethodProposals(enum METHOD_NAME method, long proposals, long accepted);
+
+
+
+/***********************************************************************************
+ *	addThreadBusyTime
+ *	- adds time spent by calling thread on a locus in a parallel locus loop
+ ***********************************************************************************/
+void addThreadBusyTime(long long time);
+
+
+
+/***********************************************************************************
+ *	getMethodSeconds
+ *	- returns wall time accumulated by given method (in seconds)
+ ***********************************************************************************/
+double getMethodSeconds(enum METHOD_NAME method);
+
+
+
+/***********************************************************************************
+ *	writeProfile
+ *	- writes profile of last log interval (ending at given iteration) as a JSON
+ *		line to profile file (does nothing if there is no profile file)
+ ***********************************************************************************/
+void writeProfile(int iteration);
+
+
+
+/***********************************************************************************
+ *	printMethodTimes
+ *	- prints summary of profile of the whole run to stdout
+ ***********************************************************************************/
+void printMethodTimes();
+
+
+
+/***********************************************************************************
+ *	initLocusProfiles / freeLocusProfiles
+ *	- turns locus profiling on (allocating zeroed profiles for given number of loci)
+ *		and off (freeing them)
+ *	- initLocusProfiles returns 0
+ ***********************************************************************************/
+int initLocusProfiles(int numLoci);
+void freeLocusProfiles();
+
+
+
+/***********************************************************************************
+ *	addLocusProposals
+ *	- records number of proposals and accepted proposals made for a given locus
+ *	- does nothing if locus profiling is off
+ ***********************************************************************************/
+static inline void addLocusProposals(int locus, long proposals, long accepted) {
+	if(locusProfiles != nullptr) {
+		locusProfiles[locus].proposals += proposals;
+		locusProfiles[locus].accepted += accepted;
+	}
+}
+
+
+
+/***********************************************************************************
+ *	startLocusCostTimer / stopLocusCostTimer
+ *	- measure time spent in a given part of a locus computation and add it to *time
+ *	- no-ops (clock is not read) if locus profiling is off
+ ***********************************************************************************/
+static inline long long startLocusCostTimer() {
+	return (locusProfiles != nullptr) ? profilerNow() : 0;
+}
+
+static inline void stopLocusCostTimer(long long* time, long long startTime) {
+	if(locusProfiles != nullptr)
+		*time += profilerNow() - startTime;
+}
+
+
+
+/***********************************************************************************
+ *	closeProfiler
+ *	- closes profile file and frees thread profiles
+ ***********************************************************************************/
+void closeProfiler();
+
+
+
+#endif
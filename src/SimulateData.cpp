@@ -0,0 +1,265 @@
+/**
+    \file SimulateData.cpp
+    Synthetic data generator.
+
+    Simulates genealogies under the population tree, samples and migration
+    bands of a given control file (see GetRandomMigGtree), evolves sequences
+    along them under the Jukes-Cantor model, and writes the alignments as a
+    G-PhoCS sequence file of arbitrary size (loci x samples x length).
+    Diploid samples are written with IUPAC ambiguity codes for heterozygous
+    sites.
+
+    Model parameters are initialized as in the MCMC (theta and tau priors,
+    tau-initial settings and mig-rate priors) and printed to stdout, so the
+    generated file can be analyzed with the same control file.
+
+    Built from all G-PhoCS sources other than readTrace.cpp and
+    AlignmentMain.cpp, with GPhoCS.cpp compiled with -DGPHOCS_NO_MAIN.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+
+#include "GPhoCS.h"
+#include "MCMCcontrol.h"
+#include "GenericTree.h"
+#include "patch.h"
+#include "utils.h"
+#include "MultiCoreUtils.h"
+
+
+static struct option long_options[] = {
+  {"loci",      required_argument, 0, 'l'},
+  {"length",    required_argument, 0, 'L'},
+  {"seed",      required_argument, 0, 's'},
+  {"help",      no_argument,       0, 'h'},
+  {0, 0, 0, 0}
+};
+
+
+static const char bases[] = "TCAG";
+
+/* IUPAC code of an unordered pair of bases (indices into bases[]) */
+static const char iupacCodes[4][4] = {
+  {'T', 'Y', 'W', 'K'},
+  {'Y', 'C', 'M', 'S'},
+  {'W', 'M', 'A', 'R'},
+  {'K', 'S', 'R', 'G'}
+};
+
+
+static void printSimulateDataUsage(char *programName) {
+  printf("Usage: %s <control-file-name> <output-seq-file> [options]\n", programName);
+  printf("Population tree, samples, parameter priors and migration bands are taken from control file.\n");
+  printf("-l, --loci      NUMBER    Number of loci (default num-loci in control file, or 100)\n");
+  printf("-L, --length    NUMBER    Length of each locus (default 1000)\n");
+  printf("-s, --seed      NUMBER    Random seed (default random-seed in control file, or time)\n");
+  printf("-h, --help                This help page\n");
+}
+
+
+
+/***********************************************************************************
+ *	evolveSequences
+ *	- evolves sequences of given length along genealogy under JC model, starting
+ *		from a uniformly random root sequence (using given random generator slot)
+ *	- seqs is an array of 2*numSamples-1 sequences (indexed by node ids, fathers
+ *		have higher ids than their sons), with base indices into bases[]
+ ***********************************************************************************/
+static void evolveSequences(GenericBinaryTree *tree, int rndSlot, int seqLength, char **seqs) {
+  int node, site;
+  double branchLength, pChange;
+
+  for (site = 0; site < seqLength; site++) {
+    seqs[tree->rootId][site] = (char) (4 * rndu(rndSlot));
+  }
+
+  for (node = tree->rootId - 1; node >= 0; node--) {
+    branchLength = tree->label1[tree->father[node]] - tree->label1[node];
+    pChange = 0.75 * (1.0 - exp(-4.0 * branchLength / 3.0));
+    for (site = 0; site < seqLength; site++) {
+      seqs[node][site] = seqs[tree->father[node]][site];
+      if (rndu(rndSlot) < pChange) {
+        seqs[node][site] = (char) ((seqs[node][site] + 1 + (int) (3 * rndu(rndSlot))) % 4);
+      }
+    }
+  }
+}
+/** end of evolveSequences **/
+
+
+
+/***********************************************************************************
+ *	writeLocus
+ *	- writes alignment of a single locus to sequence file
+ *	- a sample followed by an unnamed sample is diploid, and the two haploid
+ *		sequences are merged using IUPAC codes
+ ***********************************************************************************/
+static void writeLocus(FILE *seqFile, int gen, int seqLength, char **seqs, char *line) {
+  int sample, site, numWritten = 0;
+
+  for (sample = 0; sample < dataSetup.numSamples; sample++) {
+    if (dataSetup.sampleNames[sample][0] != '\0')
+      numWritten++;
+  }
+  fprintf(seqFile, "locus%d %d %d\n", gen + 1, numWritten, seqLength);
+
+  for (sample = 0; sample < dataSetup.numSamples; sample++) {
+    if (dataSetup.sampleNames[sample][0] == '\0')
+      continue;
+    if (sample + 1 < dataSetup.numSamples && dataSetup.sampleNames[sample + 1][0] == '\0') {
+      for (site = 0; site < seqLength; site++) {
+        line[site] = iupacCodes[(int) seqs[sample][site]][(int) seqs[sample + 1][site]];
+      }
+    } else {
+      for (site = 0; site < seqLength; site++) {
+        line[site] = bases[(int) seqs[sample][site]];
+      }
+    }
+    line[seqLength] = '\0';
+    fprintf(seqFile, "%s %s\n", dataSetup.sampleNames[sample], line);
+  }
+  fprintf(seqFile, "\n");
+}
+/** end of writeLocus **/
+
+
+
+/***********************************************************************************
+ *	printModelParameters
+ *	- prints parameters used for simulation
+ ***********************************************************************************/
+static void printModelParameters() {
+  int pop, migBand;
+  PopulationTree *popTree = dataSetup.popTree;
+
+  printf("Simulation parameters:\n");
+  for (pop = 0; pop < popTree->numPops; pop++) {
+    printf("  pop %-12s theta %.6g", popTree->pops[pop]->name, popTree->pops[pop]->theta);
+    if (pop >= popTree->numCurPops) {
+      printf(", tau %.6g", popTree->pops[pop]->age);
+    } else if (popTree->pops[pop]->sampleAge > 0.0) {
+      printf(", sample age %.6g", popTree->pops[pop]->sampleAge);
+    }
+    printf("\n");
+  }
+  for (migBand = 0; migBand < popTree->numMigBands; migBand++) {
+    printf("  mig band %s->%s rate %.6g\n",
+           popTree->pops[popTree->migBands[migBand].sourcePop]->name,
+           popTree->pops[popTree->migBands[migBand].targetPop]->name,
+           popTree->migBands[migBand].migRate);
+  }
+}
+/** end of printModelParameters **/
+
+
+
+int main(int argc, char *argv[]) {
+  int c, option_index, res, gen, node, numMigs;
+  int numLoci = -1, seqLength = 1000, seed = -1;
+  long long totalMigs = 0;
+  FILE *seqFile;
+  GenericBinaryTree *tree;
+  char **seqs, *line;
+
+  while (1) {
+    option_index = 0;
+    c = getopt_long(argc, argv, "l:L:s:h", long_options, &option_index);
+    if (c == -1)
+      break;
+
+    switch (c) {
+      case 'l':
+        numLoci = atoi(optarg);
+        break;
+      case 'L':
+        seqLength = atoi(optarg);
+        break;
+      case 's':
+        seed = atoi(optarg);
+        break;
+      case 'h':
+        printSimulateDataUsage(argv[0]);
+        exit(0);
+      case '?':
+      default:
+        printSimulateDataUsage(argv[0]);
+        exit(-1);
+    }
+  }
+
+  if (argc < optind + 2 || seqLength <= 0) {
+    printSimulateDataUsage(argv[0]);
+    exit(-1);
+  }
+
+  initGeneralInfo();
+  if (0 != readControlFile(argv[optind])) {
+    exit(-1);
+  }
+  popPostOrder(dataSetup.popTree, dataSetup.popTree->rootPop,
+               dataSetup.popTree->popsPostOrder);
+  res = checkSettings();
+  finalizeNumParameters();
+  if (res > 0) {
+    fprintf(stderr, "Found %d errors when processing control settings.\n", res);
+    exit(-1);
+  }
+
+  if (numLoci <= 0) {
+    numLoci = (dataSetup.numLoci > 0) ? dataSetup.numLoci : 100;
+  }
+  if (seed < 0) {
+    seed = (mcmcSetup.randomSeed >= 0) ? mcmcSetup.randomSeed : abs(2 * (int) time(nullptr) + 1);
+  }
+  // all locus slots of the random generator start from the same state, so
+  // loci are simulated one after the other from a single slot (slot 0)
+  initRandomGenerator(1, seed);
+
+  samplePopParameters(dataSetup.popTree);
+  sampleMigRates(dataSetup.popTree);
+  printModelParameters();
+
+  seqFile = fopen(argv[optind + 1], "w");
+  if (seqFile == nullptr) {
+    fprintf(stderr, "Error: Could not open sequence file %s for writing.\n", argv[optind + 1]);
+    exit(-1);
+  }
+
+  tree = createGenericTree(dataSetup.numSamples);
+  seqs = (char **) malloc((2 * dataSetup.numSamples - 1) * sizeof(char *));
+  line = (char *) malloc((seqLength + 1) * sizeof(char));
+  if (tree == nullptr || seqs == nullptr || line == nullptr) {
+    fprintf(stderr, "Error: Out Of Memory when allocating simulation structures.\n");
+    exit(-1);
+  }
+  seqs[0] = (char *) malloc((size_t) (2 * dataSetup.numSamples - 1) * seqLength * sizeof(char));
+  if (seqs[0] == nullptr) {
+    fprintf(stderr, "Error: Out Of Memory when allocating sequences.\n");
+    exit(-1);
+  }
+  for (node = 1; node < 2 * dataSetup.numSamples - 1; node++) {
+    seqs[node] = seqs[node - 1] + seqLength;
+  }
+
+  printf("Simulating %d loci of length %d for %d samples (seed %d) into %s...\n",
+         numLoci, seqLength, dataSetup.numSamples, seed, argv[optind + 1]);
+  fprintf(seqFile, "%d\n\n", numLoci);
+  for (gen = 0; gen < numLoci; gen++) {
+    GetRandomMigGtree(tree, 0, &numMigs);
+    totalMigs += numMigs;
+    evolveSequences(tree, 0, seqLength, seqs);
+    writeLocus(seqFile, gen, seqLength, seqs, line);
+  }
+  printf("Done (%.3f migrations per locus).\n", (double) totalMigs / numLoci);
+
+  fclose(seqFile);
+  freeGenericTree(tree);
+  free(seqs[0]);
+  free(seqs);
+  free(line);
+  return 0;
+}
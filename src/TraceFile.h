@@ -0,0 +1,390 @@
+#ifndef TRACE_FILE_H
+#define TRACE_FILE_H
+/**
+   \file TraceFile.h
+   Binary trace file format, and reader of text and binary trace files.
+
+   A binary (columnar) trace file is a self-describing header followed by
+   blocks of records:
+     header: "GPhTrace" (8 bytes), int32 version, int32 byte-order mark
+             (0x01020304), int32 number of columns, int32 flags, and for each
+             column an int32 column type followed by the (null-terminated)
+             column name
+     block:  int32 number of rows, followed by the values of each column for
+             all rows of the block (int32 for iteration and count columns,
+             double for all other columns)
+   Integers and doubles are written in native byte order (verified by the
+   byte-order mark when reading).
+
+   Columns are exported to text with the formats of text traces written by
+   G-PhoCS (see formatTraceValue), so a converted binary trace is identical
+   to the text trace of the same run.
+
+   Header-only, so standalone tools (readTrace, compareTraces, convertTrace)
+   are each built from a single source file.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+
+/***************************************************************************************************************/
+/******                                              DATA TYPES                                           ******/
+/***************************************************************************************************************/
+
+
+
+#define TRACE_BINARY_MAGIC "GPhTrace"
+#define TRACE_BINARY_MAGIC_LENGTH 8
+#define TRACE_BINARY_VERSION 1
+#define TRACE_BINARY_BYTE_ORDER 0x01020304
+
+/* flags of binary trace: lines of text trace end with a tab (before newline) */
+#define TRACE_FLAG_TRAILING_TAB 1
+
+
+
+/*********
+ * types of trace columns (determine binary encoding and text format)
+ *********/
+enum TRACE_COLUMN_TYPE
+{
+	TRACE_COLUMN_ITERATION,			// int32, "%d"
+	TRACE_COLUMN_PARAM,				// double, "%8.5f"
+	TRACE_COLUMN_LIKELIHOOD,		// double, "%.6f"
+	TRACE_COLUMN_STAT,				// double, "%0.35f"
+	TRACE_COLUMN_COUNT,				// int32, "%d"
+	NUM_TRACE_COLUMN_TYPES
+};
+
+
+
+/*********
+ * reader of a text or binary trace file
+ *********/
+typedef struct {
+	FILE* file;
+	int isBinary;
+	int numColumns;					// number of columns (first column is iteration)
+	char** names;					// column names
+	int* types;						// column types (binary traces only)
+	int flags;						// flags of binary trace
+	char* header;					// storage of column names
+	size_t headerCapacity;
+
+	// text traces
+	char* line;
+	size_t lineCapacity;
+	char** tokens;
+	int maxTokens;
+
+	// binary traces
+	double* block;					// values of current block (column-major)
+	int32_t* intValues;				// buffer for reading int32 columns
+	int blockCapacity;				// number of rows allocated for block
+	int blockRows;					// number of rows in current block
+	int nextRow;					// next row of current block to read
+} TRACE_READER;
+
+
+
+/***************************************************************************************************************/
+/******                                          INLINE FUNCTIONS                                         ******/
+/***************************************************************************************************************/
+
+
+
+/***********************************************************************************
+ *	isIntTraceColumn
+ *	- returns 1 if columns of given type are integers
+ ***********************************************************************************/
+static inline int isIntTraceColumn(int type) {
+	return (type == TRACE_COLUMN_ITERATION || type == TRACE_COLUMN_COUNT);
+}
+/** end of isIntTraceColumn **/
+
+
+
+/***********************************************************************************
+ *	formatTraceValue
+ *	- formats a value of a column of given type into buffer of given size
+ *	- returns number of characters written (as snprintf)
+ ***********************************************************************************/
+static inline int formatTraceValue(char* buffer, size_t size, int type, double value) {
+	switch(type) {
+		case TRACE_COLUMN_PARAM:
+			return snprintf(buffer, size, "%8.5f", value);
+		case TRACE_COLUMN_LIKELIHOOD:
+			return snprintf(buffer, size, "%.6f", value);
+		case TRACE_COLUMN_STAT:
+			return snprintf(buffer, size, "%0.35f", value);
+		default:
+			return snprintf(buffer, size, "%d", (int)value);
+	}
+}
+/** end of formatTraceValue **/
+
+
+
+/***********************************************************************************
+ *	writeBinaryTraceHeader
+ *	- writes header of binary trace with given columns
+ *	- returns 0 if all OK, and -1 on write error
+ ***********************************************************************************/
+static inline int writeBinaryTraceHeader(FILE* file, int numColumns, char** names, const int* types, int flags) {
+	int32_t header[4] = {TRACE_BINARY_VERSION, TRACE_BINARY_BYTE_ORDER, numColumns, flags};
+	int32_t type;
+	int col;
+
+	if(fwrite(TRACE_BINARY_MAGIC, 1, TRACE_BINARY_MAGIC_LENGTH, file) != TRACE_BINARY_MAGIC_LENGTH ||
+	   fwrite(header, sizeof(int32_t), 4, file) != 4)
+		return -1;
+	for(col=0; col<numColumns; col++) {
+		type = types[col];
+		if(fwrite(&type, sizeof(int32_t), 1, file) != 1 ||
+		   fwrite(names[col], 1, strlen(names[col]) + 1, file) != strlen(names[col]) + 1)
+			return -1;
+	}
+	return 0;
+}
+/** end of writeBinaryTraceHeader **/
+
+
+
+/***********************************************************************************
+ *	writeBinaryTraceBlock
+ *	- writes a block of numRows rows to binary trace
+ *	- block holds values column-major, with rowStride entries per column
+ *	- intValues is a buffer of at least numRows entries
+ *	- returns 0 if all OK, and -1 on write error
+ ***********************************************************************************/
+static inline int writeBinaryTraceBlock(FILE* file, int numColumns, const int* types,
+                                        const double* block, int numRows, int rowStride, int32_t* intValues) {
+	int32_t rows = numRows;
+	int col, row;
+
+	if(fwrite(&rows, sizeof(int32_t), 1, file) != 1)
+		return -1;
+	for(col=0; col<numColumns; col++) {
+		const double* values = block + (size_t)col * rowStride;
+		if(isIntTraceColumn(types[col])) {
+			for(row=0; row<numRows; row++)
+				intValues[row] = (int32_t)values[row];
+			if(fwrite(intValues, sizeof(int32_t), numRows, file) != (size_t)numRows)
+				return -1;
+		} else if(fwrite(values, sizeof(double), numRows, file) != (size_t)numRows) {
+			return -1;
+		}
+	}
+	return 0;
+}
+/** end of writeBinaryTraceBlock **/
+
+
+
+/***********************************************************************************
+ *	splitTraceLine
+ *	- splits line (in place) into tokens separated by any of given delimiters
+ *	- tokens array is reallocated as needed
+ *	- returns number of tokens
+ ***********************************************************************************/
+static inline int splitTraceLine(char* line, const char* delimiters, char*** tokens, int* maxTokens) {
+	int numTokens = 0;
+	char* token = strtok(line, delimiters);
+
+	while(token != nullptr) {
+		if(numTokens == *maxTokens) {
+			*maxTokens = 2 * (*maxTokens) + 16;
+			*tokens = (char**)realloc(*tokens, (*maxTokens) * sizeof(char*));
+			if(*tokens == nullptr) {
+				fprintf(stderr, "Error: Out Of Memory when reading trace line.\n");
+				exit(-1);
+			}
+		}
+		(*tokens)[numTokens++] = token;
+		token = strtok(nullptr, delimiters);
+	}
+	return numTokens;
+}
+/** end of splitTraceLine **/
+
+
+
+/***********************************************************************************
+ *	openTraceReader
+ *	- initializes reader of given (open) trace file, and reads its header
+ *	- binary traces are recognized by their magic, all other files are read as
+ *		text traces (first line holds column names, which are tab-separated if
+ *		line has tabs, since names of stats columns contain spaces)
+ *	- returns 0 if all OK, and -1 if header could not be read
+ ***********************************************************************************/
+static inline int openTraceReader(TRACE_READER* reader, FILE* file) {
+	char magic[TRACE_BINARY_MAGIC_LENGTH + 1];
+	int32_t header[4];
+	int32_t type;
+	size_t numRead, length, pos;
+	int col, c;
+
+	memset(reader, 0, sizeof(TRACE_READER));
+	reader->file = file;
+
+	numRead = fread(magic, 1, TRACE_BINARY_MAGIC_LENGTH, file);
+	reader->isBinary = (numRead == TRACE_BINARY_MAGIC_LENGTH &&
+	                    0 == memcmp(magic, TRACE_BINARY_MAGIC, TRACE_BINARY_MAGIC_LENGTH));
+
+	if(!reader->isBinary) {
+		// first line (including bytes already read) holds column names
+		magic[numRead] = '\0';
+		if(numRead == 0 || memchr(magic, '\n', numRead) != nullptr) {
+			fprintf(stderr, "Error: Unable to read column names of trace file.\n");
+			return -1;
+		}
+		if(getline(&reader->line, &reader->lineCapacity, file) < 0) {
+			reader->line = (char*)calloc(1, 1);
+		}
+		reader->headerCapacity = numRead + strlen(reader->line) + 1;
+		reader->header = (char*)malloc(reader->headerCapacity);
+		if(reader->header == nullptr) {
+			fprintf(stderr, "Error: Out Of Memory when reading trace header.\n");
+			exit(-1);
+		}
+		strcpy(reader->header, magic);
+		strcat(reader->header, reader->line);
+		reader->numColumns = splitTraceLine(reader->header, (strchr(reader->header, '\t') != nullptr) ? "\t\r\n" : " \t\r\n",
+		                                    &reader->names, &reader->maxTokens);
+		reader->maxTokens = 0;
+		if(reader->numColumns <= 0) {
+			fprintf(stderr, "Error: No columns in first line of trace file.\n");
+			return -1;
+		}
+		return 0;
+	}
+
+	if(fread(header, sizeof(int32_t), 4, file) != 4 || header[0] != TRACE_BINARY_VERSION ||
+	   header[1] != TRACE_BINARY_BYTE_ORDER || header[2] <= 0) {
+		fprintf(stderr, "Error: Unsupported version or byte order of binary trace file.\n");
+		return -1;
+	}
+	reader->numColumns = header[2];
+	reader->flags = header[3];
+	reader->names = (char**)malloc(reader->numColumns * sizeof(char*));
+	reader->types = (int*)malloc(reader->numColumns * sizeof(int));
+	if(reader->names == nullptr || reader->types == nullptr) {
+		fprintf(stderr, "Error: Out Of Memory when reading trace header.\n");
+		exit(-1);
+	}
+
+	// read all names into header storage, keeping offsets until storage is final
+	length = 0;
+	for(col=0; col<reader->numColumns; col++) {
+		if(fread(&type, sizeof(int32_t), 1, file) != 1 || type < 0 || type >= NUM_TRACE_COLUMN_TYPES) {
+			fprintf(stderr, "Error: Bad column type in header of binary trace file.\n");
+			return -1;
+		}
+		reader->types[col] = type;
+		reader->names[col] = (char*)length;
+		do {
+			c = fgetc(file);
+			if(c == EOF) {
+				fprintf(stderr, "Error: Unexpected end of header of binary trace file.\n");
+				return -1;
+			}
+			if(length == reader->headerCapacity) {
+				reader->headerCapacity = 2 * reader->headerCapacity + 256;
+				reader->header = (char*)realloc(reader->header, reader->headerCapacity);
+				if(reader->header == nullptr) {
+					fprintf(stderr, "Error: Out Of Memory when reading trace header.\n");
+					exit(-1);
+				}
+			}
+			reader->header[length++] = (char)c;
+		} while(c != '\0');
+	}
+	for(col=0; col<reader->numColumns; col++) {
+		pos = (size_t)reader->names[col];
+		reader->names[col] = reader->header + pos;
+	}
+	return 0;
+}
+/** end of openTraceReader **/
+
+
+
+/***********************************************************************************
+ *	readTraceRow
+ *	- reads next row of trace into values (room for numColumns values)
+ *	- returns number of values in row (at most numColumns are stored; empty text
+ *		lines have 0 values), and -1 at end of file (or on read error)
+ ***********************************************************************************/
+static inline int readTraceRow(TRACE_READER* reader, double* values) {
+	int32_t numRows;
+	int col, row, numTokens;
+
+	if(!reader->isBinary) {
+		if(getline(&reader->line, &reader->lineCapacity, reader->file) < 0)
+			return -1;
+		numTokens = splitTraceLine(reader->line, " \t\r\n", &reader->tokens, &reader->maxTokens);
+		for(col=0; col<numTokens && col<reader->numColumns; col++) {
+			values[col] = strtod(reader->tokens[col], nullptr);
+		}
+		return numTokens;
+	}
+
+	if(reader->nextRow == reader->blockRows) {
+		if(fread(&numRows, sizeof(int32_t), 1, reader->file) != 1 || numRows <= 0)
+			return -1;
+		if(numRows > reader->blockCapacity) {
+			reader->blockCapacity = numRows;
+			reader->block = (double*)realloc(reader->block, (size_t)numRows * reader->numColumns * sizeof(double));
+			reader->intValues = (int32_t*)realloc(reader->intValues, numRows * sizeof(int32_t));
+			if(reader->block == nullptr || reader->intValues == nullptr) {
+				fprintf(stderr, "Error: Out Of Memory when reading binary trace block.\n");
+				exit(-1);
+			}
+		}
+		for(col=0; col<reader->numColumns; col++) {
+			double* colValues = reader->block + (size_t)col * reader->blockCapacity;
+			if(isIntTraceColumn(reader->types[col])) {
+				if(fread(reader->intValues, sizeof(int32_t), numRows, reader->file) != (size_t)numRows)
+					return -1;
+				for(row=0; row<numRows; row++)
+					colValues[row] = reader->intValues[row];
+			} else if(fread(colValues, sizeof(double), numRows, reader->file) != (size_t)numRows) {
+				return -1;
+			}
+		}
+		reader->blockRows = numRows;
+		reader->nextRow = 0;
+	}
+
+	for(col=0; col<reader->numColumns; col++) {
+		values[col] = reader->block[(size_t)col * reader->blockCapacity + reader->nextRow];
+	}
+	reader->nextRow++;
+	return reader->numColumns;
+}
+/** end of readTraceRow **/
+
+
+
+/***********************************************************************************
+ *	closeTraceReader
+ *	- frees reader memory (file is not closed)
+ ***********************************************************************************/
+static inline void closeTraceReader(TRACE_READER* reader) {
+	free(reader->names);
+	free(reader->types);
+	free(reader->header);
+	free(reader->line);
+	free(reader->tokens);
+	free(reader->block);
+	free(reader->intValues);
+	memset(reader, 0, sizeof(TRACE_READER));
+}
+/** end of closeTraceReader **/
+
+
+
+#endif
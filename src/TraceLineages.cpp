@@ -47,6 +47,8 @@ void traceLineage_init(TraceLineageAutoVars* p_stack)
   int& pop                 = p_stack->pop;
   p_stack->age             = -1.0;
   p_stack->heredity_factor = 1.0;
+  p_stack->live_mig_bands  = locus_data[gen].scratch.trace_mig_bands;
+  p_stack->targets         = locus_data[gen].scratch.trace_targets;
 
   /******** initialization start  **************/
   p_stack->pop = nodePops[gen][node];
@@ -203,7 +205,7 @@ traceLineage_sample_migration_event_in_interval(TraceLineageAutoVars* p_stack)
   int& gen = p_stack->gen;
 
   // migration event - figure out where to migrate
-  if(MAX_MIGS <=
+  if(dataSetup.maxMigs <=
         genetree_migs[gen].num_migs
       + locus_data[gen].mig_spr_stats.num_new_migs
       - locus_data[gen].mig_spr_stats.num_old_migs)
@@ -19,10 +19,10 @@ typedef struct _TraceLineageAutoVars
   int pop;
   Event* pEvent;
   int node_id, mig_band, mig_source, proceed;
-  int num_live_mig_bands, live_mig_bands[MAX_MIG_BANDS];
+  int num_live_mig_bands, *live_mig_bands;
   double age, t;
   // these variables are needed only for reconnecting or delta_lnLd computation
-  int target, num_targets, targets[2*NS-1];
+  int target, num_targets, *targets;
   double  event_sample, rate, mig_rate, theta, heredity_factor;
 } TraceLineageAutoVars;
 //----------------------------------------------------------------------------
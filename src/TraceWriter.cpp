@@ -0,0 +1,430 @@
+/**
+   \file TraceWriter.cpp
+   Buffered (optionally asynchronous) writer of trace and statistics files.
+
+   Each output file is a stream of fixed-size binary records (iteration and
+   values), which the sampler fills in place. In asynchronous mode, records
+   are passed through a lock-free single-producer single-consumer ring to a
+   background writer thread, which formats them (with the same formats used
+   before) and writes them to file in large batches, flushing files every
+   few seconds and when the writer is closed. In synchronous mode, each
+   record is formatted, written and flushed when it is committed.
+
+   Files are written either as text (tab-separated) or in the binary
+   columnar format of TraceFile.h, with records buffered into blocks.
+*/
+#include "TraceWriter.h"
+#include "TraceFile.h"
+#include "Profiler.h"
+#include "utils.h"
+
+#include <atomic>
+#include <thread>
+#include <chrono>
+
+
+/* maximal number of trace streams */
+#define MAX_TRACE_STREAMS 8
+
+/* size of format buffer of each stream (written to file when full) */
+#define TRACE_BUFFER_SIZE (1 << 20)
+
+/* maximal length of a single formatted value ("%0.35f" of largest double) */
+#define TRACE_MAX_VALUE_LENGTH 400
+
+/* bounds on number of records in ring of each stream, and on ring size (bytes) */
+#define TRACE_MIN_RING_RECORDS 16
+#define TRACE_MAX_RING_RECORDS 1024
+#define TRACE_MAX_RING_BYTES (4 << 20)
+
+/* time writer thread sleeps when there are no records to write (microseconds) */
+#define TRACE_WRITER_IDLE_USECS 1000
+
+/* bounds on number of rows in blocks of binary traces, and on block size (bytes) */
+#define TRACE_MIN_BLOCK_ROWS 16
+#define TRACE_MAX_BLOCK_ROWS 1024
+#define TRACE_MAX_BLOCK_BYTES (1 << 20)
+
+
+
+/*********
+ * a trace stream
+ *	- head is advanced only by sampler (producer) and tail only by writer
+ *		thread (consumer); they are kept on separate cache lines
+ *	- in synchronous mode, the ring holds a single record
+ *********/
+typedef struct {
+	FILE* file;
+	enum TRACE_RECORD_FORMAT format;
+	int numSlots;						// number of records in ring
+	TRACE_RECORD* records;				// ring of records
+	double* values;						// storage of record values
+	int* counts;						// storage of record counts
+	int trailingTab;					// 1 if lines end with a tab (as header)
+	char* buffer;						// format buffer (text files)
+	long bufferLength;					// number of characters in format buffer
+	int numColumns;						// number of columns (binary files)
+	int* columnTypes;					// types of columns (binary files)
+	double* block;						// current block, column-major (binary files)
+	int32_t* intValues;					// buffer for writing int32 columns of block
+	int blockCapacity;					// number of rows in a block
+	int blockRows;						// number of rows in current block
+	alignas(64) std::atomic<long> head;	// number of records committed
+	alignas(64) std::atomic<long> tail;	// number of records written
+} TRACE_STREAM;
+
+
+static TRACE_STREAM traceStreams[MAX_TRACE_STREAMS];
+
+static struct {
+	int async;							// 1 if records are written by writer thread
+	int binary;							// 1 if files are written in binary format
+	long long flushInterval;			// time between flushes of files (ns)
+	std::atomic<int> numStreams;		// number of open streams
+	std::thread thread;					// writer thread
+	std::atomic<int> stop;				// set by closeTraceWriter to stop writer thread
+} traceWriter;
+
+
+
+/***********************************************************************************
+ *	writeStreamBuffer
+ *	- writes format buffer (or current block, for binary files) of stream to its file
+ ***********************************************************************************/
+static void writeStreamBuffer(TRACE_STREAM* stream) {
+	if(stream->bufferLength > 0) {
+		fwrite(stream->buffer, 1, stream->bufferLength, stream->file);
+		stream->bufferLength = 0;
+	}
+	if(stream->blockRows > 0) {
+		writeBinaryTraceBlock(stream->file, stream->numColumns, stream->columnTypes, stream->block,
+		                      stream->blockRows, stream->blockCapacity, stream->intValues);
+		stream->blockRows = 0;
+	}
+}
+/** end of writeStreamBuffer **/
+
+
+
+/***********************************************************************************
+ *	getColumnType / getColumnValue
+ *	- return type and value of a given column of a record (of stream format)
+ *		in a line with given number of columns (first column is iteration)
+ ***********************************************************************************/
+static int getColumnType(enum TRACE_RECORD_FORMAT format, int col, int numColumns) {
+	if(col == 0)
+		return TRACE_COLUMN_ITERATION;
+	if(format == TRACE_FORMAT_STAT_PAIRS)
+		return (col % 2) ? TRACE_COLUMN_STAT : TRACE_COLUMN_COUNT;
+	return (col >= numColumns - TRACE_NUM_LIKELIHOODS) ? TRACE_COLUMN_LIKELIHOOD : TRACE_COLUMN_PARAM;
+}
+
+static double getColumnValue(enum TRACE_RECORD_FORMAT format, const TRACE_RECORD* record, int col) {
+	if(col == 0)
+		return record->iteration;
+	if(format == TRACE_FORMAT_STAT_PAIRS)
+		return (col % 2) ? record->values[(col - 1) / 2] : record->counts[(col - 1) / 2];
+	return record->values[col - 1];
+}
+
+static int getNumColumns(enum TRACE_RECORD_FORMAT format, const TRACE_RECORD* record) {
+	return 1 + ((format == TRACE_FORMAT_STAT_PAIRS) ? 2 : 1) * record->numValues;
+}
+/** end of getColumnType / getColumnValue **/
+
+
+
+/***********************************************************************************
+ *	appendText
+ *	- formats a single value of a column of given type (followed by given separator)
+ *		into format buffer of stream (writing buffer to file first, if there may
+ *		not be room for value)
+ ***********************************************************************************/
+static void appendText(TRACE_STREAM* stream, int type, double value, const char* separator) {
+	if(stream->bufferLength > TRACE_BUFFER_SIZE - TRACE_MAX_VALUE_LENGTH)
+		writeStreamBuffer(stream);
+	stream->bufferLength += formatTraceValue(stream->buffer + stream->bufferLength,
+	                                         TRACE_BUFFER_SIZE - stream->bufferLength, type, value);
+	for(; *separator != '\0'; separator++)
+		stream->buffer[stream->bufferLength++] = *separator;
+}
+/** end of appendText **/
+
+
+
+/***********************************************************************************
+ *	formatRecord
+ *	- formats a record as a single text line into format buffer of stream, or
+ *		adds it as a row to current block (for binary files)
+ ***********************************************************************************/
+static void formatRecord(TRACE_STREAM* stream, const TRACE_RECORD* record) {
+	int col, numColumns = getNumColumns(stream->format, record);
+
+	if(!traceWriter.binary) {
+		for(col=0; col<numColumns; col++) {
+			appendText(stream, getColumnType(stream->format, col, numColumns),
+			           getColumnValue(stream->format, record, col),
+			           (col < numColumns - 1) ? "\t" : (stream->trailingTab ? "\t\n" : "\n"));
+		}
+		return;
+	}
+
+	if(numColumns != stream->numColumns) {
+		fprintf(stderr, "\nError: trace record with %d columns written to binary trace with %d columns.\n",
+		        numColumns, stream->numColumns);
+		exit(-1);
+	}
+	for(col=0; col<numColumns; col++) {
+		stream->block[(size_t)col * stream->blockCapacity + stream->blockRows] =
+		    getColumnValue(stream->format, record, col);
+	}
+	stream->blockRows++;
+	if(stream->blockRows == stream->blockCapacity)
+		writeStreamBuffer(stream);
+}
+/** end of formatRecord **/
+
+
+
+/***********************************************************************************
+ *	writePendingRecords
+ *	- formats all committed records of stream which were not yet written
+ *	- returns number of records formatted
+ ***********************************************************************************/
+static long writePendingRecords(TRACE_STREAM* stream) {
+	long head = stream->head.load(std::memory_order_acquire);
+	long tail = stream->tail.load(std::memory_order_relaxed);
+	long numRecords = head - tail;
+
+	for(; tail<head; tail++) {
+		formatRecord(stream, &stream->records[tail % stream->numSlots]);
+		stream->tail.store(tail + 1, std::memory_order_release);
+	}
+	return numRecords;
+}
+/** end of writePendingRecords **/
+
+
+
+/***********************************************************************************
+ *	writerThreadMain
+ *	- main loop of writer thread: writes pending records of all streams, and
+ *		flushes files every flushInterval, until stopped
+ ***********************************************************************************/
+static void writerThreadMain() {
+	long long lastFlushTime = profilerNow();
+	long numRecords;
+	int stream, numStreams, stopping;
+
+	do {
+		// read stop flag before records, so all records committed before stop are written
+		stopping = traceWriter.stop.load(std::memory_order_acquire);
+		numStreams = traceWriter.numStreams.load(std::memory_order_acquire);
+		numRecords = 0;
+		for(stream=0; stream<numStreams; stream++) {
+			numRecords += writePendingRecords(&traceStreams[stream]);
+		}
+
+		if(stopping || profilerNow() - lastFlushTime >= traceWriter.flushInterval) {
+			for(stream=0; stream<numStreams; stream++) {
+				writeStreamBuffer(&traceStreams[stream]);
+				fflush(traceStreams[stream].file);
+			}
+			lastFlushTime = profilerNow();
+		}
+
+		if(numRecords == 0 && !stopping)
+			std::this_thread::sleep_for(std::chrono::microseconds(TRACE_WRITER_IDLE_USECS));
+	} while(!stopping);
+}
+/** end of writerThreadMain **/
+
+
+
+/***********************************************************************************
+ *	initTraceWriter
+ *	- initializes trace writer in asynchronous mode (background writer thread) or
+ *		synchronous mode
+ *	- in asynchronous mode, files are flushed every flushSeconds seconds
+ *	- files are written in binary format (see TraceFile.h) if binary is 1
+ *	- registers closeTraceWriter to be called at exit
+ *	- returns 0
+ ***********************************************************************************/
+int initTraceWriter(int async, double flushSeconds, int binary) {
+	traceWriter.async = async;
+	traceWriter.binary = binary;
+	traceWriter.flushInterval = (long long)(flushSeconds * 1e9);
+	traceWriter.numStreams.store(0);
+	traceWriter.stop.store(0);
+	if(async)
+		traceWriter.thread = std::thread(writerThreadMain);
+	// pending records are also written when aborting with exit()
+	atexit(closeTraceWriter);
+	return 0;
+}
+/** end of initTraceWriter **/
+
+
+
+/***********************************************************************************
+ *	openTraceStream
+ *	- adds a stream of records of given format (with at most maxValues values)
+ *		written to given (open) file, and writes file header
+ *	- header is the header line of text file (tab-separated column names); in
+ *		binary files, it determines column names, and lines of text export end
+ *		with a tab if header does
+ *	- returns stream id (-1 if too many streams are open, or on write error)
+ ***********************************************************************************/
+int openTraceStream(FILE* file, enum TRACE_RECORD_FORMAT format, int maxValues, const char* header) {
+	int slot, col, numSlots = 1, headerLength = strlen(header);
+	char *headerCopy, **names;
+	TRACE_STREAM* stream;
+
+	if(traceWriter.numStreams.load() == MAX_TRACE_STREAMS) {
+		fprintf(stderr, "\nError: too many trace streams (maximum is %d).\n", MAX_TRACE_STREAMS);
+		return -1;
+	}
+	stream = &traceStreams[traceWriter.numStreams.load()];
+
+	maxValues = max2(maxValues, 1);
+	if(traceWriter.async) {
+		numSlots = TRACE_MAX_RING_BYTES / (maxValues * (sizeof(double) + sizeof(int)));
+		numSlots = max2(TRACE_MIN_RING_RECORDS, min2(TRACE_MAX_RING_RECORDS, numSlots));
+	}
+
+	stream->file = file;
+	stream->format = format;
+	stream->numSlots = numSlots;
+	stream->trailingTab = (headerLength >= 2 && 0 == strcmp(header + headerLength - 2, "\t\n"));
+	stream->numColumns = 0;
+	stream->columnTypes = nullptr;
+	stream->block = nullptr;
+	stream->intValues = nullptr;
+	stream->blockCapacity = 0;
+	stream->blockRows = 0;
+
+	if(!traceWriter.binary) {
+		fputs(header, file);
+	} else {
+		// column names are the tab-separated fields of header
+		headerCopy = strdup(header);
+		names = (char**)malloc((headerLength + 1) * sizeof(char*));
+		if(headerCopy == nullptr || names == nullptr) {
+			fprintf(stderr, "\nError: Out Of Memory while allocating trace stream.\n");
+			exit(-1);
+		}
+		for(names[0] = strtok(headerCopy, "\t\n"); names[stream->numColumns] != nullptr;
+		    names[stream->numColumns] = strtok(nullptr, "\t\n"))
+			stream->numColumns++;
+
+		stream->blockCapacity = TRACE_MAX_BLOCK_BYTES / (max2(stream->numColumns, 1) * sizeof(double));
+		stream->blockCapacity = max2(TRACE_MIN_BLOCK_ROWS, min2(TRACE_MAX_BLOCK_ROWS, stream->blockCapacity));
+		stream->columnTypes = (int*)malloc(max2(stream->numColumns, 1) * sizeof(int));
+		stream->block = (double*)malloc((size_t)stream->blockCapacity * max2(stream->numColumns, 1) * sizeof(double));
+		stream->intValues = (int32_t*)malloc(stream->blockCapacity * sizeof(int32_t));
+		if(stream->columnTypes == nullptr || stream->block == nullptr || stream->intValues == nullptr) {
+			fprintf(stderr, "\nError: Out Of Memory while allocating trace stream.\n");
+			exit(-1);
+		}
+		for(col=0; col<stream->numColumns; col++) {
+			stream->columnTypes[col] = getColumnType(format, col, stream->numColumns);
+		}
+		if(0 != writeBinaryTraceHeader(file, stream->numColumns, names, stream->columnTypes,
+		                               stream->trailingTab ? TRACE_FLAG_TRAILING_TAB : 0)) {
+			fprintf(stderr, "\nError: Could not write header of binary trace file.\n");
+			return -1;
+		}
+		free(names);
+		free(headerCopy);
+	}
+
+	stream->records = (TRACE_RECORD*)malloc(numSlots * sizeof(TRACE_RECORD));
+	stream->values = (double*)malloc((size_t)numSlots * maxValues * sizeof(double));
+	stream->counts = (int*)malloc((size_t)numSlots * maxValues * sizeof(int));
+	stream->buffer = (char*)malloc(TRACE_BUFFER_SIZE * sizeof(char));
+	if(stream->records == nullptr || stream->values == nullptr ||
+	   stream->counts == nullptr || stream->buffer == nullptr) {
+		fprintf(stderr, "\nError: Out Of Memory while allocating trace stream.\n");
+		exit(-1);
+	}
+	for(slot=0; slot<numSlots; slot++) {
+		stream->records[slot].numValues = 0;
+		stream->records[slot].maxValues = maxValues;
+		stream->records[slot].values = stream->values + (size_t)slot * maxValues;
+		stream->records[slot].counts = stream->counts + (size_t)slot * maxValues;
+	}
+	stream->bufferLength = 0;
+	stream->head.store(0);
+	stream->tail.store(0);
+
+	// publish stream to writer thread only after it is initialized
+	traceWriter.numStreams.store(traceWriter.numStreams.load() + 1, std::memory_order_release);
+
+	return traceWriter.numStreams.load() - 1;
+}
+/** end of openTraceStream **/
+
+
+
+/***********************************************************************************
+ *	beginTraceRecord / commitTraceRecord
+ *	- beginTraceRecord returns next (empty) record of stream for given iteration,
+ *		to be filled by caller and then committed by commitTraceRecord
+ *	- beginTraceRecord waits for writer thread if ring of stream is full
+ ***********************************************************************************/
+TRACE_RECORD* beginTraceRecord(int stream, int iteration) {
+	TRACE_STREAM* traceStream = &traceStreams[stream];
+	long head = traceStream->head.load(std::memory_order_relaxed);
+	TRACE_RECORD* record;
+
+	while(head - traceStream->tail.load(std::memory_order_acquire) >= traceStream->numSlots) {
+		std::this_thread::yield();
+	}
+	record = &traceStream->records[head % traceStream->numSlots];
+	record->iteration = iteration;
+	record->numValues = 0;
+	return record;
+}
+
+void commitTraceRecord(int stream) {
+	TRACE_STREAM* traceStream = &traceStreams[stream];
+	long head = traceStream->head.load(std::memory_order_relaxed);
+
+	if(traceWriter.async) {
+		traceStream->head.store(head + 1, std::memory_order_release);
+	} else {
+		formatRecord(traceStream, &traceStream->records[0]);
+		writeStreamBuffer(traceStream);
+		fflush(traceStream->file);
+	}
+}
+/** end of beginTraceRecord / commitTraceRecord **/
+
+
+
+/***********************************************************************************
+ *	closeTraceWriter
+ *	- writes all pending records, stops writer thread and flushes all files
+ *		(files are not closed)
+ ***********************************************************************************/
+void closeTraceWriter() {
+	int stream;
+
+	if(traceWriter.async && traceWriter.thread.joinable()) {
+		traceWriter.stop.store(1, std::memory_order_release);
+		traceWriter.thread.join();
+	}
+	for(stream=0; stream<traceWriter.numStreams.load(); stream++) {
+		writeStreamBuffer(&traceStreams[stream]);
+		fflush(traceStreams[stream].file);
+		free(traceStreams[stream].records);
+		free(traceStreams[stream].values);
+		free(traceStreams[stream].counts);
+		free(traceStreams[stream].buffer);
+		free(traceStreams[stream].columnTypes);
+		free(traceStreams[stream].block);
+		free(traceStreams[stream].intValues);
+	}
+	traceWriter.numStreams.store(0);
+}
+/** end of closeTraceWriter **/
@@ -0,0 +1,137 @@
+#ifndef TRACE_WRITER_H
+#define TRACE_WRITER_H
+/**
+   \file TraceWriter.h
+   Buffered (optionally asynchronous) writer of trace and statistics files.
+
+   Each output file is a stream of fixed-size binary records (iteration and
+   values), which the sampler fills in place. In asynchronous mode, records
+   are passed through a lock-free single-producer single-consumer ring to a
+   background writer thread, which formats them (with the same formats used
+   before) and writes them to file in large batches, flushing files every
+   few seconds and when the writer is closed. In synchronous mode, each
+   record is formatted, written and flushed when it is committed.
+
+   Files are written either as text (tab-separated) or in the binary
+   columnar format of TraceFile.h, with records buffered into blocks.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/***************************************************************************************************************/
+/******                                              DATA TYPES                                           ******/
+/***************************************************************************************************************/
+
+
+
+/*********
+ * formats of records in trace streams
+ *	- PARAMS:     iteration, parameter values ("%8.5f") and the last
+ *	              TRACE_NUM_LIKELIHOODS values as likelihoods ("%.6f")
+ *	              (format of MCMC trace file)
+ *	- STAT_PAIRS: iteration, and pairs of statistic ("%0.35f") and
+ *	              count ("%d") (format of comb, clade and hyp stats files)
+ *********/
+enum TRACE_RECORD_FORMAT
+{
+	TRACE_FORMAT_PARAMS,
+	TRACE_FORMAT_STAT_PAIRS
+};
+
+#define TRACE_NUM_LIKELIHOODS 3
+
+
+
+/*********
+ * a single record of a trace stream
+ *	- values and counts arrays have room for maxValues entries of stream
+ *	- counts are used only by STAT_PAIRS format
+ *********/
+typedef struct {
+	int iteration;
+	int numValues;
+	int maxValues;
+	double* values;
+	int* counts;
+} TRACE_RECORD;
+
+
+
+/***************************************************************************************************************/
+/******                               EXTERNAL FUNCTION DECLARATION                                       ******/
+/***************************************************************************************************************/
+
+
+
+/***********************************************************************************
+ *	initTraceWriter
+ *	- initializes trace writer in asynchronous mode (background writer thread) or
+ *		synchronous mode
+ *	- in asynchronous mode, files are flushed every flushSeconds seconds
+ *	- files are written in binary format (see TraceFile.h) if binary is 1
+ *	- registers closeTraceWriter to be called at exit
+ *	- returns 0
+ ***********************************************************************************/
+int initTraceWriter(int async, double flushSeconds, int binary);
+
+
+
+/***********************************************************************************
+ *	openTraceStream
+ *	- adds a stream of records of given format (with at most maxValues values)
+ *		written to given (open) file, and writes file header
+ *	- header is the header line of text file (tab-separated column names); in
+ *		binary files, it determines column names, and lines of text export end
+ *		with a tab if header does
+ *	- returns stream id (-1 if too many streams are open, or on write error)
+ ***********************************************************************************/
+int openTraceStream(FILE* file, enum TRACE_RECORD_FORMAT format, int maxValues, const char* header);
+
+
+
+/***********************************************************************************
+ *	beginTraceRecord / commitTraceRecord
+ *	- beginTraceRecord returns next (empty) record of stream for given iteration,
+ *		to be filled by caller and then committed by commitTraceRecord
+ *	- beginTraceRecord waits for writer thread if ring of stream is full
+ ***********************************************************************************/
+TRACE_RECORD* beginTraceRecord(int stream, int iteration);
+void commitTraceRecord(int stream);
+
+
+
+/***********************************************************************************
+ *	closeTraceWriter
+ *	- writes all pending records, stops writer thread and flushes all files
+ *		(files are not closed)
+ ***********************************************************************************/
+void closeTraceWriter();
+
+
+
+/***********************************************************************************
+ *	addTraceValue / addTraceStatPair
+ *	- append a value (or a statistic and its count) to a record
+ ***********************************************************************************/
+static inline void addTraceValue(TRACE_RECORD* record, double value) {
+	if(record->numValues >= record->maxValues) {
+		fprintf(stderr, "\nError: too many values (%d) in trace record.\n", record->numValues + 1);
+		exit(-1);
+	}
+	record->values[record->numValues++] = value;
+}
+
+static inline void addTraceStatPair(TRACE_RECORD* record, double stat, int count) {
+	if(record->numValues >= record->maxValues) {
+		fprintf(stderr, "\nError: too many values (%d) in trace record.\n", record->numValues + 1);
+		exit(-1);
+	}
+	record->counts[record->numValues] = count;
+	record->values[record->numValues++] = stat;
+}
+
+
+
+#endif
@@ -0,0 +1,405 @@
+/**
+    \file compareTraces.cpp
+    Comparison of two trace output files of G-PhoCS.
+
+    Streams both traces line by line (arbitrary line length, constant memory),
+    matching columns by name. Values are compared exactly, or within given
+    absolute/relative tolerance, and the first diverging iteration and column
+    are reported. For runs which are not expected to be identical, compares
+    summary statistics of each column (mean, standard deviation and effective
+    sample size), flagging columns whose means differ significantly.
+
+    Exit code is 0 if traces are identical (within tolerance), 1 if they differ
+    but all means are statistically equivalent, 2 if some mean differs (or
+    traces have different columns), and 3 on error.
+
+    Reads text traces and binary traces (see TraceFile.h), so a binary trace
+    can be compared with a text trace.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <getopt.h>
+#include "TraceFile.h"
+
+
+static struct option long_options[] =
+  {
+    {"abs-tolerance",  required_argument,  0, 'a'},
+    {"rel-tolerance",  required_argument,  0, 'r'},
+    {"discard",        required_argument,  0, 'd'},
+    {"rename",         required_argument,  0, 'n'},
+    {"z-threshold",    required_argument,  0, 'z'},
+    {"stats",          no_argument,        0, 'S'},
+    {"help",           no_argument,        0, 'h'},
+    {0, 0, 0, 0}
+  };
+
+void printHelp() {
+  printf("-a, --abs-tolerance  TOL   Values within absolute difference TOL are considered equal (default 0)\n");
+  printf("-r, --rel-tolerance  TOL   Values within relative difference TOL are considered equal (default 0)\n");
+  printf("-d, --discard  NUMBER      Number of samples to discard from beginning of traces for statistics\n");
+  printf("-n, --rename  OLD=NEW      Rename column OLD of second trace to NEW (may be repeated)\n");
+  printf("-z, --z-threshold  Z       Flag means which differ by more than Z standard errors (default 3)\n");
+  printf("-S, --stats                Print statistics even if traces are identical\n");
+  printf("-h, --help                 This help page\n");
+}
+
+void printUsage(char *filename) {
+  printf("Usage: %s <trace-file-A> <trace-file-B> [options]\n", filename);
+  printHelp();
+}
+
+
+/* maximal number of batch means kept for ESS estimation
+   (pairs of batches are merged when reached) */
+#define MAX_BATCHES 64
+
+/* max number of renamed columns */
+#define MAX_RENAMES 64
+
+
+/*********
+ * running statistics of a single column
+ *	- mean and variance are computed by Welford's method
+ *	- ESS is estimated by batch means, with batch size doubled whenever
+ *	  MAX_BATCHES batches are filled (so memory is constant)
+ *********/
+typedef struct {
+  long n;                           // number of values
+  double mean;                      // running mean
+  double m2;                        // running sum of squared deviations from mean
+  long batchSize;                   // current batch size
+  int numBatches;                   // number of full batches
+  double batchSum;                  // sum of values in current (partial) batch
+  long batchCount;                  // number of values in current (partial) batch
+  double batchMeans[MAX_BATCHES];   // means of full batches
+} RUNNING_STATS;
+
+
+/*********
+ * comparison state of a single column (present in both traces)
+ *********/
+typedef struct {
+  char* name;                       // column name
+  int colA;                         // index of column in trace A
+  int colB;                         // index of column in trace B
+  long numMismatches;               // number of values not equal (within tolerance)
+  double maxAbsDiff;                // max absolute difference of values
+  RUNNING_STATS statsA;             // statistics of column in trace A
+  RUNNING_STATS statsB;             // statistics of column in trace B
+} COLUMN_COMPARISON;
+
+
+
+/***********************************************************************************
+ *	addValue
+ *	- adds a value to running statistics
+ ***********************************************************************************/
+void addValue(RUNNING_STATS* stats, double value) {
+  double delta;
+  int batch;
+
+  stats->n++;
+  delta = value - stats->mean;
+  stats->mean += delta / stats->n;
+  stats->m2 += delta * (value - stats->mean);
+
+  stats->batchSum += value;
+  stats->batchCount++;
+  if(stats->batchCount == stats->batchSize) {
+    stats->batchMeans[stats->numBatches++] = stats->batchSum / stats->batchSize;
+    stats->batchSum = 0.0;
+    stats->batchCount = 0;
+    if(stats->numBatches == MAX_BATCHES) {
+      // merge pairs of batches
+      for(batch=0; batch<MAX_BATCHES/2; batch++) {
+        stats->batchMeans[batch] = 0.5 * (stats->batchMeans[2*batch] + stats->batchMeans[2*batch+1]);
+      }
+      stats->numBatches = MAX_BATCHES/2;
+      stats->batchSize *= 2;
+    }
+  }
+}
+/** end of addValue **/
+
+
+
+/***********************************************************************************
+ *	getVariance / getESS
+ *	- return sample variance and effective sample size (by batch means) of values
+ ***********************************************************************************/
+double getVariance(RUNNING_STATS* stats) {
+  return (stats->n > 1) ? stats->m2 / (stats->n - 1) : 0.0;
+}
+
+double getESS(RUNNING_STATS* stats) {
+  int batch;
+  double mean = 0.0, varBatchMeans = 0.0, ess;
+
+  if(stats->numBatches < 2 || getVariance(stats) <= 0.0)
+    return (double)stats->n;
+
+  for(batch=0; batch<stats->numBatches; batch++) {
+    mean += stats->batchMeans[batch];
+  }
+  mean /= stats->numBatches;
+  for(batch=0; batch<stats->numBatches; batch++) {
+    varBatchMeans += (stats->batchMeans[batch] - mean) * (stats->batchMeans[batch] - mean);
+  }
+  varBatchMeans /= (stats->numBatches - 1);
+  if(varBatchMeans <= 0.0)
+    return (double)stats->n;
+
+  ess = stats->n * getVariance(stats) / (stats->batchSize * varBatchMeans);
+  return (ess < stats->n) ? ess : (double)stats->n;
+}
+/** end of getVariance / getESS **/
+
+
+
+int main (int argc, char*argv[]) {
+  FILE *traceFileA = nullptr, *traceFileB = nullptr;
+  TRACE_READER readerA, readerB;
+  double *valuesA, *valuesB;
+  char **tokensA, **tokensB;
+  int numColsA, numColsB, numTokensA, numTokensB;
+  char *renameOld[MAX_RENAMES], *renameNew[MAX_RENAMES];
+  int numRenames = 0;
+  double absTolerance = 0.0, relTolerance = 0.0, zThreshold = 3.0;
+  int discard = 0, printStats = 0;
+  COLUMN_COMPARISON* columns;
+  int numColumns = 0, numOnlyInA = 0, numOnlyInB = 0, numSignificant = 0;
+  int col, colA, colB, i, firstColumn = -1, identical;
+  long numLines = 0, linesA = 0, linesB = 0, firstLine = -1;
+  char firstIteration[64] = "";
+  double valueA, valueB, diff, firstValueA = 0.0, firstValueB = 0.0, z, stdErr;
+  char *separator;
+
+  int option_index;
+  int c;
+
+  opterr = 0;
+
+  while (1)
+    {
+      option_index  = 0;
+      c = getopt_long(argc, argv, "a:r:d:n:z:Sh", long_options, &option_index);
+
+      if (c == -1)
+        break;
+
+      switch (c)
+        {
+        case 'a':
+          absTolerance = atof(optarg);
+          break;
+        case 'r':
+          relTolerance = atof(optarg);
+          break;
+        case 'd':
+          discard = atoi(optarg);
+          break;
+        case 'n':
+          separator = strchr(optarg, '=');
+          if(separator == nullptr || numRenames == MAX_RENAMES) {
+            fprintf(stderr, "Rename should be of the form OLD=NEW (at most %d renames).\n", MAX_RENAMES);
+            return 3;
+          }
+          *separator = '\0';
+          renameOld[numRenames] = optarg;
+          renameNew[numRenames++] = separator + 1;
+          break;
+        case 'z':
+          zThreshold = atof(optarg);
+          break;
+        case 'S':
+          printStats = 1;
+          break;
+        case 'h':
+          printUsage(argv[0]);
+          return 0;
+        case '?':
+          if (strchr("ardnz", optopt) != nullptr)
+            fprintf (stderr, "Option -%c requires an argument.\n", optopt);
+          else if (isprint (optopt))
+            fprintf (stderr, "Unknown option `-%c'.\n", optopt);
+          else
+            fprintf (stderr,
+                     "Unknown option character `\\x%x'.\n",
+                     optopt);
+          return 3;
+        default:
+          abort ();
+        }
+    }
+
+  if(argv[optind] == nullptr || argv[optind+1] == nullptr) {
+    fprintf(stderr, "Missing trace filenames.\n");
+    printUsage(argv[0]);
+    return 3;
+  }
+
+  traceFileA = fopen(argv[optind], "rb");
+  traceFileB = fopen(argv[optind+1], "rb");
+  if(traceFileA == nullptr || traceFileB == nullptr) {
+    fprintf(stderr, "Could not open trace file '%s'.\n", (traceFileA == nullptr) ? argv[optind] : argv[optind+1]);
+    return 3;
+  }
+
+  // read headers and match columns by name (first column is iteration)
+  if(0 != openTraceReader(&readerA, traceFileA) ||
+     0 != openTraceReader(&readerB, traceFileB)) {
+    fprintf(stderr, "Unable to read header of trace files.\n");
+    return 3;
+  }
+  numColsA = readerA.numColumns;
+  numColsB = readerB.numColumns;
+  tokensA = readerA.names;
+  tokensB = readerB.names;
+  for(colB=1; colB<numColsB; colB++) {
+    for(i=0; i<numRenames; i++) {
+      if(0 == strcmp(tokensB[colB], renameOld[i])) {
+        tokensB[colB] = renameNew[i];
+        break;
+      }
+    }
+  }
+
+  columns = (COLUMN_COMPARISON*)calloc(numColsA, sizeof(COLUMN_COMPARISON));
+  valuesA = (double*)malloc(numColsA * sizeof(double));
+  valuesB = (double*)malloc(numColsB * sizeof(double));
+  if(columns == nullptr || valuesA == nullptr || valuesB == nullptr) {
+    fprintf(stderr, "Error: Out Of Memory when allocating columns.\n");
+    return 3;
+  }
+
+  printf("Trace A: %s\n", argv[optind]);
+  printf("Trace B: %s\n", argv[optind+1]);
+  for(colA=1; colA<numColsA; colA++) {
+    for(colB=1; colB<numColsB; colB++) {
+      if(0 == strcmp(tokensA[colA], tokensB[colB]))
+        break;
+    }
+    if(colB == numColsB) {
+      printf("Column %s only in trace A.\n", tokensA[colA]);
+      numOnlyInA++;
+      continue;
+    }
+    columns[numColumns].name = tokensA[colA];
+    columns[numColumns].colA = colA;
+    columns[numColumns].colB = colB;
+    columns[numColumns].statsA.batchSize = 1;
+    columns[numColumns].statsB.batchSize = 1;
+    numColumns++;
+  }
+  for(colB=1; colB<numColsB; colB++) {
+    for(colA=1; colA<numColsA; colA++) {
+      if(0 == strcmp(tokensA[colA], tokensB[colB]))
+        break;
+    }
+    if(colA == numColsA) {
+      printf("Column %s only in trace B.\n", tokensB[colB]);
+      numOnlyInB++;
+    }
+  }
+
+  // stream both traces
+  while(1) {
+    if((numTokensA = readTraceRow(&readerA, valuesA)) >= 0) {
+      if(numTokensA > 0)
+        linesA++;
+    } else if((numTokensB = readTraceRow(&readerB, valuesB)) >= 0) {
+      // count remaining lines of B
+      if(numTokensB > 0)
+        linesB++;
+      continue;
+    } else {
+      break;
+    }
+    numTokensB = readTraceRow(&readerB, valuesB);
+    if(numTokensB > 0)
+      linesB++;
+    if(numTokensA <= 0 || numTokensB <= 0)
+      continue;
+    if(numTokensA != numColsA || numTokensB != numColsB) {
+      fprintf(stderr, "Unexpected number of columns at line %ld of traces.\n", numLines + 2);
+      return 3;
+    }
+
+    numLines++;
+    for(col=0; col<numColumns; col++) {
+      valueA = valuesA[columns[col].colA];
+      valueB = valuesB[columns[col].colB];
+      diff = fabs(valueA - valueB);
+      if(diff > columns[col].maxAbsDiff)
+        columns[col].maxAbsDiff = diff;
+      if(valueA != valueB && diff > absTolerance + relTolerance * fmax(fabs(valueA), fabs(valueB))) {
+        if(firstLine < 0) {
+          firstLine = numLines;
+          firstColumn = col;
+          firstValueA = valueA;
+          firstValueB = valueB;
+          snprintf(firstIteration, sizeof(firstIteration), "%.0f", valuesA[0]);
+        }
+        columns[col].numMismatches++;
+      }
+      if(numLines > discard) {
+        addValue(&columns[col].statsA, valueA);
+        addValue(&columns[col].statsB, valueB);
+      }
+    }
+  }
+  fclose(traceFileA);
+  fclose(traceFileB);
+
+  // report comparison
+  printf("%ld samples in trace A, %ld samples in trace B, %d columns compared.\n", linesA, linesB, numColumns);
+  identical = (firstLine < 0 && linesA == linesB && numOnlyInA == 0 && numOnlyInB == 0);
+  if(firstLine < 0) {
+    printf("All compared values are %s.\n", (absTolerance > 0.0 || relTolerance > 0.0) ? "equal within tolerance" : "identical");
+  } else {
+    printf("First divergence at sample %ld (iteration %s), column %s: %.17g vs %.17g.\n",
+           firstLine, firstIteration, columns[firstColumn].name, firstValueA, firstValueB);
+    printf("%-24s %12s %14s\n", "column", "mismatches", "max-abs-diff");
+    for(col=0; col<numColumns; col++) {
+      if(columns[col].numMismatches > 0) {
+        printf("%-24s %12ld %14.6g\n", columns[col].name, columns[col].numMismatches, columns[col].maxAbsDiff);
+      }
+    }
+  }
+
+  // compare statistics of runs that are not identical
+  if(!identical || printStats) {
+    printf("\nStatistics (discarding %d first samples):\n", discard);
+    printf("%-24s %14s %14s %12s %12s %10s %10s %8s\n", "column", "mean-A", "mean-B", "std-A", "std-B", "ESS-A", "ESS-B", "z");
+    for(col=0; col<numColumns; col++) {
+      RUNNING_STATS *statsA = &columns[col].statsA, *statsB = &columns[col].statsB;
+      if(statsA->n == 0)
+        continue;
+      stdErr = sqrt(getVariance(statsA) / getESS(statsA) + getVariance(statsB) / getESS(statsB));
+      z = (stdErr > 0.0) ? (statsA->mean - statsB->mean) / stdErr
+                         : ((statsA->mean == statsB->mean) ? 0.0 : INFINITY);
+      printf("%-24s %14.6g %14.6g %12.6g %12.6g %10.1f %10.1f %8.2f%s\n", columns[col].name,
+             statsA->mean, statsB->mean, sqrt(getVariance(statsA)), sqrt(getVariance(statsB)),
+             getESS(statsA), getESS(statsB), z, (fabs(z) > zThreshold) ? " *" : "");
+      if(fabs(z) > zThreshold)
+        numSignificant++;
+    }
+    printf("%d columns with means differing by more than %.2f standard errors.\n", numSignificant, zThreshold);
+  }
+
+  closeTraceReader(&readerA);
+  closeTraceReader(&readerB);
+  free(valuesA);
+  free(valuesB);
+  free(columns);
+
+  if(identical)
+    return 0;
+  if(numSignificant > 0 || numOnlyInA > 0 || numOnlyInB > 0)
+    return 2;
+  return 1;
+}
@@ -0,0 +1,88 @@
+/**
+    \file convertTrace.cpp
+    Conversion of binary trace files of G-PhoCS to text (tab-separated).
+
+    Reads a binary trace or stats file (written with trace-format BINARY, see
+    TraceFile.h) and writes it in the text format G-PhoCS writes with
+    trace-format TEXT, column names and value formats included.
+
+    Built like readTrace: g++ -O2 convertTrace.cpp -o convertTrace
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TraceFile.h"
+
+
+void printUsage(char *filename) {
+  printf("Usage: %s <binary-trace-file> [<output-text-file>]\n", filename);
+  printf("Converts a binary trace (or stats) file to text. Output is written to stdout if no output file is given.\n");
+}
+
+
+
+int main (int argc, char*argv[]) {
+  FILE *inFile, *outFile = stdout;
+  TRACE_READER reader;
+  double *values;
+  char valueStr[512];
+  const char *lineEnd;
+  int col;
+  long numRows = 0;
+
+  if(argc < 2 || argc > 3 || 0 == strcmp(argv[1], "-h") || 0 == strcmp(argv[1], "--help")) {
+    printUsage(argv[0]);
+    return (argc == 2) ? 0 : 1;
+  }
+
+  inFile = fopen(argv[1], "rb");
+  if(inFile == nullptr) {
+    fprintf(stderr, "Could not open trace file '%s'.\n", argv[1]);
+    return 1;
+  }
+  if(0 != openTraceReader(&reader, inFile)) {
+    return 1;
+  }
+  if(!reader.isBinary) {
+    fprintf(stderr, "Trace file '%s' is not a binary trace.\n", argv[1]);
+    return 1;
+  }
+  if(argc == 3) {
+    outFile = fopen(argv[2], "w");
+    if(outFile == nullptr) {
+      fprintf(stderr, "Could not open output file '%s'.\n", argv[2]);
+      return 1;
+    }
+  }
+
+  values = (double*)malloc(reader.numColumns * sizeof(double));
+  if(values == nullptr) {
+    fprintf(stderr, "Out of memory when allocating trace row.\n");
+    return 1;
+  }
+
+  lineEnd = (reader.flags & TRACE_FLAG_TRAILING_TAB) ? "\t\n" : "\n";
+  for(col=0; col<reader.numColumns; col++) {
+    fputs(reader.names[col], outFile);
+    fputs((col < reader.numColumns - 1) ? "\t" : lineEnd, outFile);
+  }
+
+  while(readTraceRow(&reader, values) >= 0) {
+    for(col=0; col<reader.numColumns; col++) {
+      formatTraceValue(valueStr, sizeof(valueStr), reader.types[col], values[col]);
+      fputs(valueStr, outFile);
+      fputs((col < reader.numColumns - 1) ? "\t" : lineEnd, outFile);
+    }
+    numRows++;
+  }
+
+  if(outFile != stdout) {
+    fclose(outFile);
+    fprintf(stderr, "Converted %ld samples to '%s'.\n", numRows, argv[2]);
+  }
+  fclose(inFile);
+  closeTraceReader(&reader);
+  free(values);
+  return 0;
+}
@@ -1,5 +1,8 @@
 #ifndef ENABLE_OMP_THREADS
 //_OPENMP
+#include "MultiCoreUtils.h"
+#include <chrono>
+
 extern "C"
 {
   void omp_set_dynamic(int n){}
@@ -7,6 +10,12 @@ extern "C"
   int omp_get_num_threads(){return 1;}
   int omp_get_thread_num(){return 0;}
   int omp_get_max_threads(){return 1;}
+  int omp_in_parallel(){return 0;}
+  void omp_set_schedule(omp_sched_t kind, int chunk_size) {}
+  double omp_get_wtime(){
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
 }
 #endif
 
@@ -16,9 +16,7 @@
 
 #include "patch.h"
 
-#ifdef ENABLE_OMP_THREADS
-#include <omp.h>
-#endif
+#include "MultiCoreUtils.h"
 
 #include "MemoryMng.h"
 #include "EventsDAG.h"
@@ -152,6 +150,171 @@ int Coalescence1Pop(PopulationTree *popTree, GenericBinaryTree *tree, int gen,
 /** end of Coalescence1Pop **/
 
 
+/***********************************************************************************
+ *	GetRandomMigGtree
+ * 	- generates genealogy according to model parameters, including migration
+ *		bands (structured coalescent, simulated backwards in time)
+ *	- lineages of ancient samples enter at sample age of their population, and
+ *		lineages move to father population at its age
+ *	- migration events are not recorded in tree, their number is returned in
+ *		*numMigs
+ *	- unlike GetRandomGtree, does not use locus structures (nodePops etc.), so
+ *		can be used without allocating MCMC memory
+ *	- returns 0
+ ***********************************************************************************/
+int GetRandomMigGtree(GenericBinaryTree *tree, int gen, int *numMigs) {
+  PopulationTree *popTree = dataSetup.popTree;
+  int numSamples = dataSetup.numSamples;
+  int numLineages = 0, numPending = numSamples, nextNode = numSamples;
+  int node, pop, migBand, lin, lin1, lin2, choice;
+  double T = 0.0, t, nextTime, coalRate, totalRate, rate;
+
+  // lineages (node id and current population of each), entered flags of
+  // samples, and number of lineages per population
+  int *lineageNodes = (int *) malloc((3 * numSamples + popTree->numPops) * sizeof(int));
+  int *lineagePops = lineageNodes + numSamples;
+  int *samplePops = lineagePops + numSamples;
+  int *popLineages = samplePops + numSamples;
+  char *entered = (char *) calloc(numSamples, sizeof(char));
+  if (lineageNodes == nullptr || entered == nullptr) {
+    fprintf(stderr, "\nError: Out Of Memory lineages at gen %d.\n", gen);
+    exit(-1);
+  }
+
+  // samples are ordered by population
+  for (node = 0, pop = 0; pop < popTree->numCurPops; pop++) {
+    for (lin = 0; lin < dataSetup.numSamplesPerPop[pop]; lin++, node++) {
+      samplePops[node] = pop;
+      tree->leftSon[node] = tree->rightSon[node] = tree->father[node] = -1;
+      tree->label1[node] = popTree->pops[pop]->sampleAge;
+    }
+  }
+
+  *numMigs = 0;
+  while (true) {
+    // enter samples and move lineages up to ancestral populations
+    for (node = 0; node < numSamples; node++) {
+      if (!entered[node] && popTree->pops[samplePops[node]]->sampleAge <= T) {
+        entered[node] = 1;
+        numPending--;
+        lineageNodes[numLineages] = node;
+        lineagePops[numLineages++] = samplePops[node];
+      }
+    }
+    for (lin = 0; lin < numLineages; lin++) {
+      while (popTree->pops[lineagePops[lin]]->father != nullptr &&
+             popTree->pops[lineagePops[lin]]->father->age <= T) {
+        lineagePops[lin] = popTree->pops[lineagePops[lin]]->father->id;
+      }
+    }
+    if (numPending == 0 && numLineages == 1)
+      break;
+
+    // next time at which rates change
+    nextTime = -1.0;
+    for (pop = 0; pop < popTree->numPops; pop++) {
+      t = (pop < popTree->numCurPops) ? popTree->pops[pop]->sampleAge
+                                      : popTree->pops[pop]->age;
+      if (t > T && (nextTime < 0 || t < nextTime))
+        nextTime = t;
+    }
+    for (migBand = 0; migBand < popTree->numMigBands; migBand++) {
+      t = popTree->migBands[migBand].startTime;
+      if (t > T && (nextTime < 0 || t < nextTime))
+        nextTime = t;
+      t = popTree->migBands[migBand].endTime;
+      if (t > T && (nextTime < 0 || t < nextTime))
+        nextTime = t;
+    }
+
+    // total rates of coalescences and migrations
+    for (pop = 0; pop < popTree->numPops; pop++)
+      popLineages[pop] = 0;
+    for (lin = 0; lin < numLineages; lin++)
+      popLineages[lineagePops[lin]]++;
+    coalRate = 0.0;
+    for (pop = 0; pop < popTree->numPops; pop++)
+      coalRate += popLineages[pop] * (popLineages[pop] - 1.) / popTree->pops[pop]->theta;
+    totalRate = coalRate;
+    for (migBand = 0; migBand < popTree->numMigBands; migBand++) {
+      if (popTree->migBands[migBand].startTime <= T && T < popTree->migBands[migBand].endTime)
+        totalRate += popLineages[popTree->migBands[migBand].targetPop] *
+                     popTree->migBands[migBand].migRate;
+    }
+
+    t = (totalRate > 0.0) ? rndexp(gen, 1. / totalRate) : -1.0;
+    if (t < 0.0 || (nextTime >= 0.0 && T + t >= nextTime)) {
+      T = nextTime;
+      continue;
+    }
+    T += t;
+
+    // choose event proportionally to its rate
+    // (rounding errors fall on last possible event)
+    rate = totalRate * rndu(gen);
+    if (rate < coalRate) {
+      for (pop = 0, choice = -1; pop < popTree->numPops; pop++) {
+        if (popLineages[pop] < 2)
+          continue;
+        choice = pop;
+        rate -= popLineages[pop] * (popLineages[pop] - 1.) / popTree->pops[pop]->theta;
+        if (rate < 0.0)
+          break;
+      }
+      pop = choice;
+    } else {
+      rate -= coalRate;
+      for (migBand = 0, choice = -1; migBand < popTree->numMigBands; migBand++) {
+        if (popTree->migBands[migBand].startTime > T || T >= popTree->migBands[migBand].endTime ||
+            popLineages[popTree->migBands[migBand].targetPop] == 0)
+          continue;
+        choice = migBand;
+        rate -= popLineages[popTree->migBands[migBand].targetPop] *
+                popTree->migBands[migBand].migRate;
+        if (rate < 0.0)
+          break;
+      }
+      migBand = choice;
+      pop = -1;
+    }
+
+    if (pop >= 0) {
+      // coalescence of two random lineages in pop
+      choice = (int) (popLineages[pop] * rndu(gen));
+      for (lin1 = 0; lineagePops[lin1] != pop || choice-- > 0; lin1++);
+      choice = (int) ((popLineages[pop] - 1) * rndu(gen));
+      for (lin2 = 0; lin2 == lin1 || lineagePops[lin2] != pop || choice-- > 0; lin2++);
+
+      tree->rightSon[nextNode] = lineageNodes[lin1];
+      tree->leftSon[nextNode] = lineageNodes[lin2];
+      tree->father[nextNode] = -1;
+      tree->label1[nextNode] = T;
+      tree->father[lineageNodes[lin1]] = nextNode;
+      tree->father[lineageNodes[lin2]] = nextNode;
+
+      lineageNodes[lin1] = nextNode++;
+      numLineages--;
+      lineageNodes[lin2] = lineageNodes[numLineages];
+      lineagePops[lin2] = lineagePops[numLineages];
+    } else {
+      // migration of a random lineage in target pop of band
+      pop = popTree->migBands[migBand].targetPop;
+      choice = (int) (popLineages[pop] * rndu(gen));
+      for (lin = 0; lineagePops[lin] != pop || choice-- > 0; lin++);
+      lineagePops[lin] = popTree->migBands[migBand].sourcePop;
+      (*numMigs)++;
+    }
+  }
+
+  tree->rootId = nextNode - 1;
+  free(lineageNodes);
+  free(entered);
+
+  return 0;
+}
+/** end of GetRandomMigGtree **/
+
+
 
 
 /******************************************************************************************************/
@@ -224,11 +387,8 @@ getLineagesAtInterval_UNUSED(int gen, int start_event, int pop, int exc_node,
   int i, id, node, event;
 
   int num_targets = event_chains[gen].events[start_event].getNumLineages();
-  int exc_nodes[2 * NS - 1];
+  int *exc_nodes = (int*)calloc(2 * dataSetup.numSamples - 1, sizeof(int));
 
-  for (i = 0; i < 2 * dataSetup.numSamples - 1; i++) {
-    exc_nodes[i] = 0;
-  }
   exc_nodes[exc_node] = 1;
 
   event = start_event;
@@ -314,6 +474,7 @@ getLineagesAtInterval_UNUSED(int gen, int start_event, int pop, int exc_node,
     printGenealogyAndExit(gen, -1);
   }
 
+  free(exc_nodes);
   return 0;
 
 }
@@ -405,7 +566,8 @@ double rubberBand(int gen, int pop, double static_point, double moving_point,
                   double factor, unsigned short postORpre,
                   int *out_num_events) {
 
-  int i, event, mig_band, node_id, living_mig_bands[MAX_MIG_BANDS], num_mig_bands;
+  int i, event, mig_band, node_id, num_mig_bands;
+  int *living_mig_bands = locus_data[gen].scratch.rubberband_mig_bands;
   int num_lins, count_events, flag;
   double age, delta_time, heredity_factor = 1;
   double mig_rate, mig_stats_delta, coal_stats_delta, lnLd_delta;
@@ -483,10 +645,7 @@ double rubberBand(int gen, int pop, double static_point, double moving_point,
         event_chains[gen].events[event].addElapsedTime(delta_time);
         for (mig_band = 0; mig_band < num_mig_bands; mig_band++) {
           genetree_stats[gen].mig_stats[living_mig_bands[mig_band]] += mig_stats_delta;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-          genetree_stats_total.mig_stats[living_mig_bands[mig_band]] += mig_stats_delta;
+          LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_MIG_STATS(living_mig_bands[mig_band])) += mig_stats_delta;
         }
       }
     }// end if(flag)
@@ -587,10 +746,7 @@ double rubberBand(int gen, int pop, double static_point, double moving_point,
   // after loop is done, consider coalescence stats
   if (postORpre) {
     genetree_stats[gen].coal_stats[pop] += coal_stats_delta;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    genetree_stats_total.coal_stats[pop] += coal_stats_delta / heredity_factor;
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_COAL_STATS(pop)) += coal_stats_delta / heredity_factor;
   }
 
 #ifdef DEBUG_RUBBERBAND
@@ -626,7 +782,7 @@ double rubberBandRipple(int gen, int do_or_redo)
   int pop;
   int new_event;
   int orig_event;
-  int affected_pops[2 * NSPECIES - 1];
+  int *affected_pops = locus_data[gen].scratch.ripple_pops;
   double delta_lnLd = 0.0;
 
   if( locus_data[gen].rubberband_migs.num_moved_events == 0 )
@@ -730,16 +886,16 @@ int replaceMigNodes(int gen, int node) {
 
     } else {
       // locate free mignode
-      for (mig = 0; mig < MAX_MIGS; mig++) {
+      for (mig = 0; mig < dataSetup.maxMigs; mig++) {
         if (genetree_migs[gen].mignodes[mig].migration_band < 0) break;
       }
-      if (mig == MAX_MIGS) {
+      if (mig == dataSetup.maxMigs) {
         if (debug) {
           fprintf(stderr,
                   "Error: replaceMigNodes: not enough free migs. Num old %d, num new %d, existing %d, max %d.\n",
                   locus_data[gen].mig_spr_stats.num_old_migs,
                   locus_data[gen].mig_spr_stats.num_new_migs,
-                  genetree_migs[gen].num_migs, MAX_MIGS);
+                  genetree_migs[gen].num_migs, dataSetup.maxMigs);
         } else {
           fprintf(stderr, "Fatal Error 0012.\n");
         }
@@ -947,10 +1103,7 @@ int acceptEventChainChanges(int gen, int instance) {
               locus_data[gen].genetree_stats_delta[instance].num_pops_changed; i++) {
     pop = locus_data[gen].genetree_stats_delta[instance].pops_changed[i];
     genetree_stats[gen].coal_stats[pop] += locus_data[gen].genetree_stats_delta[instance].coal_stats_delta[i];
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    genetree_stats_total.coal_stats[pop] +=
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_COAL_STATS(pop)) +=
         locus_data[gen].genetree_stats_delta[instance].coal_stats_delta[i] /
         heredity_factor;
   }
@@ -958,10 +1111,7 @@ int acceptEventChainChanges(int gen, int instance) {
               locus_data[gen].genetree_stats_delta[instance].num_mig_bands_changed; i++) {
     mig_band = locus_data[gen].genetree_stats_delta[instance].mig_bands_changed[i];
     genetree_stats[gen].mig_stats[mig_band] += locus_data[gen].genetree_stats_delta[instance].mig_stats_delta[i];
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-    genetree_stats_total.mig_stats[mig_band] += locus_data[gen].genetree_stats_delta[instance].mig_stats_delta[i];
+    LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_MIG_STATS(mig_band)) += locus_data[gen].genetree_stats_delta[instance].mig_stats_delta[i];
   }
 
   // change number of lineages in affected interval
@@ -1581,6 +1731,14 @@ int computeTotalStats() {
   double heredity_factor = 1;
   int pop, mig_band, gen;
 
+  // totals are recomputed from scratch, so discard pending per-locus changes
+  for (pop = 0; pop < dataSetup.popTree->numPops; pop++) {
+    reduceLocusPartialSums(LOCUS_SUM_COAL_STATS(pop), nullptr);
+  }
+  for (mig_band = 0; mig_band < dataSetup.popTree->numMigBands; mig_band++) {
+    reduceLocusPartialSums(LOCUS_SUM_MIG_STATS(mig_band), nullptr);
+  }
+
   //initialize values
   for (pop = 0; pop < dataSetup.popTree->numPops; pop++) {
     genetree_stats_total.coal_stats[pop] = 0;
@@ -1836,6 +1994,26 @@ int computeGenetreeStats(int gen) {
 //  return 0;
 //}
 
+/* reduceGenetreeStatsTotal
+   Adds per-locus changes in coal stats and mig stats, recorded as locus partial
+   sums by per-locus operations, to genetree_stats_total (in locus order).
+   Should be called after per-locus updates, before genetree_stats_total is used.
+*/
+
+void reduceGenetreeStatsTotal() {
+  int pop, mig_band;
+
+  for (pop = 0; pop < dataSetup.popTree->numPops; pop++) {
+    reduceLocusPartialSums(LOCUS_SUM_COAL_STATS(pop),
+                           &genetree_stats_total.coal_stats[pop]);
+  }
+  for (mig_band = 0; mig_band < dataSetup.popTree->numMigBands; mig_band++) {
+    reduceLocusPartialSums(LOCUS_SUM_MIG_STATS(mig_band),
+                           &genetree_stats_total.mig_stats[mig_band]);
+  }
+}
+/*** end of reduceGenetreeStatsTotal ***/
+
 /* recalcStats
    Re-calculates stats for given population in given gen.
    Writes down stats in genetree_stats_check and then compares to prior stats to return the log-likelihood.
@@ -1844,7 +2022,7 @@ int computeGenetreeStats(int gen) {
 
 double recalcStats(int gen, int pop) {
   int n, id, mig_band, event;
-  int live_mig_bands[MAX_MIG_BANDS];
+  int *live_mig_bands = locus_data[gen].scratch.recalc_mig_bands;
   int num_live_mig_bands = 0;
 
   double t, heredity_factor = 1;
@@ -1899,10 +2077,7 @@ double recalcStats(int gen, int pop) {
         delta_lnLd -= (locus_data[gen].genetree_stats_check.mig_stats[id] -
                        genetree_stats[gen].mig_stats[id]) *
                       dataSetup.popTree->migBands[id].migRate;
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-        genetree_stats_total.mig_stats[id] +=
+        LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_MIG_STATS(id)) +=
             locus_data[gen].genetree_stats_check.mig_stats[id] -
             genetree_stats[gen].mig_stats[id];
 #ifdef ENABLE_OMP_THREADS
@@ -1966,10 +2141,7 @@ double recalcStats(int gen, int pop) {
   delta_lnLd -= (locus_data[gen].genetree_stats_check.coal_stats[pop] -
                  genetree_stats[gen].coal_stats[pop]) /
                 (dataSetup.popTree->pops[pop]->theta * heredity_factor);
-#ifdef ENABLE_OMP_THREADS
-#pragma omp atomic
-#endif
-  genetree_stats_total.coal_stats[pop] +=
+  LOCUS_PARTIAL_SUM(gen, LOCUS_SUM_COAL_STATS(pop)) +=
       (locus_data[gen].genetree_stats_check.coal_stats[pop] -
        genetree_stats[gen].coal_stats[pop]) / heredity_factor;
 #ifdef ENABLE_OMP_THREADS
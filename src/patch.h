@@ -49,6 +49,7 @@ typedef struct _UpdateGB_InternalNode_ReturnData
  * A struct which contains information about
  * migration events in a specific genealogy.
  * Array of structs (of length numLoci is allocated in GetMem().
+ * mignode arrays are of length maxMigs (allocated in per-locus blocks).
  *---------------------------------------------------------------------------*/
 typedef struct _GENETREE_MIGS
 {
@@ -57,7 +58,7 @@ typedef struct _GENETREE_MIGS
 
   // array of indices for mignodes for
   // dynamic managing of migration nodes
-  int living_mignodes[MAX_MIGS];
+  int* living_mignodes;
 
   struct MIGNODE
   {
@@ -77,7 +78,7 @@ typedef struct _GENETREE_MIGS
 
     // time of event
     double age;
-  } mignodes[MAX_MIGS];
+  } *mignodes;
 
 } GENETREE_MIGS;
 
@@ -158,6 +159,7 @@ int removeEvent(         int                 gen,
 // auxiliary functions
 
 int GetRandomGtree(GenericBinaryTree* tree, int gen);
+int GetRandomMigGtree(GenericBinaryTree* tree, int gen, int* numMigs);
 int adjustRootEvents();
 
 int findInconsistency( int gen, int node );
@@ -204,6 +206,8 @@ double
 recalcStats (int gen, int pop);
 int
 computeGenetreeStats (int gen);
+void
+reduceGenetreeStatsTotal ();
 //int
 //recalcStats_partitioned (int gen, int pop);
 //int
@@ -1,6 +1,18 @@
-/** 
+/**
     \file readTrace.c
     Post-run analysis of trace output file
+
+    Trace is read in a single streaming pass, with lines of arbitrary length,
+    keeping only running statistics of the current block (Welford's method),
+    so memory does not depend on length of the trace.
+
+    With -S, all post-burn-in samples are kept (column-major) and a posterior
+    summary is printed for each column instead of block means: mean, standard
+    deviation, median, 95% HPD interval, ESS (from FFT-based autocorrelation)
+    and Geweke's convergence z-score. Columns are summarized in parallel when
+    compiled with OpenMP (g++ -fopenmp readTrace.cpp).
+
+    Reads text traces and binary traces (see TraceFile.h).
 */
 #include <stdio.h>
 #include <stdlib.h>
@@ -8,7 +20,12 @@
 #include <ctype.h>
 #include <unistd.h>
 #include <limits.h>
+#include <math.h>
 #include <getopt.h>
+#include "TraceFile.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 
 static struct option long_options[] =
@@ -18,6 +35,9 @@ static struct option long_options[] =
     {"block-size",     required_argument,       0, 'b'},
     {"discard",  required_argument,  0, 'd'},
     {"sub-sampling",  required_argument, 0, 's'},
+    {"std",  no_argument, 0, 'v'},
+    {"summary",  no_argument, 0, 'S'},
+    {"threads",  required_argument, 0, 't'},
     {"help",  no_argument, 0, 'h'},
     {0, 0, 0, 0}
   };
@@ -25,6 +45,10 @@ static struct option long_options[] =
 void printHelp() {
   printf("-b, --block-size  SIZE     Blocksize\n");
   printf("-d, --discard  NUMBER      Number of samples from to discard from beginning of file\n");
+  printf("-v, --std                  Print standard deviation of each block below its means\n");
+  printf("-S, --summary              Print posterior summary of each column (mean, std, median, 95%% HPD,\n");
+  printf("                           ESS and Geweke z-score) instead of block means. Keeps all samples in memory.\n");
+  printf("-t, --threads  NUMBER      Number of threads for summarizing columns (with -S)\n");
   printf("-h, --help                 This help page\n");
 //  printf("-s, --subsample  NUMBER    Subsampling, sample every x lines\n");
 //  printf("\nReport bugs to <GPhoCS-help-L@cornell.edu>\n");
@@ -35,55 +59,363 @@ void printUsage(char *filename) {
   printHelp();
 }
 
+
+/* number of columns printed in each line of output */
+#define COLUMNS_PER_LINE 90
+
+/* probability mass of HPD intervals */
+#define HPD_MASS 0.95
+
+/* fractions of samples in first and last windows of Geweke's diagnostic */
+#define GEWEKE_FIRST 0.1
+#define GEWEKE_LAST  0.5
+
+
+/*********
+ * running statistics of a column in current block (Welford's method)
+ *********/
+typedef struct {
+  char* name;             // column name
+  int width;              // print width of column (set when first block is printed)
+  long double mean;       // running mean of block
+  long double m2;         // running sum of squared deviations from mean of block
+} COLUMN_STATS;
+
+
+/*********
+ * posterior summary of a column (computed from all post-burn-in samples)
+ *********/
+typedef struct {
+  double mean;
+  double std;
+  double median;
+  double hpdLow;          // lower end of HPD_MASS HPD interval
+  double hpdHigh;         // upper end of HPD_MASS HPD interval
+  double ess;             // effective sample size
+  double geweke;          // Geweke z-score (first GEWEKE_FIRST vs last GEWEKE_LAST of samples)
+} COLUMN_SUMMARY;
+
+
+
+/***********************************************************************************
+ *	fft
+ *	- in-place iterative radix-2 FFT of complex array (re,im) of length n
+ *		(n must be a power of 2)
+ *	- computes inverse transform (without 1/n normalization) if inverse != 0
+ ***********************************************************************************/
+void fft(double* re, double* im, long n, int inverse) {
+  long i, j, k, len, half;
+  double angle, wRe, wIm, curRe, curIm, tRe, tIm, tmp;
+
+  // bit-reversal permutation
+  for(i=1, j=0; i<n; i++) {
+    long bit = n >> 1;
+    for(; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if(i < j) {
+      tmp = re[i]; re[i] = re[j]; re[j] = tmp;
+      tmp = im[i]; im[i] = im[j]; im[j] = tmp;
+    }
+  }
+
+  for(len=2; len<=n; len <<= 1) {
+    half = len >> 1;
+    angle = (inverse ? 2.0 : -2.0) * M_PI / len;
+    wRe = cos(angle);
+    wIm = sin(angle);
+    for(i=0; i<n; i+=len) {
+      curRe = 1.0;
+      curIm = 0.0;
+      for(k=0; k<half; k++) {
+        tRe = re[i+k+half] * curRe - im[i+k+half] * curIm;
+        tIm = re[i+k+half] * curIm + im[i+k+half] * curRe;
+        re[i+k+half] = re[i+k] - tRe;
+        im[i+k+half] = im[i+k] - tIm;
+        re[i+k] += tRe;
+        im[i+k] += tIm;
+        tmp = curRe * wRe - curIm * wIm;
+        curIm = curRe * wIm + curIm * wRe;
+        curRe = tmp;
+      }
+    }
+  }
+}
+/** end of fft **/
+
+
+
+/***********************************************************************************
+ *	computeEss
+ *	- returns effective sample size of n values, and sets their mean and variance
+ *	- autocorrelations are computed by FFT (zero-padded to avoid wrap-around) and
+ *		summed using Geyer's initial monotone sequence estimator
+ *	- re and im are work arrays of size at least fftSize (power of 2, >= 2n)
+ ***********************************************************************************/
+double computeEss(const double* values, long n, long fftSize, double* re, double* im,
+                  double* mean, double* variance) {
+  long i, lag;
+  double sum = 0.0, autoCov0, pairSum, prevPairSum, tau;
+
+  for(i=0; i<n; i++)
+    sum += values[i];
+  *mean = sum / n;
+
+  for(i=0; i<fftSize; i++) {
+    re[i] = (i < n) ? values[i] - *mean : 0.0;
+    im[i] = 0.0;
+  }
+  fft(re, im, fftSize, 0);
+  for(i=0; i<fftSize; i++) {
+    re[i] = re[i] * re[i] + im[i] * im[i];
+    im[i] = 0.0;
+  }
+  fft(re, im, fftSize, 1);
+
+  // re[lag] / fftSize is now n times the autocovariance at given lag
+  autoCov0 = re[0];
+  *variance = (n > 1) ? autoCov0 / fftSize / (n - 1) : 0.0;
+  if(n < 4 || autoCov0 <= 0.0)
+    return (double)n;
+
+  // tau = 1 + 2 sum_lag rho(lag) = -1 + 2 sum_k (rho(2k) + rho(2k+1)),
+  // truncated at first non-positive pair sum, with pair sums made monotone
+  tau = -1.0;
+  prevPairSum = 2.0;
+  for(lag=0; lag+1<n; lag+=2) {
+    pairSum = (re[lag] + re[lag+1]) / autoCov0;
+    if(pairSum <= 0.0)
+      break;
+    if(pairSum > prevPairSum)
+      pairSum = prevPairSum;
+    tau += 2.0 * pairSum;
+    prevPairSum = pairSum;
+  }
+  if(tau < 1.0 / log10((double)n))
+    tau = 1.0 / log10((double)n);
+  return n / tau;
+}
+/** end of computeEss **/
+
+
+
+/***********************************************************************************
+ *	compareDoubles
+ *	- comparison function for qsort
+ ***********************************************************************************/
+int compareDoubles(const void* a, const void* b) {
+  double x = *(const double*)a, y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+/** end of compareDoubles **/
+
+
+
+/***********************************************************************************
+ *	summarizeColumn
+ *	- computes posterior summary of n samples of a column
+ *	- work is an array of size at least n, re and im are arrays of size at
+ *		least fftSize (see computeEss)
+ ***********************************************************************************/
+void summarizeColumn(const double* values, long n, long fftSize,
+                     double* work, double* re, double* im, COLUMN_SUMMARY* summary) {
+  long i, hpdCount, firstCount, lastCount;
+  double variance, meanFirst, varFirst, essFirst, meanLast, varLast, essLast, stdErr;
+
+  summary->ess = computeEss(values, n, fftSize, re, im, &summary->mean, &variance);
+  summary->std = sqrt(variance);
+
+  // median and HPD interval (shortest interval containing HPD_MASS of sorted samples)
+  memcpy(work, values, n * sizeof(double));
+  qsort(work, n, sizeof(double), compareDoubles);
+  summary->median = (n % 2) ? work[n/2] : 0.5 * (work[n/2 - 1] + work[n/2]);
+  hpdCount = (long)ceil(HPD_MASS * n);
+  if(hpdCount < 1)
+    hpdCount = 1;
+  summary->hpdLow = work[0];
+  summary->hpdHigh = work[hpdCount-1];
+  for(i=1; i+hpdCount<=n; i++) {
+    if(work[i+hpdCount-1] - work[i] < summary->hpdHigh - summary->hpdLow) {
+      summary->hpdLow = work[i];
+      summary->hpdHigh = work[i+hpdCount-1];
+    }
+  }
+
+  // Geweke's z-score, with variance of window means corrected by their ESS
+  firstCount = (long)(GEWEKE_FIRST * n);
+  lastCount = (long)(GEWEKE_LAST * n);
+  summary->geweke = NAN;
+  if(firstCount >= 2 && lastCount >= 2) {
+    essFirst = computeEss(values, firstCount, fftSize, re, im, &meanFirst, &varFirst);
+    essLast = computeEss(values + n - lastCount, lastCount, fftSize, re, im, &meanLast, &varLast);
+    stdErr = sqrt(varFirst / essFirst + varLast / essLast);
+    if(stdErr > 0.0)
+      summary->geweke = (meanFirst - meanLast) / stdErr;
+  }
+}
+/** end of summarizeColumn **/
+
+
+
+/***********************************************************************************
+ *	printSummary
+ *	- summarizes all columns (in parallel) and prints a line for each column
+ ***********************************************************************************/
+void printSummary(COLUMN_STATS* columns, int numCols, double** samples, long n, int numThreads) {
+  COLUMN_SUMMARY* summaries;
+  long fftSize;
+  int col, nameWidth = 8;
+
+  summaries = (COLUMN_SUMMARY*)malloc(numCols * sizeof(COLUMN_SUMMARY));
+  if(summaries == nullptr) {
+    fprintf(stderr, "Out of memory when allocating column summaries.\n");
+    exit(-1);
+  }
+  for(fftSize=1; fftSize<2*n; fftSize <<= 1)
+    ;
+
+#pragma omp parallel num_threads(numThreads) if(numThreads > 1)
+  {
+    double* work = (double*)malloc(n * sizeof(double));
+    double* re = (double*)malloc(fftSize * sizeof(double));
+    double* im = (double*)malloc(fftSize * sizeof(double));
+    if(work == nullptr || re == nullptr || im == nullptr) {
+      fprintf(stderr, "Out of memory when allocating work space for column summaries.\n");
+      exit(-1);
+    }
+#pragma omp for schedule(dynamic)
+    for(col=0; col<numCols; col++) {
+      summarizeColumn(samples[col], n, fftSize, work, re, im, &summaries[col]);
+    }
+    free(work);
+    free(re);
+    free(im);
+  }
+
+  for(col=0; col<numCols; col++) {
+    if((int)strlen(columns[col].name) >= nameWidth)
+      nameWidth = strlen(columns[col].name) + 1;
+  }
+  printf("%-*s %14s %14s %14s %14s %14s %10s %8s\n", nameWidth, "column",
+         "mean", "std", "median", "HPD95-low", "HPD95-high", "ESS", "Geweke");
+  for(col=0; col<numCols; col++) {
+    printf("%-*s %14.6f %14.6f %14.6f %14.6f %14.6f %10.1f %8.3f\n", nameWidth, columns[col].name,
+           summaries[col].mean, summaries[col].std, summaries[col].median,
+           summaries[col].hpdLow, summaries[col].hpdHigh, summaries[col].ess, summaries[col].geweke);
+  }
+  printf("\n%ld samples summarized.\n", n);
+
+  free(summaries);
+}
+/** end of printSummary **/
+
+
+
+/***********************************************************************************
+ *	printBlock
+ *	- prints means (and optionally standard deviations) of a block of given size,
+ *		in lines of COLUMNS_PER_LINE columns, and resets block statistics
+ *	- column widths are set by first block (which is printed with column titles),
+ *		and are at least wide enough for column titles
+ ***********************************************************************************/
+void printBlock(COLUMN_STATS* columns, int numCols, long blockCount, int isFirstBlock, int printStd) {
+  char valueStr[64];
+  int col, start, end;
+
+  for(start=0; start<numCols; start=end) {
+    end = (start + COLUMNS_PER_LINE < numCols) ? start + COLUMNS_PER_LINE : numCols;
+    if(isFirstBlock) {
+      for(col=start; col<end; col++) {
+        sprintf(valueStr, "%.6Lf    ", columns[col].mean);
+        columns[col].width = strlen(valueStr);
+        if(columns[col].width <= (int)strlen(columns[col].name))
+          columns[col].width = strlen(columns[col].name) + 1;
+        printf("%-*s", columns[col].width, columns[col].name);
+      }
+      printf("\n");
+    }
+    for(col=start; col<end; col++) {
+      sprintf(valueStr, "%.6Lf    ", columns[col].mean);
+      printf("%-*s", columns[col].width, valueStr);
+    }
+    printf("\n");
+    if(printStd) {
+      for(col=start; col<end; col++) {
+        sprintf(valueStr, "%.6Lf    ", (blockCount > 1) ? sqrtl(columns[col].m2 / (blockCount - 1)) : 0.0L);
+        printf("%-*s", columns[col].width, valueStr);
+      }
+      printf("\n");
+    }
+  }
+
+  for(col=0; col<numCols; col++) {
+    columns[col].mean = 0.0;
+    columns[col].m2 = 0.0;
+  }
+}
+/** end of printBlock **/
+
+
+
 int main (int argc, char*argv[]) {
   FILE *traceFile = nullptr;
-  const int bufferLen = 4096;
-  char **colNames;
-  char line[bufferLen], *token,  tempStr[bufferLen];
-  long double *sums;
-  float temp;
-  char delims[] = " \t";
-  int numCols, ancestorNum, i, numLines, count, blockCount;
-  int discardXFromBeginning=0;
-  int blockSize=-1; 
-  char valueLine[bufferLen];
-  char titleLine[bufferLen];
-  char formatStr[bufferLen];
-  double **data;
-
-  unsigned int *width = nullptr;
-  
+  TRACE_READER reader;
+  double *rowValues;
+  int numTokens;
+  COLUMN_STATS *columns;
+  long double value, delta;
+  int numCols, col;
+  long numLines, count, blockCount;
+  long discardXFromBeginning=0;
+  long blockSize=-1;
+  int printStd = 0;
+  int printSummaryOnly = 0;
+  int numThreads = 1;
+  double **samples = nullptr;
+  long sampleCapacity = 0;
+
   int option_index;
   int c;
 
   opterr = 0;
-     
+#ifdef _OPENMP
+  numThreads = omp_get_max_threads();
+#endif
+
   while (1)
     {
       option_index  = 0;
-      c = getopt_long(argc, argv, "b:d:s:ht:", long_options, &option_index);
+      c = getopt_long(argc, argv, "b:d:s:hvSt:", long_options, &option_index);
 
       if (c == -1)
         break;
-           
+
       switch (c)
         {
         case 'b': //Block size
-          blockSize = atoi(optarg);
+          blockSize = atol(optarg);
           break;
         case 'd': //Discard # samples from beginning
-          discardXFromBeginning = atoi(optarg);
+          discardXFromBeginning = atol(optarg);
           break;
 //        case 's': //Subsampling
 //          subSample = atoi(optarg);
 //          break;
+        case 'v': //Print standard deviations
+          printStd = 1;
+          break;
+        case 'S': //Print posterior summary
+          printSummaryOnly = 1;
+          break;
+        case 't': //Number of threads for summary
+          numThreads = atoi(optarg);
+          break;
         case 'h':
           printUsage(argv[0]);
-          printHelp();
           return 0;
           break;
         case '?':
-          if ((optopt == 'b') || (optopt == 'd') || (optopt == 's'))
+          if ((optopt == 'b') || (optopt == 'd') || (optopt == 's') || (optopt == 't'))
             fprintf (stderr, "Option -%c requires an argument.\n", optopt);
           else if (isprint (optopt))
             fprintf (stderr, "Unknown option `-%c'.\n", optopt);
@@ -96,8 +428,8 @@ int main (int argc, char*argv[]) {
           abort ();
         }
     }
-     
-  
+
+
   if(argv[optind] == nullptr) {
     fprintf(stderr, "Missing trace filename.\n");
     printUsage(argv[0]);
@@ -105,7 +437,7 @@ int main (int argc, char*argv[]) {
   }
 
   //Open trace file
-  traceFile = fopen(argv[optind], "r");
+  traceFile = fopen(argv[optind], "rb");
   //Verify trace file was opened successfully
   if(traceFile == nullptr) {
     fprintf(stderr, "Could not find trace file '%s' specified.\n", argv[optind]);
@@ -113,176 +445,114 @@ int main (int argc, char*argv[]) {
     return 1;
   }
 
-  numLines = 0; //Determine number of lines in the file
-  if(nullptr == fgets(line, bufferLen, traceFile))	// discard header
-  {
-    fprintf(stderr, "Unable to discard header of the trace file\n");
-    return -1;
+  //If user didn't specify a block size, then the whole trace is a single block
+  if (blockSize <= 0) {
+    blockSize = LONG_MAX;
   }
-  while(!feof(traceFile))
+
+  //Get column names of trace file (first column is iteration)
+  if(0 != openTraceReader(&reader, traceFile))
   {
-    if(nullptr == fgets(line, bufferLen, traceFile))
-    {
-      fprintf(stderr, "Unable to count lines of the trace file\n");
-      return -1;
-    }
-    numLines++;
-  } 
-  //If user didn't specify a block size, then set the block size to be the number of lines in the file
-  if (blockSize < 0) {
-    blockSize = numLines;
+    fprintf(stderr, "Unable to get the column names of the trace file.\n" );
+    return -1;
   }
-  if(discardXFromBeginning >= numLines) {
-    fprintf(stderr, "%d lines specified to discard, but trace file contains only %d lines.\n", discardXFromBeginning , numLines);
-    return 1;
+  numCols = reader.numColumns - 1;
+  if(numCols <= 0) {
+    fprintf(stderr, "No columns in first line of the trace file.\n" );
+    return -1;
   }
-  fseek(traceFile, 0, SEEK_SET);
-  //Get first line of trace file
-  if(nullptr == fgets(line, bufferLen, traceFile))
-  {
-    fprintf(stderr, "Unable to get the first line of the trace file.\n" );
+  columns = (COLUMN_STATS*)calloc(numCols, sizeof(COLUMN_STATS));
+  rowValues = (double*)malloc(reader.numColumns * sizeof(double));
+  if(columns == nullptr || rowValues == nullptr) {
+    fprintf(stderr, "Out of memory when allocating columns.\n");
     return -1;
   }
-
-  strcpy(tempStr,  line);  
-
-  //Read each entry in the first line of the trace file
-  //  to determine the number of columns
-  token = strtok(line, delims);
-  numCols = 0;
-  while (token != nullptr) {
-//	  printf("column %s.\n",token);
-    numCols++;
-	token = strtok(nullptr, delims);
+  for(col=0; col<numCols; col++) {
+    columns[col].name = reader.names[col+1];
   }
-  // remove first column from considerations
-  numCols--;   
-
-//	printf("Reading trace for file %s with %d columns.\n",argv[optind], numCols);
 
-
-  width = (unsigned int*)malloc(sizeof(int) * numCols);
-  //Allocate space to hold each float from the file
-  data = (double**)malloc(sizeof(double*) * (((numLines-1)/blockSize)+1));
-  for(i=0;i<=((numLines-1)/blockSize);i++) {
-    data[i] = (double*)malloc(sizeof(double) * numCols);
-  }
-  //Allocate space for column names
-  colNames = (char**)malloc(sizeof(char*) * numCols);  
-  //Allocate memory for sums of numbers read in from file
-  sums = (long double*)malloc(sizeof(long double) * numCols);
-
-  if(tempStr[strlen(tempStr)-1] == '\n') //Strip newline off title line
-    tempStr[strlen(tempStr)-1] = ' ';
-
-  //Parse each column name (header) from the line we read in
-  token = strtok(tempStr, delims);
-  token = strtok(nullptr, delims);
-  for(i=0;i<numCols;i++) {
-    colNames[i] = (char*) malloc(sizeof(char) * (strlen(token)+1));
-    strcpy(colNames[i],token);
-	token = strtok(nullptr, delims);
-  }   
-
-  
-  //Discard specified number of samples
-  for(i=0;i<discardXFromBeginning;i++)
-    if(nullptr == fgets(line, bufferLen, traceFile))
-    {
-        fprintf(stderr, "Unable to discard lines.\n");
-    	return -1;
-    }
-  
   //For each line in trace file
+  numLines = 0;
   count = 0;
   blockCount = 0;
-  while (1) {
-    //Get the next line from the file
-    if(nullptr == fgets(line, bufferLen, traceFile))
-    {
-      fprintf(stderr, "Unable to read a lline for the trace file\n");
+  while ((numTokens = readTraceRow(&reader, rowValues)) >= 0) {
+    if(numTokens == 0)
+      continue;
+
+    //Discard specified number of samples
+    numLines++;
+    if(numLines <= discardXFromBeginning)
+      continue;
+
+    if(numTokens - 1 < numCols) {
+      fprintf(stderr, "Line %ld of the trace file has only %d columns.\n", numLines + 1, numTokens - 1);
       return -1;
     }
-    
-    //If we are at the end of the file stop
-    if (feof(traceFile))
-      break;
 
-    token = strtok(line, delims);
-    token = strtok(nullptr, delims);
-    count++;
-    for(ancestorNum=0; ancestorNum < numCols; ancestorNum++) {
-      //Convert next entry to float
-      sscanf(token, "%f", &temp);
-      //Add newly read value to column sum
-      sums[ancestorNum] = sums[ancestorNum] + temp;  
-      if(count == blockSize) {
-        //Format the float as a string
-        sprintf(tempStr, "%.6Lf    ", sums[ancestorNum] / blockSize); 
-        //If this new float (in characters) is longer than any previous, update the width this column will display at
-        if(strlen(tempStr) > width[ancestorNum])
-          width[ancestorNum] = strlen(tempStr);
-        //Save the average we just computed to memory so we can display it later once we know all column widths
-        data[blockCount][ancestorNum] = sums[ancestorNum] / blockSize;
-        //Reset the sums
-        sums[ancestorNum] = 0;
+    //Keep all samples for posterior summary
+    if(printSummaryOnly) {
+      if(count == sampleCapacity) {
+        sampleCapacity = 2 * sampleCapacity + 1024;
+        if(samples == nullptr)
+          samples = (double**)calloc(numCols, sizeof(double*));
+        for(col=0; samples != nullptr && col < numCols; col++) {
+          samples[col] = (double*)realloc(samples[col], sampleCapacity * sizeof(double));
+          if(samples[col] == nullptr)
+            break;
+        }
+        if(samples == nullptr || col < numCols) {
+          fprintf(stderr, "Out of memory when storing %ld samples of trace.\n", count + 1);
+          return -1;
+        }
       }
-      
-      //read in next entry
-      token = strtok(nullptr, delims);
+      for(col=0; col < numCols; col++) {
+        samples[col][count] = rowValues[col+1];
+      }
+      count++;
+      continue;
+    }
+
+    //Update running mean and variance of block for each column
+    count++;
+    for(col=0; col < numCols; col++) {
+      value = rowValues[col+1];
+      delta = value - columns[col].mean;
+      columns[col].mean += delta / count;
+      columns[col].m2 += delta * (value - columns[col].mean);
     }
+
     if(count == blockSize) {
+      printBlock(columns, numCols, count, blockCount == 0, printStd);
       count = 0;
       blockCount++;
     }
-    
-    //Update line number
   }
 
-  //All trace file in memory
-  fclose(traceFile); 
-
-  if(count > 0) {
-    for(ancestorNum=0; ancestorNum < numCols; ancestorNum++) {
-      //Format the float as a string
-      sprintf(tempStr, "%.6Lf    ", sums[ancestorNum] / count); 
-      //If this new float (in characters) is longer than any previous, update the width this column will display at
-      if(strlen(tempStr) > width[ancestorNum]) {
-        width[ancestorNum] = strlen(tempStr);
-        //Save the average we just computed to memory so we can display it later once we know all column widths
-        data[blockCount][ancestorNum] = sums[ancestorNum] / count;
-      }
-    }
-    blockCount++;
+  fclose(traceFile);
+
+  if(numLines <= discardXFromBeginning) {
+    fprintf(stderr, "%ld lines specified to discard, but trace file contains only %ld lines.\n", discardXFromBeginning , numLines);
+    return 1;
   }
 
-  sprintf(valueLine, "%s", "");
-  sprintf(titleLine, "%s", "");
-  //Print results to screen
-    for(i=0; i < blockCount; i++) {
-      for(ancestorNum=0; ancestorNum < numCols; ancestorNum++) {   
-        //Just as before, format the float as a string w/ precision of 6
-        sprintf(tempStr, "%.6f    ", data[i][ancestorNum]); 
-        //Create the format string that takes the column width into account
-        sprintf(formatStr, "%%s%%-%ds", width[ancestorNum]);
-        //Add the float to the string to be printed formatted for the right width
-        sprintf(valueLine, formatStr, valueLine, tempStr);
-        //Add the title to the string to be printed for the right width
-        if(i==0) //Only create the title once
-          sprintf(titleLine, formatStr, titleLine, colNames[ancestorNum]);
-        if((((ancestorNum+1) % 90) == 0) || ancestorNum == numCols-1) {
-          if(i==0)//Only print the title on the first line
-            printf("%s\n", titleLine);
-          printf("%s\n", valueLine); //Print the line of formatted values
-          sprintf(titleLine, "%s", ""); //Clear the titleLine & valueLine strings
-          sprintf(valueLine, "%s", "");
-        }
-      }
+  if(printSummaryOnly) {
+    printSummary(columns, numCols, samples, count, numThreads);
+    for(col=0; col < numCols; col++) {
+      free(samples[col]);
     }
-
+    free(samples);
+  }
+  //Print last (partial) block
+  else if(count > 0) {
+    printBlock(columns, numCols, count, blockCount == 0, printStd);
+    blockCount++;
+  }
 
   printf("\n");
 
+  closeTraceReader(&reader);
+  free(rowValues);
+  free(columns);
 
   //Completed successfully
   return 0;
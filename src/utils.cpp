@@ -212,74 +212,6 @@ void starttime (void)
 }
 
 
-static TIMERS runTimes;
-
-void setStartTimeMethod(enum METHOD_NAME method)
-{
-	time_t tic = time(nullptr);
-	switch(method)
-	{
-		case T_UpdateGB_InternalNode: runTimes.UpdateGB_InternalNode.start = tic; break;
-		case T_UpdateGB_MigrationNode: runTimes.UpdateGB_MigrationNode.start = tic;break;
-		case T_UpdateGB_MigSPR: runTimes.UpdateGB_MigSPR.start = tic;break;
-		case T_UpdateTau: runTimes.UpdateTau.start = tic;break;
-		case T_UpdateMigRates: runTimes.UpdateMigRates.start = tic;break;
-		case T_mixing: runTimes.mixing.start = tic;break;
-		case T_UpdateTheta: runTimes.UpdateTheta.start = tic;break;
-		case T_UpdateSampleAge: runTimes.UpdateSampleAge.start = tic;break;
-		case T_UpdateLocusRate: runTimes.UpdateLocusRate.start = tic;break;
-		case T_MCMCIterations: runTimes.MCMCIterations.start = tic;break;
-	}
-}
-
-void setEndTimeMethod(enum METHOD_NAME method)
-{
-	time_t toc = time(nullptr);
-	switch(method)
-	{
-		case T_UpdateGB_InternalNode: runTimes.UpdateGB_InternalNode.accumulated += (toc - runTimes.UpdateGB_InternalNode.start); break;
-		case T_UpdateGB_MigrationNode: runTimes.UpdateGB_MigrationNode.accumulated += (toc - runTimes.UpdateGB_MigrationNode.start); break;
-		case T_UpdateGB_MigSPR: runTimes.UpdateGB_MigSPR.accumulated += (toc - runTimes.UpdateGB_MigSPR.start); break;
-		case T_UpdateTau: runTimes.UpdateTau.accumulated += (toc - runTimes.UpdateTau.start); break;
-		case T_UpdateMigRates: runTimes.UpdateMigRates.accumulated += (toc - runTimes.UpdateMigRates.start); break;
-		case T_mixing: runTimes.mixing.accumulated += (toc - runTimes.mixing.start); break;
-		case T_UpdateTheta: runTimes.UpdateTheta.accumulated += (toc - runTimes.UpdateTheta.start); break;
-		case T_UpdateSampleAge: runTimes.UpdateSampleAge.accumulated += (toc - runTimes.UpdateSampleAge.start); break;
-		case T_UpdateLocusRate: runTimes.UpdateLocusRate.accumulated += (toc - runTimes.UpdateLocusRate.start); break;
-		case T_MCMCIterations:  runTimes.MCMCIterations.accumulated += (toc - runTimes.MCMCIterations.start); break;
-
-	}
-}
-void printMethodTimes()
-{
-#ifdef RECORD_METHOD_TIMES
-
-	char timeString[STRING_LENGTH];
-	printf("===== METHOD RUN TIME ======\n");
-	printf("UpdateGB_InternalNode (sec):            %s\n", printtime_i(runTimes.UpdateGB_InternalNode.accumulated , timeString));
-	printf("UpdateGB_MigrationNode (sec):           %s\n", printtime_i(runTimes.UpdateGB_MigrationNode.accumulated, timeString));
-	printf("UpdateGB_MigSPR (sec):                  %s\n", printtime_i(runTimes.UpdateGB_MigSPR.accumulated, timeString));
-	printf("UpdateTau (sec):                        %s\n", printtime_i(runTimes.UpdateTau.accumulated, timeString));
-	printf("UpdateMigRates (sec):                   %s\n", printtime_i(runTimes.UpdateMigRates.accumulated, timeString));
-	printf("mixing (sec):                           %s\n", printtime_i(runTimes.mixing.accumulated, timeString));
-	printf("UpdateTheta (sec):                      %s\n", printtime_i(runTimes.UpdateTheta.accumulated, timeString));
-	printf("UpdateSampleAge (sec):                  %s\n", printtime_i(runTimes.UpdateSampleAge.accumulated, timeString));
-	printf("UpdateLocusRate NO MT(sec):             %s\n", printtime_i(runTimes.UpdateLocusRate.accumulated, timeString));
-	time_t total = 0;
-	total += runTimes.UpdateGB_InternalNode.accumulated;
-	total += runTimes.UpdateGB_MigrationNode.accumulated;
-	total += runTimes.UpdateGB_MigSPR.accumulated;
-	total += runTimes.UpdateTau.accumulated;
-	total += runTimes.UpdateMigRates.accumulated;
-	total += runTimes.mixing.accumulated;
-	total += runTimes.UpdateTheta.accumulated;
-	total += runTimes.UpdateSampleAge.accumulated;
-	printf("===== Total in MT Methods:              %s\n" , printtime_i(total, timeString));
-	total += runTimes.UpdateLocusRate.accumulated;
-	printf("===== Total in All MCMCM Methods        %s\n" , printtime_i(total, timeString));
-	printf("===== Total in MCMCM Iterations:        %s\n" , printtime_i(runTimes.MCMCIterations.accumulated, timeString));
-#endif
-}
 char *printtime_i(int t , char timestr[])
 {
 	  int h, m, s;
@@ -89,41 +89,6 @@ extern char parseFileDelims[];
 
 
 
-typedef struct {
-	time_t start;
-	time_t accumulated;
-} TIMER_METHOD;
-typedef struct {
-	TIMER_METHOD UpdateGB_InternalNode;
-	TIMER_METHOD UpdateGB_MigrationNode;
-	TIMER_METHOD UpdateGB_MigSPR;
-	TIMER_METHOD UpdateTau;
-	TIMER_METHOD UpdateMigRates;
-	TIMER_METHOD mixing;
-	TIMER_METHOD UpdateTheta;
-	TIMER_METHOD UpdateSampleAge;
-	TIMER_METHOD UpdateLocusRate;
-	TIMER_METHOD MCMCIterations;
-} TIMERS;
-
-enum METHOD_NAME
-{
-	T_UpdateGB_InternalNode,
-	T_UpdateGB_MigrationNode,
-	T_UpdateGB_MigSPR,
-	T_UpdateTau,
-	T_UpdateMigRates,
-	T_mixing,
-	T_UpdateTheta,
-	T_UpdateSampleAge,
-	T_UpdateLocusRate,
-	T_MCMCIterations
-} ;
-
-
-void setEndTimeMethod(enum METHOD_NAME method);
-void printMethodTimes();
-void setStartTimeMethod(enum METHOD_NAME method);
 char *printtime_i(int t , char timestr[]);
 
 